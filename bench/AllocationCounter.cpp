@@ -0,0 +1,20 @@
+/* AllocationCounter.cpp - replacement global operator new/delete that count allocations */
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Kept in their own translation unit: inlined into a caller next to an
+// allocator's operator new, the free() below reads to GCC as a mismatched
+// new/free pair (-Wmismatched-new-delete).
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+size_t allocationCount() { return g_allocations.load(); }
@@ -0,0 +1,7 @@
+/* AllocationCounter.h - count heap allocations so a bench can report allocations per operation */
+#pragma once
+#include <cstddef>
+
+// Calls to operator new since the program started. Linking AllocationCounter.cpp
+// replaces the global operator new/delete pair for the whole binary.
+size_t allocationCount();
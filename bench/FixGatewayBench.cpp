@@ -0,0 +1,175 @@
+/* FixGatewayBench.cpp - FIX tag parser cost and order throughput over the FIX gateway */
+#include "FixGateway.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Loopback FIX initiator: logs on, then writes batches and counts replies
+class Client {
+public:
+    Client(asio::io_context& io, uint16_t port) : socket_(io) {
+        socket_.connect({asio::ip::make_address("127.0.0.1"), port});
+        socket_.set_option(asio::ip::tcp::no_delay(true));
+        writer_.begin("A", "BENCH", "ENGINE", ++seq_, Order::now());
+        writer_.add(Fix::Tag::EncryptMethod, 0LL);
+        writer_.add(Fix::Tag::HeartBtInt, 0LL);
+        writer_.finish(out_);
+        flush();
+        read(1);
+    }
+
+    void newOrder(const std::string& clOrdId, double price) {
+        writer_.begin("D", "BENCH", "ENGINE", ++seq_, Order::now());
+        writer_.add(Fix::Tag::ClOrdID, clOrdId);
+        writer_.add(Fix::Tag::Symbol, std::string_view("BENCH"));
+        writer_.add(Fix::Tag::Side, '1');
+        writer_.add(Fix::Tag::OrderQty, 1.0);
+        writer_.add(Fix::Tag::OrdType, '2');
+        writer_.add(Fix::Tag::Price, price);
+        writer_.finish(out_);
+    }
+
+    void cancel(const std::string& clOrdId) {
+        writer_.begin("F", "BENCH", "ENGINE", ++seq_, Order::now());
+        writer_.add(Fix::Tag::OrigClOrdID, clOrdId);
+        writer_.add(Fix::Tag::ClOrdID, "x" + clOrdId);
+        writer_.add(Fix::Tag::Symbol, std::string_view("BENCH"));
+        writer_.add(Fix::Tag::Side, '1');
+        writer_.finish(out_);
+    }
+
+    void flush() {
+        asio::write(socket_, asio::buffer(out_));
+        out_.clear();
+    }
+
+    // Read until count complete messages arrived; every one must be an ExecutionReport or the Logon
+    void read(int count) {
+        char buffer[64 * 1024];
+        while (count > 0) {
+            size_t consumed = 0;
+            Fix::ParseStatus status = Fix::parse(in_.data() + used_, in_.size() - used_, message_, consumed);
+            if (status == Fix::ParseStatus::COMPLETE) {
+                if (message_.msgType() != "8" && message_.msgType() != "A") {
+                    std::cerr << "unexpected reply " << message_.msgType() << "\n";
+                    std::exit(1);
+                }
+                used_ += consumed;
+                --count;
+                continue;
+            }
+            in_.erase(0, used_);
+            used_ = 0;
+            in_.append(buffer, socket_.read_some(asio::buffer(buffer)));
+        }
+    }
+
+private:
+    asio::ip::tcp::socket socket_;
+    Fix::MessageWriter writer_;
+    Fix::Message message_;
+    uint32_t seq_ = 0;
+    std::string out_;
+    std::string in_;
+    size_t used_ = 0;
+};
+
+// Far from the market so every order rests and every cancel finds it
+double restingPrice(int i) { return 1.0 + (i % 100) * 0.01; }
+
+// parse + toOrder on a pre-built NewOrderSingle, no socket
+void parserCost(int iterations) {
+    Fix::MessageWriter writer;
+    writer.begin("D", "BENCH", "ENGINE", 42, Order::now());
+    writer.add(Fix::Tag::ClOrdID, std::string_view("order-000042"));
+    writer.add(Fix::Tag::Symbol, std::string_view("BTC-USDT"));
+    writer.add(Fix::Tag::Side, '1');
+    writer.add(Fix::Tag::OrderQty, 0.125);
+    writer.add(Fix::Tag::OrdType, '2');
+    writer.add(Fix::Tag::Price, 64123.5);
+    writer.add(Fix::Tag::TimeInForce, '1');
+    writer.addTime(Fix::Tag::TransactTime, Order::now());
+    std::string wire;
+    writer.finish(wire);
+
+    Fix::Message message;
+    Order order{};
+    size_t consumed = 0;
+    size_t fields = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        Fix::parse(wire.data(), wire.size(), message, consumed);
+        Fix::toOrder(message, order);
+        fields += message.size();
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+    std::cout << "parse + toOrder: " << ns << " ns/message (" << wire.size() << " bytes, "
+              << fields / iterations << " fields)\n";
+}
+
+// One request in flight
+void roundTrips(uint16_t port, int iterations) {
+    asio::io_context io;
+    Client client(io, port);
+    std::vector<double> us;
+    us.reserve(iterations * 2);
+    for (int i = 0; i < iterations; ++i) {
+        std::string clOrdId = "r" + std::to_string(i);
+        for (int step = 0; step < 2; ++step) {
+            if (step == 0) client.newOrder(clOrdId, restingPrice(i));
+            else client.cancel(clOrdId);
+            auto t0 = Clock::now();
+            client.flush();
+            client.read(1);
+            us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+    }
+    std::sort(us.begin(), us.end());
+    auto at = [&](double p) { return us[std::min(us.size() - 1, static_cast<size_t>(p * us.size()))]; };
+    std::cout << "FIX round trip: p50=" << at(0.50) << " p90=" << at(0.90) << " p99=" << at(0.99)
+              << " max=" << us.back() << " us (" << us.size() << " round trips)\n";
+}
+
+// Pipelined: windows of NewOrderSingle + cancel written back to back
+void pipelined(uint16_t port, int iterations, int window) {
+    asio::io_context io;
+    Client client(io, port);
+    auto start = Clock::now();
+    for (int base = 0; base < iterations; base += window) {
+        int n = std::min(window, iterations - base);
+        for (int i = 0; i < n; ++i) {
+            std::string clOrdId = "p" + std::to_string(base + i);
+            client.newOrder(clOrdId, restingPrice(base + i));
+            client.cancel(clOrdId);
+        }
+        client.flush();
+        client.read(2 * n);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "FIX pipelined (window " << window << "): "
+              << static_cast<long long>(2 * iterations / seconds) << " requests/sec\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+    parserCost(iterations * 50);
+
+    EngineConfig config;
+    config.journalFile.clear();
+    config.consoleLogging = false;
+    MatchingEngine engine(config);
+    FixGateway gateway(engine, 0);
+    roundTrips(gateway.port(), iterations);
+    pipelined(gateway.port(), iterations, 64);
+    return 0;
+}
@@ -0,0 +1,82 @@
+/* LoggerBench.cpp - caller-side cost of a log line: std::cout + std::endl vs the async logger */
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::ostream report(std::cout.rdbuf());   // stays on the terminal while std::cout is redirected
+
+// Times every call; the sink work left after the loop is reported separately
+template<typename Fn>
+void run(const char* name, int iterations, Fn&& fn, void (*drain)()) {
+    std::vector<double> ns;
+    ns.reserve(iterations);
+    std::string orderId = "client-order-100000";
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = Clock::now();
+        fn(orderId, i);
+        ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+    }
+    auto callerDone = Clock::now();
+    drain();
+    double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    double drainMs = std::chrono::duration<double, std::milli>(Clock::now() - callerDone).count();
+    std::sort(ns.begin(), ns.end());
+    auto at = [&](double p) { return ns[std::min(ns.size() - 1, static_cast<size_t>(p * ns.size()))]; };
+    report << name << ": p50=" << at(0.50) << " p99=" << at(0.99) << " p99.9=" << at(0.999)
+              << " ns/call, total " << totalMs << " ms (" << drainMs << " ms draining after the loop)\n";
+}
+
+void noDrain() {}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    report << "Iterations: " << iterations << " (a submitOrder-sized line each)\n";
+
+    // The previous submitOrder logging, with stdout redirected to a file
+    {
+        std::ofstream file("logger_bench_cout.log");
+        auto* saved = std::cout.rdbuf(file.rdbuf());
+        run("std::cout + std::endl", iterations, [](const std::string& orderId, int i) {
+            std::cout << "=== SUBMIT ORDER ===" << std::endl;
+            std::cout << "Order: " << orderId << " BTC-USDT BUY " << 0.001 * (i % 100 + 1)
+                      << "@" << 46000.5 + i % 50 << std::endl;
+        }, noDrain);
+        std::cout.rdbuf(saved);
+    }
+
+    LogConfig text;
+    text.console = false;
+    text.textFile = "logger_bench.log";
+    text.ringBytes = 64 << 20;   // hold the whole run, so nothing is dropped
+    Log::configure(text);
+    run("LOG_INFO -> text file  ", iterations, [](const std::string& orderId, int i) {
+        LOG_INFO("SUBMIT ORDER {} {} {} {}@{}", orderId, "BTC-USDT", "BUY", 0.001 * (i % 100 + 1), 46000.5 + i % 50);
+    }, Log::flush);
+
+    LogConfig binary = text;
+    binary.textFile.clear();
+    binary.binaryFile = "logger_bench.bin";
+    Log::configure(binary);
+    run("LOG_INFO -> binary file", iterations, [](const std::string& orderId, int i) {
+        LOG_INFO("SUBMIT ORDER {} {} {} {}@{}", orderId, "BTC-USDT", "BUY", 0.001 * (i % 100 + 1), 46000.5 + i % 50);
+    }, Log::flush);
+
+    report << "Dropped: " << Log::dropped() << "\n";
+    std::remove("logger_bench_cout.log");
+    std::remove("logger_bench.log");
+    std::remove("logger_bench.bin");
+    return 0;
+}
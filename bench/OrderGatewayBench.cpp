@@ -0,0 +1,402 @@
+/* OrderGatewayBench.cpp - order round trip over shared memory vs the binary gateway vs HTTP/JSON vs /ws/orders */
+#include "MarketDataServer.h"
+#include "OrderGateway.h"
+#include "ShmGateway.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Swallows the server's per-request console tracing while the HTTP path is measured
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+void report(const char* name, std::vector<double>& us) {
+    std::sort(us.begin(), us.end());
+    auto at = [&](double p) { return us[std::min(us.size() - 1, static_cast<size_t>(p * us.size()))]; };
+    std::cout << name << ": p50=" << at(0.50) << " p90=" << at(0.90) << " p99=" << at(0.99)
+              << " max=" << us.back() << " us (" << us.size() << " round trips)\n";
+}
+
+std::string readMessage(asio::ip::tcp::socket& socket) {
+    std::string message(OrderEntry::kHeaderSize, '\0');
+    asio::read(socket, asio::buffer(&message[0], message.size()));
+    message.resize(OrderEntry::decodeHeader(message.data()).length);
+    asio::read(socket, asio::buffer(&message[OrderEntry::kHeaderSize],
+                                    message.size() - OrderEntry::kHeaderSize));
+    return message;
+}
+
+Order restingOrder(int i) {
+    // Far from the market so every order rests and every cancel finds it
+    return Order{"g" + std::to_string(i), "BENCH", Side::BUY, OrderType::LIMIT,
+                 1.0 + (i % 100) * 0.01, 0.0, 1.0, 0.0, 0};
+}
+
+// One request in flight: new, wait for the ack, cancel, wait for the ack
+void gatewayRoundTrips(uint16_t port, int iterations) {
+    asio::io_context io;
+    asio::ip::tcp::socket socket(io);
+    socket.connect({asio::ip::make_address("127.0.0.1"), port});
+    socket.set_option(asio::ip::tcp::no_delay(true));
+
+    std::vector<double> us;
+    us.reserve(iterations * 2);
+    std::string out;
+    uint32_t seq = 0;
+    for (int i = 0; i < iterations; ++i) {
+        Order order = restingOrder(i);
+        for (int step = 0; step < 2; ++step) {
+            out.clear();
+            if (step == 0) OrderEntry::encodeNewOrder(out, ++seq, order);
+            else OrderEntry::encodeCancel(out, ++seq, order.orderId);
+            auto t0 = Clock::now();
+            asio::write(socket, asio::buffer(out));
+            readMessage(socket);
+            us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+    }
+    report("binary gateway round trip", us);
+}
+
+// Pipelined: windows of requests written back to back, then all acks read
+void gatewayPipelined(uint16_t port, int iterations, int window) {
+    asio::io_context io;
+    asio::ip::tcp::socket socket(io);
+    socket.connect({asio::ip::make_address("127.0.0.1"), port});
+    socket.set_option(asio::ip::tcp::no_delay(true));
+
+    std::string out;
+    uint32_t seq = 0;
+    auto start = Clock::now();
+    for (int base = 0; base < iterations; base += window) {
+        out.clear();
+        int n = std::min(window, iterations - base);
+        for (int i = 0; i < n; ++i) {
+            Order order = restingOrder(1000000 + base + i);
+            OrderEntry::encodeNewOrder(out, ++seq, order);
+            OrderEntry::encodeCancel(out, ++seq, order.orderId);
+        }
+        asio::write(socket, asio::buffer(out));
+        for (int i = 0; i < 2 * n; ++i) readMessage(socket);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "binary gateway pipelined (window " << window << "): "
+              << static_cast<long long>(2 * iterations / seconds) << " requests/sec\n";
+}
+
+// Wait for the next reply on a shared-memory session, yielding now and then so a
+// gateway on the same core can run
+void shmReceive(ShmTransport::Client& client) {
+    for (unsigned spins = 1; client.poll() == nullptr; ++spins) {
+        if (spins % 64 == 0) std::this_thread::yield();
+    }
+    client.pop();
+}
+
+// One request in flight: new, wait for the ack, cancel, wait for the ack
+void shmRoundTrips(const std::string& name, int iterations) {
+    ShmTransport::Client client(name);
+    std::vector<double> us;
+    us.reserve(iterations * 2);
+    std::string out;
+    uint32_t seq = 0;
+    for (int i = 0; i < iterations; ++i) {
+        Order order = restingOrder(5000000 + i);
+        for (int step = 0; step < 2; ++step) {
+            out.clear();
+            if (step == 0) OrderEntry::encodeNewOrder(out, ++seq, order);
+            else OrderEntry::encodeCancel(out, ++seq, order.orderId);
+            auto t0 = Clock::now();
+            client.send(out);
+            shmReceive(client);
+            us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+    }
+    report("shared-memory round trip", us);
+}
+
+void shmPipelined(const std::string& name, int iterations, int window) {
+    ShmTransport::Client client(name);
+    std::string out;
+    uint32_t seq = 0;
+    auto start = Clock::now();
+    for (int base = 0; base < iterations; base += window) {
+        int n = std::min(window, iterations - base);
+        for (int i = 0; i < n; ++i) {
+            Order order = restingOrder(6000000 + base + i);
+            out.clear();
+            OrderEntry::encodeNewOrder(out, ++seq, order);
+            client.send(out);
+            out.clear();
+            OrderEntry::encodeCancel(out, ++seq, order.orderId);
+            client.send(out);
+        }
+        for (int i = 0; i < 2 * n; ++i) shmReceive(client);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "shared-memory pipelined (window " << window << "): "
+              << static_cast<long long>(2 * iterations / seconds) << " requests/sec\n";
+}
+
+// Keep-alive HTTP/1.1 client connection
+class HttpClient {
+public:
+    HttpClient(asio::io_context& io, uint16_t port) : socket_(io) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            asio::error_code ec;
+            socket_.connect({asio::ip::make_address("127.0.0.1"), port}, ec);
+            if (!ec) break;
+            socket_.close();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        socket_.set_option(asio::ip::tcp::no_delay(true));
+    }
+
+    // Send one request, then read headers and exactly Content-Length body bytes
+    void exchange(const std::string& request) {
+        asio::write(socket_, asio::buffer(request));
+        response_.clear();
+        size_t headerEnd;
+        while ((headerEnd = response_.find("\r\n\r\n")) == std::string::npos) {
+            response_.append(buffer_, socket_.read_some(asio::buffer(buffer_)));
+        }
+        size_t lengthAt = response_.find("Content-Length: ");
+        size_t length = lengthAt == std::string::npos ? 0 : std::stoul(response_.substr(lengthAt + 16));
+        while (response_.size() < headerEnd + 4 + length) {
+            response_.append(buffer_, socket_.read_some(asio::buffer(buffer_)));
+        }
+    }
+
+private:
+    asio::ip::tcp::socket socket_;
+    std::string response_;
+    char buffer_[4096];
+};
+
+std::string postOrder(const Order& order) {
+    std::string body = "{\"order_id\":\"" + order.orderId + "\",\"symbol\":\"" + order.symbol + "\",\"side\":\""
+                       + (order.side == Side::BUY ? "buy" : "sell") + "\",\"order_type\":\"limit\",\"quantity\":1,"
+                       "\"price\":" + std::to_string(order.price) + "}";
+    return "POST /orders HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+// POST /orders then DELETE /orders/<id>
+std::vector<double> httpRoundTrips(uint16_t port, int iterations) {
+    asio::io_context io;
+    HttpClient client(io, port);
+    std::vector<double> us;
+    us.reserve(iterations * 2);
+    for (int i = 0; i < iterations; ++i) {
+        Order order = restingOrder(2000000 + i);
+        for (int step = 0; step < 2; ++step) {
+            auto t0 = Clock::now();
+            if (step == 0) client.exchange(postOrder(order));
+            else client.exchange("DELETE /orders/" + order.orderId + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+            us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+    }
+    return us;
+}
+
+// /ws/orders client: masked text frames out, unfragmented frames in
+class WsClient {
+public:
+    WsClient(asio::io_context& io, uint16_t port) : socket_(io) {
+        socket_.connect({asio::ip::make_address("127.0.0.1"), port});
+        socket_.set_option(asio::ip::tcp::no_delay(true));
+        asio::write(socket_, asio::buffer(std::string(
+            "GET /ws/orders HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n")));
+        size_t end;
+        while ((end = buffer_.find("\r\n\r\n")) == std::string::npos) fill();
+        buffer_.erase(0, end + 4);
+    }
+
+    // Frame text onto out (zero mask key, so the payload goes out as is)
+    static void frame(std::string& out, const std::string& text) {
+        out.push_back('\x81');
+        if (text.size() < 126) {
+            out.push_back(static_cast<char>(0x80 | text.size()));
+        } else {
+            out.push_back(static_cast<char>(0x80 | 126));
+            out.push_back(static_cast<char>(text.size() >> 8));
+            out.push_back(static_cast<char>(text.size() & 0xff));
+        }
+        out.append(4, '\0');
+        out.append(text);
+    }
+
+    void write(const std::string& frames) { asio::write(socket_, asio::buffer(frames)); }
+
+    // Skip one frame
+    void receive() {
+        need(2);
+        size_t length = static_cast<unsigned char>(buffer_[1]) & 0x7f;
+        size_t header = 2;
+        if (length == 126) {
+            need(4);
+            length = (static_cast<unsigned char>(buffer_[2]) << 8) | static_cast<unsigned char>(buffer_[3]);
+            header = 4;
+        }
+        need(header + length);
+        buffer_.erase(0, header + length);
+    }
+
+private:
+    void fill() { buffer_.append(chunk_, socket_.read_some(asio::buffer(chunk_))); }
+    void need(size_t n) {
+        while (buffer_.size() < n) fill();
+    }
+
+    asio::ip::tcp::socket socket_;
+    std::string buffer_;
+    char chunk_[65536];
+};
+
+std::string wsNewOrder(const Order& order, int reqId) {
+    return "{\"op\":\"new\",\"req_id\":" + std::to_string(reqId) + ",\"order_id\":\"" + order.orderId
+           + "\",\"symbol\":\"" + order.symbol + "\",\"side\":\"buy\",\"order_type\":\"limit\",\"quantity\":1,"
+           "\"price\":" + std::to_string(order.price) + "}";
+}
+
+std::string wsCancel(const Order& order, int reqId) {
+    return "{\"op\":\"cancel\",\"req_id\":" + std::to_string(reqId) + ",\"order_id\":\"" + order.orderId + "\"}";
+}
+
+// One request in flight on an order session: new, wait for the ack, cancel, wait for the ack
+std::vector<double> wsRoundTrips(uint16_t port, int iterations) {
+    asio::io_context io;
+    WsClient client(io, port);
+    std::vector<double> us;
+    us.reserve(iterations * 2);
+    std::string out;
+    int reqId = 0;
+    for (int i = 0; i < iterations; ++i) {
+        Order order = restingOrder(3000000 + i);
+        for (int step = 0; step < 2; ++step) {
+            out.clear();
+            WsClient::frame(out, step == 0 ? wsNewOrder(order, ++reqId) : wsCancel(order, ++reqId));
+            auto t0 = Clock::now();
+            client.write(out);
+            client.receive();
+            us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+    }
+    return us;
+}
+
+// Pipelined on one order session, against one request at a time over keep-alive HTTP
+void wsPipelined(uint16_t port, int iterations, int window) {
+    asio::io_context io;
+    WsClient client(io, port);
+    std::string out;
+    int reqId = 0;
+    auto start = Clock::now();
+    for (int base = 0; base < iterations; base += window) {
+        out.clear();
+        int n = std::min(window, iterations - base);
+        for (int i = 0; i < n; ++i) {
+            Order order = restingOrder(4000000 + base + i);
+            WsClient::frame(out, wsNewOrder(order, ++reqId));
+            WsClient::frame(out, wsCancel(order, ++reqId));
+        }
+        client.write(out);
+        for (int i = 0; i < 2 * n; ++i) client.receive();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "/ws/orders pipelined (window " << window << "): "
+              << static_cast<long long>(2 * iterations / seconds) << " requests/sec\n";
+}
+
+// Matching slowed to ~1 ms per fill while writers keep crossing orders in flight:
+// GET /health latency shows whether HTTP workers are stuck behind the engine
+void httpUnderSlowMatching(uint16_t port, int writers, int probes) {
+    std::atomic<bool> done{false};
+    std::atomic<long long> posted{0};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w] {
+            asio::io_context io;
+            HttpClient client(io, port);
+            for (int i = 0; !done; ++i) {
+                Order order{"slow-" + std::to_string(w) + "-" + std::to_string(i), "SLOW",
+                            i % 2 ? Side::SELL : Side::BUY, OrderType::LIMIT, 100.0, 0.0, 1.0, 0.0, 0};
+                client.exchange(postOrder(order));
+                ++posted;
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    asio::io_context io;
+    HttpClient probe(io, port);
+    std::vector<double> us;
+    auto start = Clock::now();
+    for (int i = 0; i < probes; ++i) {
+        auto t0 = Clock::now();
+        probe.exchange("GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    done = true;
+    for (auto& t : threads) t.join();
+    report("GET /health under slow matching", us);
+    std::cout << "  (" << writers << " writers, " << static_cast<long long>(posted / seconds) << " orders/sec)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+    EngineConfig config;
+    config.journalFile.clear();
+    config.consoleLogging = false;
+    MatchingEngine engine(config);
+
+    // Gateways subscribe to the trade feed, so they live as long as the engine
+    ShmGatewayConfig shm;
+    shm.name = "me_bench_" + std::to_string(getpid());
+    ShmGateway shmGateway(engine, shm);
+    shmRoundTrips(shm.name, iterations);
+    shmPipelined(shm.name, iterations, 64);
+
+    OrderGateway gateway(engine, 0);
+    gatewayRoundTrips(gateway.port(), iterations);
+    gatewayPipelined(gateway.port(), iterations, 64);
+
+    crow::logger::setLogLevel(crow::LogLevel::Warning);
+    NullBuffer null;
+    std::streambuf* console = std::cout.rdbuf(&null);
+    MarketDataServer server(engine, 18090);
+    std::thread serverThread([&]() { server.run(); });
+    auto httpUs = httpRoundTrips(18090, iterations / 4);
+    auto wsUs = wsRoundTrips(18090, iterations / 4);
+    std::cout.rdbuf(console);
+    report("HTTP/JSON round trip", httpUs);
+    report("/ws/orders round trip", wsUs);
+    wsPipelined(18090, iterations, 64);
+
+    engine.tradeFeed().subscribe([](const TradeReport&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    httpUnderSlowMatching(18090, 8, 200);
+    server.stop();
+    serverThread.join();
+    return 0;
+}
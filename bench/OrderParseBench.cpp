@@ -0,0 +1,72 @@
+/* OrderParseBench.cpp - POST /orders body parsing: nlohmann::json DOM vs OrderJsonParser */
+#include "OrderJsonParser.h"
+#include "AllocationCounter.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The previous handler: full DOM, then body.at() per field
+void domParse(const std::string& text, Order& order) {
+    auto body = nlohmann::json::parse(text);
+    order.orderId = body.at("order_id").get<std::string>();
+    order.symbol = body.at("symbol").get<std::string>();
+    order.side = (body.at("side").get<std::string>() == "buy" ? Side::BUY : Side::SELL);
+    std::string typeStr = body.at("order_type").get<std::string>();
+    if (typeStr == "market") order.type = OrderType::MARKET;
+    else if (typeStr == "limit") order.type = OrderType::LIMIT;
+    else if (typeStr == "ioc") order.type = OrderType::IOC;
+    else if (typeStr == "fok") order.type = OrderType::FOK;
+    else throw std::invalid_argument("Invalid order_type: " + typeStr);
+    order.quantity = body.at("quantity").get<double>();
+    order.price = body.value("price", 0.0);
+}
+
+template<typename Fn>
+void run(const char* name, const std::vector<std::string>& bodies, int iterations, Fn&& fn) {
+    double checksum = 0.0;
+    size_t allocsBefore = allocationCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        Order order{};   // fresh per request, as in the handler
+        fn(bodies[i % bodies.size()], order);
+        checksum += order.quantity;
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    size_t allocs = allocationCount() - allocsBefore;
+    std::cout << name << ": " << ns / iterations << " ns/order, "
+              << static_cast<double>(allocs) / iterations << " allocs/order"
+              << " (quantity sum " << checksum << ")\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 500000;
+
+    // Typical bodies; ids longer than the small-string buffer, as client ids usually are
+    std::vector<std::string> bodies;
+    const char* symbols[] = {"BTC-USDT", "ETH-USDT", "SOL-USDT"};
+    for (int i = 0; i < 64; ++i) {
+        bodies.push_back(R"({"order_id":"client-order-)" + std::to_string(100000 + i) + R"(","symbol":")"
+                         + symbols[i % 3] + R"(","side":")" + (i % 2 ? "sell" : "buy")
+                         + R"(","order_type":"limit","quantity":)" + std::to_string(0.001 * (i + 1))
+                         + R"(,"price":)" + std::to_string(46000.5 + i) + "}");
+    }
+
+    OrderJsonParser parser;
+    OrderParseError error;
+    std::cout << "Iterations: " << iterations << ", body: " << bodies[0] << "\n";
+    run("nlohmann DOM + at() ", bodies, iterations, [](const std::string& body, Order& order) {
+        domParse(body, order);
+    });
+    run("OrderJsonParser     ", bodies, iterations, [&](const std::string& body, Order& order) {
+        if (!parser.parse(body, order, error)) std::abort();
+    });
+    return 0;
+}
@@ -0,0 +1,123 @@
+/* SerializationBench.cpp - nlohmann::json DOM vs hand-written JSON vs binary market-data encodings */
+#include "MarketDataSerializer.h"
+#include "BinaryCodec.h"
+#include "AllocationCounter.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// The previous broadcast path: one DOM per delta, std::to_string per number
+std::string domL2Delta(const L2Delta& delta) {
+    nlohmann::json json = {
+        {"type", "l2_delta"},
+        {"timestamp", std::to_string(delta.timestamp)},
+        {"symbol", delta.symbol},
+        {"seq", std::to_string(delta.seq)},
+        {"first_seq", std::to_string(delta.seq)},
+        {"changes", nlohmann::json::array()}
+    };
+    for (const auto& level : delta.changes) {
+        json["changes"].push_back({
+            {"side", level.side == Side::BUY ? "bid" : "ask"},
+            {"price", std::to_string(level.price)},
+            {"quantity", std::to_string(level.quantity)}
+        });
+    }
+    return json.dump();
+}
+
+template<typename Fn>
+void run(const char* name, int iterations, Fn&& fn) {
+    size_t bytes = 0;
+    size_t allocsBefore = allocationCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) bytes += fn(i);
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    size_t allocs = allocationCount() - allocsBefore;
+    std::cout << name << ": " << ns / iterations << " ns/msg, "
+              << static_cast<double>(allocs) / iterations << " allocs/msg, "
+              << bytes / iterations << " bytes/msg\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    TradeReport trade("BTC-USDT", "T123456", 46000.5, 0.00000123, 0.0000565, 0.000113,
+                      "BUY", "maker-order-0001", "taker-order-0002", 1700000000123LL);
+
+    L2Delta delta{"BTC-USDT", 42, 1700000000123LL, {}};
+    for (int i = 0; i < 10; ++i) {
+        delta.changes.push_back({i % 2 ? Side::SELL : Side::BUY, 46000.0 + i * 0.5, 0.125 * (i + 1)});
+    }
+
+    std::string buffer;
+    buffer.reserve(4096);
+
+    std::cout << "Iterations: " << iterations << "\n";
+    run("trade   nlohmann DOM ", iterations, [&](int) {
+        return trade.toJson().dump().size();
+    });
+    run("trade   serializer   ", iterations, [&](int) {
+        buffer.clear();
+        MarketDataSerializer::appendTrade(buffer, trade);
+        return buffer.size();
+    });
+    run("trade   binary encode", iterations, [&](int) {
+        buffer.clear();
+        BinaryCodec::encodeTrade(buffer, trade);
+        return buffer.size();
+    });
+    run("l2delta nlohmann DOM ", iterations, [&](int) {
+        return domL2Delta(delta).size();
+    });
+    run("l2delta serializer   ", iterations, [&](int) {
+        buffer.clear();
+        MarketDataSerializer::appendL2Delta(buffer, delta.symbol, delta.seq, delta.seq,
+                                            delta.timestamp, delta.changes);
+        return buffer.size();
+    });
+    run("l2delta binary encode", iterations, [&](int) {
+        buffer.clear();
+        BinaryCodec::encodeL2Delta(buffer, delta.symbol, delta.seq, delta.seq,
+                                   delta.timestamp, delta.changes);
+        return buffer.size();
+    });
+
+    // Client side: what a consumer pays to turn a frame back into values
+    std::string tradeJson, tradeBinary, deltaJson, deltaBinary;
+    MarketDataSerializer::appendTrade(tradeJson, trade);
+    BinaryCodec::encodeTrade(tradeBinary, trade);
+    MarketDataSerializer::appendL2Delta(deltaJson, delta.symbol, delta.seq, delta.seq,
+                                        delta.timestamp, delta.changes);
+    BinaryCodec::encodeL2Delta(deltaBinary, delta.symbol, delta.seq, delta.seq,
+                               delta.timestamp, delta.changes);
+    TradeReport decodedTrade;
+    L2Delta decodedDelta;
+    run("trade   json parse   ", iterations, [&](int) {
+        auto json = nlohmann::json::parse(tradeJson);
+        return static_cast<size_t>(std::stod(json["price"].get<std::string>()) > 0) * tradeJson.size();
+    });
+    run("trade   binary decode", iterations, [&](int) {
+        BinaryCodec::decodeTrade(tradeBinary.data(), tradeBinary.size(), decodedTrade);
+        return tradeBinary.size();
+    });
+    run("l2delta json parse   ", iterations, [&](int) {
+        auto json = nlohmann::json::parse(deltaJson);
+        size_t levels = 0;
+        for (const auto& level : json["changes"]) {
+            levels += std::stod(level["quantity"].get<std::string>()) > 0;
+        }
+        return levels > 0 ? deltaJson.size() : 0;
+    });
+    run("l2delta binary decode", iterations, [&](int) {
+        BinaryCodec::decodeL2Delta(deltaBinary.data(), deltaBinary.size(), decodedDelta);
+        return deltaBinary.size();
+    });
+    return 0;
+}
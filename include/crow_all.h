@@ -13294,6 +13294,10 @@ namespace crow
             adaptor_.start([self](const error_code& ec) {
                 if (!ec)
                 {
+                    // Deferred responses are written outside the read handler, where Nagle
+                    // can hold the tail of a response for the peer's delayed ACK (~40ms)
+                    error_code ignored;
+                    self->adaptor_.raw_socket().set_option(asio::ip::tcp::no_delay(true), ignored);
                     self->start_deadline();
                     self->parser_.clear();
 
@@ -13415,6 +13419,10 @@ namespace crow
         /// Call the after handle middleware and send the write the response to the connection.
         void complete_request()
         {
+            // A deferred response (res.end() called after the handler returned) reaches
+            // here through complete_request_handler_, whose captured pointer may be the
+            // last owner; prepare_buffers() resets that handler, so hold our own.
+            auto self = this->shared_from_this();
             CROW_LOG_INFO << "Response: " << this << ' ' << req_.raw_url << ' ' << res.code << ' ' << close_connection_;
             res.is_alive_helper_ = nullptr;
 
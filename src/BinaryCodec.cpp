@@ -0,0 +1,352 @@
+#include "BinaryCodec.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint16_t kTradeBlock = 41;
+constexpr uint16_t kDeltaBlock = 24;
+constexpr uint16_t kDeltaEntry = 17;
+constexpr uint16_t kSnapshotBlock = 16;
+constexpr uint16_t kSnapshotEntry = 16;
+constexpr uint16_t kL3Block = 42;
+constexpr uint16_t kBatchBlock = 9;
+constexpr uint16_t kFillEntry = 40;
+constexpr uint16_t kGapBlock = 8;
+
+// ---- little-endian writers ----
+
+void putU8(std::string& out, uint8_t v) { out.push_back(static_cast<char>(v)); }
+
+void putU16(std::string& out, uint16_t v) {
+    char b[2] = {static_cast<char>(v), static_cast<char>(v >> 8)};
+    out.append(b, 2);
+}
+
+void putU64(std::string& out, uint64_t v) {
+    char b[8];
+    for (int i = 0; i < 8; ++i) b[i] = static_cast<char>(v >> (8 * i));
+    out.append(b, 8);
+}
+
+void putI64(std::string& out, long long v) { putU64(out, static_cast<uint64_t>(v)); }
+
+void putF64(std::string& out, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    putU64(out, bits);
+}
+
+void putVarData(std::string& out, const std::string& s) {
+    size_t n = std::min<size_t>(s.size(), 255);
+    putU8(out, static_cast<uint8_t>(n));
+    out.append(s.data(), n);
+}
+
+void putHeader(std::string& out, uint16_t blockLength, uint16_t templateId) {
+    putU16(out, blockLength);
+    putU16(out, templateId);
+    putU16(out, BinaryCodec::kSchemaId);
+    putU16(out, BinaryCodec::kSchemaVersion);
+}
+
+// ---- bounds-checked little-endian reader ----
+
+class Cursor {
+public:
+    Cursor(const char* data, size_t size)
+        : p_(reinterpret_cast<const uint8_t*>(data)), end_(p_ + size) {}
+
+    bool ok() const { return ok_; }
+    const uint8_t* pos() const { return p_; }
+
+    bool skip(size_t n) {
+        if (!ok_ || static_cast<size_t>(end_ - p_) < n) return ok_ = false;
+        p_ += n;
+        return true;
+    }
+
+    uint8_t u8() {
+        const uint8_t* at = p_;
+        return skip(1) ? at[0] : 0;
+    }
+
+    uint16_t u16() {
+        const uint8_t* at = p_;
+        return skip(2) ? static_cast<uint16_t>(at[0] | (at[1] << 8)) : 0;
+    }
+
+    uint64_t u64() {
+        const uint8_t* at = p_;
+        if (!skip(8)) return 0;
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(at[i]) << (8 * i);
+        return v;
+    }
+
+    long long i64() { return static_cast<long long>(u64()); }
+
+    double f64() {
+        uint64_t bits = u64();
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    std::string varData() {
+        uint8_t n = u8();
+        const uint8_t* at = p_;
+        if (!skip(n)) return {};
+        return std::string(reinterpret_cast<const char*>(at), n);
+    }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool ok_ = true;
+};
+
+// Reads the header; returns the root block length, 0 when the header doesn't match
+uint16_t readHeader(Cursor& c, uint16_t expectedTemplate, uint16_t minBlock) {
+    uint16_t blockLength = c.u16();
+    uint16_t templateId = c.u16();
+    uint16_t schemaId = c.u16();
+    c.u16();   // version: older decoders read newer messages via blockLength
+    if (!c.ok() || templateId != expectedTemplate || schemaId != BinaryCodec::kSchemaId
+        || blockLength < minBlock) {
+        return 0;
+    }
+    return blockLength;
+}
+
+} // namespace
+
+namespace BinaryCodec {
+
+void encodeTrade(std::string& out, const TradeReport& trade) {
+    putHeader(out, kTradeBlock, TRADE);
+    putI64(out, trade.timestamp);
+    putF64(out, trade.price);
+    putF64(out, trade.quantity);
+    putF64(out, trade.makerFee);
+    putF64(out, trade.takerFee);
+    putU8(out, trade.aggressor == "SELL" ? 1 : 0);
+    putVarData(out, trade.symbol);
+    putVarData(out, trade.tradeId);
+    putVarData(out, trade.makerOrderId);
+    putVarData(out, trade.takerOrderId);
+}
+
+void encodeL2Delta(std::string& out, const std::string& symbol, uint64_t firstSeq, uint64_t seq,
+                   long long timestamp, const std::vector<L2Level>& changes) {
+    putHeader(out, kDeltaBlock, L2_DELTA);
+    putU64(out, seq);
+    putU64(out, firstSeq);
+    putI64(out, timestamp);
+    size_t count = std::min<size_t>(changes.size(), UINT16_MAX);
+    putU16(out, kDeltaEntry);
+    putU16(out, static_cast<uint16_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        putF64(out, changes[i].price);
+        putF64(out, changes[i].quantity);
+        putU8(out, changes[i].side == Side::BUY ? 0 : 1);
+    }
+    putVarData(out, symbol);
+}
+
+void encodeL2Snapshot(std::string& out, const L2Update& update) {
+    putHeader(out, kSnapshotBlock, L2_SNAPSHOT);
+    putU64(out, update.seq);
+    putI64(out, update.timestamp);
+    for (const auto* side : {&update.bids, &update.asks}) {
+        size_t count = std::min<size_t>(side->size(), UINT16_MAX);
+        putU16(out, kSnapshotEntry);
+        putU16(out, static_cast<uint16_t>(count));
+        for (size_t i = 0; i < count; ++i) {
+            putF64(out, (*side)[i].first);
+            putF64(out, (*side)[i].second);
+        }
+    }
+    putVarData(out, update.symbol);
+}
+
+void encodeL3Event(std::string& out, const L3Event& event) {
+    putHeader(out, kL3Block, L3_EVENT);
+    putU64(out, event.seq);
+    putI64(out, event.timestamp);
+    putF64(out, event.price);
+    putF64(out, event.quantity);
+    putF64(out, event.execQty);
+    putU8(out, static_cast<uint8_t>(event.type));
+    putU8(out, event.side == Side::BUY ? 0 : 1);
+    putVarData(out, event.symbol);
+    putVarData(out, event.orderId);
+    putVarData(out, event.tradeId);
+}
+
+void encodeExecutionBatch(std::string& out, const ExecutionBatch& batch) {
+    putHeader(out, kBatchBlock, EXECUTION_BATCH);
+    putI64(out, batch.timestamp);
+    putU8(out, batch.aggressor == "SELL" ? 1 : 0);
+    size_t count = std::min<size_t>(batch.fills.size(), UINT16_MAX);
+    putU16(out, kFillEntry);
+    putU16(out, static_cast<uint16_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        const TradeReport& fill = batch.fills[i];
+        putI64(out, fill.timestamp);
+        putF64(out, fill.price);
+        putF64(out, fill.quantity);
+        putF64(out, fill.makerFee);
+        putF64(out, fill.takerFee);
+        putVarData(out, fill.tradeId);
+        putVarData(out, fill.makerOrderId);
+    }
+    putVarData(out, batch.symbol);
+    putVarData(out, batch.takerOrderId);
+}
+
+void encodeGap(std::string& out, uint64_t dropped) {
+    putHeader(out, kGapBlock, GAP);
+    putU64(out, dropped);
+}
+
+uint16_t templateId(const char* data, size_t size) {
+    Cursor c(data, size);
+    c.u16();
+    uint16_t id = c.u16();
+    uint16_t schemaId = c.u16();
+    return (c.ok() && schemaId == kSchemaId) ? id : 0;
+}
+
+bool decodeTrade(const char* data, size_t size, TradeReport& trade) {
+    Cursor c(data, size);
+    uint16_t block = readHeader(c, TRADE, kTradeBlock);
+    if (block == 0) return false;
+    trade.timestamp = c.i64();
+    trade.price = c.f64();
+    trade.quantity = c.f64();
+    trade.makerFee = c.f64();
+    trade.takerFee = c.f64();
+    trade.aggressor = c.u8() == 0 ? "BUY" : "SELL";
+    c.skip(block - kTradeBlock);
+    trade.symbol = c.varData();
+    trade.tradeId = c.varData();
+    trade.makerOrderId = c.varData();
+    trade.takerOrderId = c.varData();
+    return c.ok();
+}
+
+bool decodeL2Delta(const char* data, size_t size, L2Delta& delta, uint64_t* firstSeq) {
+    Cursor c(data, size);
+    uint16_t block = readHeader(c, L2_DELTA, kDeltaBlock);
+    if (block == 0) return false;
+    delta.seq = c.u64();
+    uint64_t first = c.u64();
+    delta.timestamp = c.i64();
+    c.skip(block - kDeltaBlock);
+    if (firstSeq) *firstSeq = first;
+
+    uint16_t entryLength = c.u16();
+    uint16_t count = c.u16();
+    if (!c.ok() || entryLength < kDeltaEntry) return false;
+    delta.changes.clear();
+    delta.changes.reserve(count);
+    for (uint16_t i = 0; i < count && c.ok(); ++i) {
+        L2Level level;
+        level.price = c.f64();
+        level.quantity = c.f64();
+        level.side = c.u8() == 0 ? Side::BUY : Side::SELL;
+        c.skip(entryLength - kDeltaEntry);
+        delta.changes.push_back(level);
+    }
+    delta.symbol = c.varData();
+    return c.ok();
+}
+
+bool decodeL2Snapshot(const char* data, size_t size, L2Update& update) {
+    Cursor c(data, size);
+    uint16_t block = readHeader(c, L2_SNAPSHOT, kSnapshotBlock);
+    if (block == 0) return false;
+    update.seq = c.u64();
+    update.timestamp = c.i64();
+    c.skip(block - kSnapshotBlock);
+    for (auto* side : {&update.bids, &update.asks}) {
+        uint16_t entryLength = c.u16();
+        uint16_t count = c.u16();
+        if (!c.ok() || entryLength < kSnapshotEntry) return false;
+        side->clear();
+        side->reserve(count);
+        for (uint16_t i = 0; i < count && c.ok(); ++i) {
+            double price = c.f64();
+            double qty = c.f64();
+            c.skip(entryLength - kSnapshotEntry);
+            side->emplace_back(price, qty);
+        }
+    }
+    update.symbol = c.varData();
+    return c.ok();
+}
+
+bool decodeL3Event(const char* data, size_t size, L3Event& event) {
+    Cursor c(data, size);
+    uint16_t block = readHeader(c, L3_EVENT, kL3Block);
+    if (block == 0) return false;
+    event.seq = c.u64();
+    event.timestamp = c.i64();
+    event.price = c.f64();
+    event.quantity = c.f64();
+    event.execQty = c.f64();
+    uint8_t type = c.u8();
+    if (type > static_cast<uint8_t>(L3Event::Type::EXECUTE)) return false;
+    event.type = static_cast<L3Event::Type>(type);
+    event.side = c.u8() == 0 ? Side::BUY : Side::SELL;
+    c.skip(block - kL3Block);
+    event.symbol = c.varData();
+    event.orderId = c.varData();
+    event.tradeId = c.varData();
+    return c.ok();
+}
+
+bool decodeExecutionBatch(const char* data, size_t size, ExecutionBatch& batch) {
+    Cursor c(data, size);
+    uint16_t block = readHeader(c, EXECUTION_BATCH, kBatchBlock);
+    if (block == 0) return false;
+    batch.timestamp = c.i64();
+    batch.aggressor = c.u8() == 0 ? "BUY" : "SELL";
+    c.skip(block - kBatchBlock);
+
+    uint16_t entryLength = c.u16();
+    uint16_t count = c.u16();
+    if (!c.ok() || entryLength < kFillEntry) return false;
+    batch.fills.resize(count);
+    for (uint16_t i = 0; i < count && c.ok(); ++i) {
+        TradeReport& fill = batch.fills[i];
+        fill.timestamp = c.i64();
+        fill.price = c.f64();
+        fill.quantity = c.f64();
+        fill.makerFee = c.f64();
+        fill.takerFee = c.f64();
+        c.skip(entryLength - kFillEntry);
+        fill.tradeId = c.varData();
+        fill.makerOrderId = c.varData();
+    }
+    batch.symbol = c.varData();
+    batch.takerOrderId = c.varData();
+
+    // Fields shared by every fill travel once per batch
+    for (auto& fill : batch.fills) {
+        fill.symbol = batch.symbol;
+        fill.takerOrderId = batch.takerOrderId;
+        fill.aggressor = batch.aggressor;
+    }
+    return c.ok();
+}
+
+bool decodeGap(const char* data, size_t size, uint64_t& dropped) {
+    Cursor c(data, size);
+    if (readHeader(c, GAP, kGapBlock) == 0) return false;
+    dropped = c.u64();
+    return c.ok();
+}
+
+} // namespace BinaryCodec
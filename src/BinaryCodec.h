@@ -0,0 +1,89 @@
+#pragma once
+#include "OrderBook.h"
+#include "TradeExecutionFeed.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Compact binary market-data encoding (SBE style), sent as WebSocket binary
+// frames to clients that ask for {"op":"encoding","format":"binary"}.
+//
+// Every message starts with an 8-byte header; all integers and doubles are
+// little-endian, fixed offsets within the root block:
+//
+//   header        u16 blockLength   size of the root block that follows
+//                 u16 templateId    TRADE=1, L2_DELTA=2, L2_SNAPSHOT=3, L3_EVENT=4,
+//                                   EXECUTION_BATCH=5, GAP=6
+//                 u16 schemaId      kSchemaId
+//                 u16 version       kSchemaVersion
+//
+//   TRADE (root block 41 bytes)
+//     0  i64 timestamp     8  f64 price      16 f64 quantity
+//     24 f64 makerFee      32 f64 takerFee   40 u8  aggressor (0=BUY, 1=SELL)
+//     var data: symbol, tradeId, makerOrderId, takerOrderId
+//
+//   L2_DELTA (root block 24 bytes)
+//     0  u64 seq           8  u64 firstSeq   16 i64 timestamp
+//     group changes: u16 blockLength(17), u16 count, then per entry
+//       0 f64 price  8 f64 quantity  16 u8 side (0=bid, 1=ask)
+//     var data: symbol
+//
+//   L2_SNAPSHOT (root block 16 bytes)
+//     0  u64 seq           8  i64 timestamp
+//     group bids, group asks: u16 blockLength(16), u16 count, then per entry
+//       0 f64 price  8 f64 quantity
+//     var data: symbol
+//
+//   L3_EVENT (root block 42 bytes)
+//     0  u64 seq           8  i64 timestamp  16 f64 price
+//     24 f64 quantity      32 f64 execQty    40 u8  type (ADD, REDUCE, DELETE, EXECUTE)
+//     41 u8  side (0=bid, 1=ask)
+//     var data: symbol, orderId, tradeId (empty unless EXECUTE)
+//
+//   EXECUTION_BATCH (root block 9 bytes)
+//     0  i64 timestamp     8  u8  aggressor (0=BUY, 1=SELL)
+//     group fills: u16 blockLength(40), u16 count, then per entry
+//       0 i64 timestamp  8 f64 price  16 f64 quantity  24 f64 makerFee  32 f64 takerFee
+//       var data: tradeId, makerOrderId
+//     var data: symbol, takerOrderId
+//
+//   GAP (root block 8 bytes): the server dropped messages for this connection
+//     0  u64 dropped
+//
+// Var data fields are u8 length + bytes (strings longer than 255 are truncated).
+// Decoders skip unknown trailing root-block bytes using blockLength, so fields
+// can be appended in later schema versions.
+namespace BinaryCodec {
+
+constexpr uint16_t kSchemaId = 0x4751;   // "GQ"
+constexpr uint16_t kSchemaVersion = 1;
+constexpr size_t kHeaderSize = 8;
+
+enum TemplateId : uint16_t {
+    TRADE = 1,
+    L2_DELTA = 2,
+    L2_SNAPSHOT = 3,
+    L3_EVENT = 4,
+    EXECUTION_BATCH = 5,
+    GAP = 6
+};
+
+// Encoders append to out (reuse the buffer to avoid allocations)
+void encodeTrade(std::string& out, const TradeReport& trade);
+void encodeL2Delta(std::string& out, const std::string& symbol, uint64_t firstSeq, uint64_t seq,
+                   long long timestamp, const std::vector<L2Level>& changes);
+void encodeL2Snapshot(std::string& out, const L2Update& update);
+void encodeL3Event(std::string& out, const L3Event& event);
+void encodeExecutionBatch(std::string& out, const ExecutionBatch& batch);
+void encodeGap(std::string& out, uint64_t dropped);
+
+// Reference decoder. Returns 0 for a malformed or foreign message.
+uint16_t templateId(const char* data, size_t size);
+bool decodeTrade(const char* data, size_t size, TradeReport& trade);
+bool decodeL2Delta(const char* data, size_t size, L2Delta& delta, uint64_t* firstSeq = nullptr);
+bool decodeL2Snapshot(const char* data, size_t size, L2Update& update);
+bool decodeL3Event(const char* data, size_t size, L3Event& event);
+bool decodeExecutionBatch(const char* data, size_t size, ExecutionBatch& batch);
+bool decodeGap(const char* data, size_t size, uint64_t& dropped);
+
+} // namespace BinaryCodec
@@ -0,0 +1,26 @@
+#pragma once
+
+// Date and digit helpers for the fixed-width UTC timestamps written by the
+// logger and by FIX (SendingTime, CheckSum).
+
+// Days since 1970-01-01 -> civil date (proleptic Gregorian; Howard Hinnant's days-from-civil inverse)
+inline void civilFromDays(long long z, int& year, unsigned& month, unsigned& day) {
+    z += 719468;
+    const long long era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int>(yoe + era * 400 + (month <= 2));
+}
+
+// Zero-padded decimal of fixed width; returns the end of what was written
+inline char* putDigits(char* p, unsigned value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return p + width;
+}
@@ -0,0 +1,109 @@
+#include "EngineLoop.h"
+#include <exception>
+
+EngineLoop::EngineLoop(MatchingEngine& engine, size_t maxPending)
+    : engine_(engine), maxPending_(maxPending) {
+    thread_ = std::thread([this] { run(); });
+}
+
+EngineLoop::~EngineLoop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+bool EngineLoop::submit(Order order, ResponseHandler done) {
+    Command command{Command::Kind::SUBMIT, std::move(order)};
+    command.onResponse = std::move(done);
+    return post(std::move(command));
+}
+
+bool EngineLoop::cancel(std::string orderId, CancelHandler done) {
+    Command command{Command::Kind::CANCEL, Order{}};
+    command.order.orderId = std::move(orderId);
+    command.onCancel = std::move(done);
+    return post(std::move(command));
+}
+
+bool EngineLoop::amend(std::string orderId, double price, double quantity, ResponseHandler done) {
+    Command command{Command::Kind::AMEND, Order{}, price, quantity};
+    command.order.orderId = std::move(orderId);
+    command.onResponse = std::move(done);
+    return post(std::move(command));
+}
+
+void EngineLoop::massCancel(MassCancelRequest request, MassCancelHandler done) {
+    Command command{Command::Kind::MASS_CANCEL, Order{}};
+    command.massCancel = std::move(request);
+    command.onMassCancel = std::move(done);
+    post(std::move(command), false);
+}
+
+size_t EngineLoop::pending() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return queue_.size();
+}
+
+bool EngineLoop::post(Command&& command, bool bounded) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (bounded && queue_.size() >= maxPending_) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        queue_.push_back(std::move(command));
+        if (queue_.size() > 1) return true;   // the loop is already awake for the first one
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void EngineLoop::run() {
+    std::vector<Command> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;   // stopping and drained
+            batch.swap(queue_);
+        }
+        // Posts during the batch queue up behind it; the batch is taken whole so
+        // producers contend on mu_ once per batch, not once per command
+        for (auto& command : batch) execute(command);
+        batch.clear();
+    }
+}
+
+void EngineLoop::execute(Command& command) {
+    switch (command.kind) {
+        case Command::Kind::SUBMIT: {
+            OrderResponse response;
+            try {
+                response = engine_.submitOrder(command.order);
+            } catch (const std::exception& e) {
+                response = {OrderResult::REJECTED_INVALID_PARAMS, e.what()};
+            }
+            command.onResponse(response);
+            break;
+        }
+        case Command::Kind::AMEND: {
+            OrderResponse response;
+            try {
+                response = engine_.amendOrder(command.order.orderId, command.price, command.quantity);
+            } catch (const std::exception& e) {
+                response = {OrderResult::REJECTED_INVALID_PARAMS, e.what()};
+            }
+            command.onResponse(response);
+            break;
+        }
+        case Command::Kind::CANCEL:
+            command.onCancel(engine_.cancelOrder(command.order.orderId));
+            break;
+        case Command::Kind::MASS_CANCEL:
+            command.onMassCancel(engine_.massCancel(command.massCancel));
+            break;
+    }
+}
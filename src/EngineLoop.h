@@ -0,0 +1,68 @@
+#pragma once
+#include "MatchingEngine.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Matching thread in front of MatchingEngine for callers that must not block
+// on it (the HTTP handlers). A caller posts a command and returns at once; the
+// loop runs commands in arrival order and hands each result to the command's
+// continuation on the loop thread, so continuations must only hand the result
+// off (e.g. post it to the connection's io thread).
+//
+// The queue is bounded: when matching falls behind, posts fail (HTTP answers
+// 503) instead of tying up I/O threads.
+class EngineLoop {
+public:
+    using ResponseHandler = std::function<void(const OrderResponse&)>;
+    using CancelHandler = std::function<void(bool canceled)>;
+    using MassCancelHandler = std::function<void(const std::vector<std::string>& canceled)>;
+
+    explicit EngineLoop(MatchingEngine& engine, size_t maxPending = 65536);
+    ~EngineLoop();   // runs what is already queued, then joins
+
+    EngineLoop(const EngineLoop&) = delete;
+    EngineLoop& operator=(const EngineLoop&) = delete;
+
+    // False, without calling the handler, when maxPending commands are already queued
+    bool submit(Order order, ResponseHandler done);
+    bool cancel(std::string orderId, CancelHandler done);
+    bool amend(std::string orderId, double price, double quantity, ResponseHandler done);
+    // Always queued, even past maxPending: it only takes work off the book, and a
+    // session's cancel-on-disconnect must not be lost to back-pressure
+    void massCancel(MassCancelRequest request, MassCancelHandler done);
+
+    size_t pending();
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    struct Command {
+        enum class Kind { SUBMIT, CANCEL, AMEND, MASS_CANCEL } kind;
+        Order order;               // SUBMIT; AMEND/CANCEL use order.orderId
+        double price = 0.0;        // AMEND
+        double quantity = 0.0;     // AMEND
+        ResponseHandler onResponse;
+        CancelHandler onCancel;
+        MassCancelRequest massCancel;
+        MassCancelHandler onMassCancel;
+    };
+
+    bool post(Command&& command, bool bounded = true);
+    void run();
+    void execute(Command& command);
+
+    MatchingEngine& engine_;
+    size_t maxPending_;
+    std::atomic<uint64_t> rejected_{0};
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::vector<Command> queue_;     // guarded by mu_
+    bool stopping_ = false;          // guarded by mu_
+    std::thread thread_;
+};
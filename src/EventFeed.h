@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <vector>
 #include <mutex>
@@ -7,17 +9,30 @@ template<typename T>
 class EventFeed {
 public:
     using Callback = std::function<void(const T&)>;
+    using Token = uint64_t;   // names one subscription, for unsubscribe
     
-    void subscribe(Callback callback) {
+    // A subscriber whose callback captures an object releases the token before
+    // that object goes away
+    Token subscribe(Callback callback) {
         std::lock_guard<std::mutex> lock(mutex_);
-        subscribers_.push_back(callback);
+        subscribers_.push_back({++lastToken_, std::move(callback)});
+        return lastToken_;
+    }
+    
+    // Waits out a publish in progress, so the callback has returned and never runs
+    // again once this does. Not from inside a callback of the same feed.
+    void unsubscribe(Token token) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                          [token](const Subscriber& s) { return s.token == token; }),
+                           subscribers_.end());
     }
     
     void publish(const T& event) {
         std::lock_guard<std::mutex> lock(mutex_);
-        for (const auto& callback : subscribers_) {
+        for (const auto& subscriber : subscribers_) {
             try {
-                callback(event);
+                subscriber.callback(event);
             } catch (const std::exception& e) {
                 // Log error but continue with other subscribers
                 // In production, you might want better error handling
@@ -31,6 +46,12 @@ public:
     }
     
 private:
+    struct Subscriber {
+        Token token;
+        Callback callback;
+    };
+    
     mutable std::mutex mutex_;
-    std::vector<Callback> subscribers_;
+    std::vector<Subscriber> subscribers_;
+    Token lastToken_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,646 @@
+#include "FixGateway.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+using Fix::MessageWriter;
+namespace Tag = Fix::Tag;
+
+namespace {
+
+constexpr size_t kReadBuffer = 64 * 1024;
+
+// OrdStatus(39) of a live order
+char ordStatus(double filled, double quantity) {
+    return filled <= 0.0 ? '0' : filled < quantity ? '1' : '2';
+}
+
+double avgPx(double notional, double filled) {
+    return filled > 0.0 ? notional / filled : 0.0;
+}
+
+// Required string fields may not be empty on the wire
+std::string_view orNone(std::string_view value) {
+    return value.empty() ? std::string_view("NONE") : value;
+}
+
+// One ExecutionReport; the views must stay valid until it is written
+struct Report {
+    std::string_view orderId;
+    std::string_view clOrdId;
+    std::string_view origClOrdId;
+    std::string_view symbol;
+    std::string_view text;
+    long long execId = 0;
+    long long transactTime = 0;
+    char execType = '0';
+    char ordStatus = '0';
+    int rejectReason = -1;      // OrdRejReason(103), rejections only
+    Side side = Side::BUY;
+    double orderQty = 0.0;
+    double price = 0.0;         // 0 for market orders
+    double lastQty = 0.0;       // trades only
+    double lastPx = 0.0;
+    double leavesQty = 0.0;
+    double cumQty = 0.0;
+    double avgPx = 0.0;
+};
+
+void writeExecutionReport(MessageWriter& w, const Report& r) {
+    w.add(Tag::OrderID, orNone(r.orderId));
+    w.add(Tag::ClOrdID, orNone(r.clOrdId));
+    if (!r.origClOrdId.empty()) w.add(Tag::OrigClOrdID, r.origClOrdId);
+    w.add(Tag::ExecID, r.execId);
+    w.add(Tag::ExecType, r.execType);
+    w.add(Tag::OrdStatus, r.ordStatus);
+    if (r.rejectReason >= 0) w.add(Tag::OrdRejReason, static_cast<long long>(r.rejectReason));
+    w.add(Tag::Symbol, orNone(r.symbol));
+    w.add(Tag::Side, r.side == Side::BUY ? '1' : '2');
+    w.add(Tag::OrderQty, r.orderQty);
+    if (r.price > 0.0) w.add(Tag::Price, r.price);
+    if (r.lastQty > 0.0) {
+        w.add(Tag::LastQty, r.lastQty);
+        w.add(Tag::LastPx, r.lastPx);
+    }
+    w.add(Tag::LeavesQty, r.leavesQty);
+    w.add(Tag::CumQty, r.cumQty);
+    w.add(Tag::AvgPx, r.avgPx);
+    w.addTime(Tag::TransactTime, r.transactTime);
+    if (!r.text.empty()) w.add(Tag::Text, r.text);
+}
+
+// CxlRejResponseTo(434): '1' cancel, '2' cancel/replace. CxlRejReason(102): 1 unknown order, 6 duplicate ClOrdID, 99 other
+void writeCancelReject(MessageWriter& w, std::string_view orderId, std::string_view clOrdId,
+                       std::string_view origClOrdId, char status, char responseTo, int reason,
+                       std::string_view text) {
+    w.add(Tag::OrderID, orNone(orderId));
+    w.add(Tag::ClOrdID, orNone(clOrdId));
+    w.add(Tag::OrigClOrdID, orNone(origClOrdId));
+    w.add(Tag::OrdStatus, status);
+    w.add(Tag::CxlRejResponseTo, responseTo);
+    w.add(Tag::CxlRejReason, static_cast<long long>(reason));
+    w.add(Tag::Text, text);
+}
+
+} // namespace
+
+// One FIX connection. Reads, session checks and request handling happen on
+// the io thread; messages may be queued from any thread (maker fills) and are
+// written by the io thread.
+class FixGateway::Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(asio::ip::tcp::socket socket, FixGateway& gateway)
+        : socket_(std::move(socket)), gateway_(gateway), timer_(socket_.get_executor()), in_(kReadBuffer) {}
+
+    ~Session() { gateway_.sessionClosed(); }
+
+    void start() {
+        asio::error_code ec;
+        socket_.set_option(asio::ip::tcp::no_delay(true), ec);
+        read();
+    }
+
+    // Counterparty SenderCompID; set once at logon
+    const std::string& peer() const { return peer_; }
+
+    // Queue one outbound message (any thread); body(writer) adds the fields after the standard header
+    template<typename Body>
+    void send(std::string_view msgType, Body&& body) {
+        std::lock_guard<std::mutex> lock(outMu_);
+        writer_.begin(msgType, gateway_.compId_, peer_, ++outSeq_, Order::now());
+        body(writer_);
+        writer_.finish(outbox_);
+        sentInInterval_ = true;
+    }
+
+    void report(const Report& r) {
+        send("8", [&](MessageWriter& w) { writeExecutionReport(w, r); });
+    }
+
+    void cancelReject(std::string_view orderId, std::string_view clOrdId, std::string_view origClOrdId,
+                      char status, char responseTo, int reason, std::string_view text) {
+        send("9", [&](MessageWriter& w) {
+            writeCancelReject(w, orderId, clOrdId, origClOrdId, status, responseTo, reason, text);
+        });
+    }
+
+    // ClOrdID -> engine order id of this session's resting orders (io thread only)
+    const std::string* find(std::string_view clOrdId) const {
+        auto it = orders_.find(std::string(clOrdId));
+        return it == orders_.end() ? nullptr : &it->second;
+    }
+    void remember(std::string_view clOrdId, const std::string& orderId) { orders_[std::string(clOrdId)] = orderId; }
+    void forget(std::string_view clOrdId) { orders_.erase(std::string(clOrdId)); }
+
+    // Write whatever is queued (io thread only); one send per batch of replies
+    void flush() {
+        std::unique_lock<std::mutex> lock(outMu_);
+        if (writing_) return;
+        if (outbox_.empty()) {
+            if (closing_) close();
+            return;
+        }
+        inflight_.swap(outbox_);
+        outbox_.clear();
+        writing_ = true;
+        lock.unlock();
+
+        auto self = shared_from_this();
+        asio::async_write(socket_, asio::buffer(inflight_),
+            [this, self](const asio::error_code& ec, size_t) {
+                {
+                    std::lock_guard<std::mutex> lock(outMu_);
+                    writing_ = false;
+                    inflight_.clear();
+                }
+                if (!ec) flush();
+            });
+    }
+
+    // flush() from a thread other than the io thread
+    void postFlush() {
+        auto self = shared_from_this();
+        asio::post(socket_.get_executor(), [self]() { self->flush(); });
+    }
+
+private:
+    void read() {
+        // Keep the unread tail of a partial message at the front of the buffer
+        if (inBegin_ > 0) {
+            std::memmove(in_.data(), in_.data() + inBegin_, inEnd_ - inBegin_);
+            inEnd_ -= inBegin_;
+            inBegin_ = 0;
+        }
+        auto self = shared_from_this();
+        socket_.async_read_some(asio::buffer(in_.data() + inEnd_, in_.size() - inEnd_),
+            [this, self](const asio::error_code& ec, size_t size) {
+                if (ec) {
+                    timer_.cancel();
+                    return;   // disconnect: the session ends when its last handler is done
+                }
+                inEnd_ += size;
+                receivedInInterval_ = true;
+                process();
+                flush();
+                if (!closing_) read();
+            });
+    }
+
+    // Handle every complete message in the buffer, in order. Parsed fields
+    // point into in_, which is only compacted before the next read.
+    void process() {
+        while (!closing_ && inBegin_ < inEnd_) {
+            size_t consumed = 0;
+            Fix::ParseStatus status = Fix::parse(in_.data() + inBegin_, inEnd_ - inBegin_, message_, consumed);
+            if (status == Fix::ParseStatus::INCOMPLETE) return;
+            if (status == Fix::ParseStatus::BAD_FRAMING) {
+                // Message boundaries are lost
+                if (loggedOn_) logout("Invalid message framing");
+                closing_ = true;
+                return;
+            }
+            inBegin_ += consumed;
+            if (status == Fix::ParseStatus::GARBLED) continue;   // ignored and not sequenced
+            handle(message_);
+        }
+    }
+
+    void handle(const Fix::Message& message) {
+        std::string_view type = message.msgType();
+        uint32_t seq = message.seqNum();
+        if (!loggedOn_) {
+            // Anything but a valid Logon is dropped with the connection
+            if (type != "A" || !logon(message, seq)) closing_ = true;
+            return;
+        }
+        if (message.get(Tag::SenderCompID) != peer_ || message.get(Tag::TargetCompID) != gateway_.compId_) {
+            sessionReject(seq, type, 9, "CompID problem");
+            logout("CompID problem");
+            return;
+        }
+        if (seq != expectedSeq_) {
+            // No resend: a gap or a repeated number cannot be recovered
+            logout((seq < expectedSeq_ ? "MsgSeqNum too low, expecting " : "MsgSeqNum too high, expecting ")
+                   + std::to_string(expectedSeq_));
+            return;
+        }
+        ++expectedSeq_;
+
+        auto self = shared_from_this();
+        switch (type.size() == 1 ? type[0] : '\0') {
+            case '0':
+                break;
+            case '1': {
+                std::string_view testReqId = message.get(Tag::TestReqID);
+                send("0", [&](MessageWriter& w) { w.add(Tag::TestReqID, orNone(testReqId)); });
+                break;
+            }
+            case '5':
+                logout({});
+                break;
+            case 'D': gateway_.handleNewOrder(self, message); break;
+            case 'F': gateway_.handleCancel(self, message); break;
+            case 'G': gateway_.handleReplace(self, message); break;
+            default:
+                sessionReject(seq, type, 11, "Unsupported MsgType");
+                break;
+        }
+    }
+
+    bool logon(const Fix::Message& message, uint32_t seq) {
+        long long heartBtInt;
+        if (seq != 1 || message.get(Tag::SenderCompID).empty()
+            || message.get(Tag::TargetCompID) != gateway_.compId_
+            || !message.getInt(Tag::HeartBtInt, heartBtInt) || heartBtInt < 0) {
+            return false;
+        }
+        peer_.assign(message.get(Tag::SenderCompID));
+        heartBtInt_ = heartBtInt;
+        loggedOn_ = true;
+        expectedSeq_ = 2;
+        send("A", [&](MessageWriter& w) {
+            w.add(Tag::EncryptMethod, 0LL);
+            w.add(Tag::HeartBtInt, heartBtInt);
+        });
+        startHeartbeat();
+        return true;
+    }
+
+    void logout(const std::string& text) {
+        send("5", [&](MessageWriter& w) {
+            if (!text.empty()) w.add(Tag::Text, text);
+        });
+        closing_ = true;
+    }
+
+    void sessionReject(uint32_t refSeq, std::string_view refMsgType, int reason, std::string_view text) {
+        send("3", [&](MessageWriter& w) {
+            w.add(Tag::RefSeqNum, static_cast<long long>(refSeq));
+            w.add(Tag::RefMsgType, orNone(refMsgType));
+            w.add(Tag::SessionRejectReason, static_cast<long long>(reason));
+            w.add(Tag::Text, text);
+        });
+    }
+
+    // Every HeartBtInt: heartbeat if nothing was sent, TestRequest if nothing
+    // was received, disconnect if the TestRequest went unanswered too
+    void startHeartbeat() {
+        if (heartBtInt_ <= 0) return;
+        timer_.expires_after(std::chrono::seconds(heartBtInt_));
+        auto self = shared_from_this();
+        timer_.async_wait([this, self](const asio::error_code& ec) {
+            if (ec || closing_) return;
+            bool sent;
+            {
+                std::lock_guard<std::mutex> lock(outMu_);
+                sent = sentInInterval_;
+                sentInInterval_ = false;
+            }
+            if (receivedInInterval_) {
+                silentIntervals_ = 0;
+                if (!sent) send("0", [](MessageWriter&) {});
+            } else if (++silentIntervals_ == 1) {
+                send("1", [](MessageWriter& w) { w.add(Tag::TestReqID, std::string_view("TEST")); });
+            } else {
+                closing_ = true;
+            }
+            receivedInInterval_ = false;
+            flush();
+            if (!closing_) startHeartbeat();
+        });
+    }
+
+    void close() {
+        asio::error_code ec;
+        timer_.cancel();
+        socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+        socket_.close(ec);
+    }
+
+    asio::ip::tcp::socket socket_;
+    FixGateway& gateway_;
+    asio::steady_timer timer_;
+
+    // io thread only
+    std::vector<char> in_;
+    size_t inBegin_ = 0;
+    size_t inEnd_ = 0;
+    Fix::Message message_;
+    std::unordered_map<std::string, std::string> orders_;
+    bool loggedOn_ = false;
+    bool closing_ = false;
+    bool receivedInInterval_ = false;
+    long long heartBtInt_ = 0;
+    int silentIntervals_ = 0;
+    uint32_t expectedSeq_ = 1;
+    std::string peer_;
+
+    // Guarded by outMu_ (inflight_ belongs to the write in progress)
+    std::mutex outMu_;
+    MessageWriter writer_;
+    std::string outbox_;
+    std::string inflight_;
+    uint32_t outSeq_ = 0;
+    bool sentInInterval_ = false;
+    bool writing_ = false;
+};
+
+FixGateway::FixGateway(MatchingEngine& engine, uint16_t port, std::string compId)
+    : engine_(engine),
+      compId_(std::move(compId)),
+      acceptor_(io_, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)) {
+    tradeSub_ = engine_.tradeFeed().subscribe([this](const TradeReport& trade) { onTrade(trade); });
+
+    startAccept();
+    ioThread_ = std::thread([this]() { io_.run(); });
+}
+
+FixGateway::~FixGateway() {
+    engine_.tradeFeed().unsubscribe(tradeSub_);   // no maker fill may post to the io_context once it is gone
+    io_.stop();
+    if (ioThread_.joinable()) ioThread_.join();
+}
+
+void FixGateway::startAccept() {
+    acceptor_.async_accept([this](const asio::error_code& ec, asio::ip::tcp::socket socket) {
+        if (ec == asio::error::operation_aborted) return;
+        if (!ec) {
+            ++sessions_;
+            std::make_shared<Session>(std::move(socket), *this)->start();
+        } else {
+            LOG_ERROR("[FIX] Accept failed: {}", ec.message());
+        }
+        startAccept();
+    });
+}
+
+void FixGateway::sessionClosed() {
+    --sessions_;
+    // Orders stay on the book; forget the owners that can no longer be reached
+    std::lock_guard<std::mutex> lock(ownersMu_);
+    for (auto it = owners_.begin(); it != owners_.end();) {
+        if (it->second.session.expired()) it = owners_.erase(it);
+        else ++it;
+    }
+}
+
+void FixGateway::handleNewOrder(const std::shared_ptr<Session>& session, const Fix::Message& message) {
+    Order order{};
+    const char* error = Fix::toOrder(message, order);
+    std::string_view clOrdId = message.get(Tag::ClOrdID);
+
+    Report report;
+    report.clOrdId = clOrdId;
+    report.symbol = message.get(Tag::Symbol);
+    report.side = message.getChar(Tag::Side) == '2' ? Side::SELL : Side::BUY;
+    report.orderQty = order.quantity;
+    report.price = order.price;
+    report.transactTime = Order::now();
+    if (!error && session->find(clOrdId)) {
+        error = "Duplicate ClOrdID(11)";
+        report.rejectReason = 6;
+    }
+    if (error) {
+        report.execId = ++execIds_;
+        report.execType = report.ordStatus = '8';
+        if (report.rejectReason < 0) report.rejectReason = 99;
+        report.text = error;
+        session->report(report);
+        return;
+    }
+
+    std::string orderId;
+    orderId.reserve(session->peer().size() + 1 + clOrdId.size());
+    orderId.append(session->peer()).append(1, ':').append(clOrdId.data(), clOrdId.size());
+    order.orderId = orderId;
+    order.timestamp = Order::now();
+
+    // Own the order before it can rest, so no maker fill is missed; a duplicate
+    // id keeps its current owner (the engine rejects the duplicate)
+    OwnedOrder owned{session, std::string(clOrdId), order.symbol, order.side, order.price, order.quantity, 0.0, 0.0};
+    bool registered;
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        registered = owners_.try_emplace(orderId, owned).second;
+    }
+
+    // Its own fills are counted by onTrade as they happen, before another thread can
+    // reach the resting remainder
+    OrderResponse response = engine_.submitOrder(order);
+    bool resting = (response.result == OrderResult::ACCEPTED);
+    double notional = 0.0;
+    for (const auto& trade : response.trades) notional += trade.price * trade.quantity;
+    if (registered && !resting) {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        owners_.erase(orderId);
+    }
+
+    report.orderId = orderId;
+    report.execId = ++execIds_;
+    if (isRejection(response.result)) {
+        report.execType = report.ordStatus = '8';
+        report.rejectReason = 99;
+        report.text = response.message;
+        session->report(report);
+        return;
+    }
+    if (resting) session->remember(clOrdId, orderId);
+
+    report.execType = report.ordStatus = '0';
+    report.leavesQty = order.quantity;
+    session->report(report);
+    sendTakerFills(*session, orderId, owned, response.trades);
+
+    if (!resting && response.result != OrderResult::COMPLETELY_FILLED) {
+        // Market and IOC remainder
+        report.execId = ++execIds_;
+        report.execType = report.ordStatus = '4';
+        report.leavesQty = 0.0;
+        report.cumQty = response.filledQuantity;
+        report.avgPx = avgPx(notional, response.filledQuantity);
+        report.text = response.message;
+        session->report(report);
+    }
+}
+
+void FixGateway::handleCancel(const std::shared_ptr<Session>& session, const Fix::Message& message) {
+    std::string_view clOrdId = message.get(Tag::ClOrdID);
+    std::string_view origClOrdId = message.get(Tag::OrigClOrdID);
+    const std::string* found = session->find(origClOrdId);
+    if (!found || !engine_.cancelOrder(*found)) {
+        if (found) session->forget(origClOrdId);   // filled since
+        session->cancelReject({}, clOrdId, origClOrdId, '8', '1', 1, "Unknown order");
+        return;
+    }
+    std::string orderId = *found;
+    session->forget(origClOrdId);
+
+    OwnedOrder owned;
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        auto it = owners_.find(orderId);
+        if (it != owners_.end()) {
+            owned = std::move(it->second);
+            owners_.erase(it);
+        }
+    }
+
+    Report report;
+    report.orderId = orderId;
+    report.clOrdId = clOrdId;
+    report.origClOrdId = origClOrdId;
+    report.symbol = owned.symbol;
+    report.execId = ++execIds_;
+    report.transactTime = Order::now();
+    report.execType = report.ordStatus = '4';
+    report.side = owned.side;
+    report.orderQty = owned.quantity;
+    report.price = owned.price;
+    report.cumQty = owned.filled;
+    report.avgPx = avgPx(owned.notional, owned.filled);
+    session->report(report);
+}
+
+void FixGateway::handleReplace(const std::shared_ptr<Session>& session, const Fix::Message& message) {
+    std::string_view clOrdId = message.get(Tag::ClOrdID);
+    std::string_view origClOrdId = message.get(Tag::OrigClOrdID);
+    const std::string* found = session->find(origClOrdId);
+    if (!found) {
+        session->cancelReject({}, clOrdId, origClOrdId, '8', '2', 1, "Unknown order");
+        return;
+    }
+    std::string orderId = *found;
+    if (clOrdId.empty() || session->find(clOrdId)) {
+        session->cancelReject(orderId, clOrdId, origClOrdId, '0', '2', 6, "Duplicate ClOrdID(11)");
+        return;
+    }
+
+    // Absent fields keep their current value
+    double price = 0.0;
+    double quantity = 0.0;
+    message.getDouble(Tag::Price, price);
+    message.getDouble(Tag::OrderQty, quantity);
+    OrderResponse response = engine_.amendOrder(orderId, price, quantity);
+    if (isRejection(response.result)) {
+        bool unknown = (response.result == OrderResult::REJECTED_UNKNOWN_ORDER);
+        if (unknown) session->forget(origClOrdId);
+        session->cancelReject(orderId, clOrdId, origClOrdId, unknown ? '8' : '0', '2', unknown ? 1 : 99,
+                              response.message);
+        return;
+    }
+
+    // State as replaced, before any fills the new terms caused
+    OwnedOrder replaced;
+    double notional = 0.0;
+    for (const auto& trade : response.trades) notional += trade.price * trade.quantity;
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        auto it = owners_.find(orderId);
+        if (it != owners_.end()) {
+            OwnedOrder& owned = it->second;
+            owned.clOrdId.assign(clOrdId.data(), clOrdId.size());
+            if (price > 0.0) owned.price = price;
+            if (quantity > 0.0) owned.quantity = quantity;
+            // onTrade already counted the fills the new terms caused
+            replaced = owned;
+            replaced.filled = response.filledQuantity;
+            for (const auto& trade : response.trades) replaced.filled -= trade.quantity;
+            replaced.notional -= notional;
+            if (response.result == OrderResult::COMPLETELY_FILLED) owners_.erase(it);
+        }
+    }
+    session->forget(origClOrdId);
+    if (response.result != OrderResult::COMPLETELY_FILLED) session->remember(clOrdId, orderId);
+
+    Report report;
+    report.orderId = orderId;
+    report.clOrdId = clOrdId;
+    report.origClOrdId = origClOrdId;
+    report.symbol = replaced.symbol;
+    report.execId = ++execIds_;
+    report.transactTime = Order::now();
+    report.execType = '5';
+    report.ordStatus = ordStatus(replaced.filled, replaced.quantity);
+    report.side = replaced.side;
+    report.orderQty = replaced.quantity;
+    report.price = replaced.price;
+    report.leavesQty = std::max(0.0, replaced.quantity - replaced.filled);
+    report.cumQty = replaced.filled;
+    report.avgPx = avgPx(replaced.notional, replaced.filled);
+    session->report(report);
+    sendTakerFills(*session, orderId, replaced, response.trades);
+}
+
+void FixGateway::sendTakerFills(Session& session, const std::string& orderId, const OwnedOrder& order,
+                                const std::vector<TradeReport>& trades) {
+    double filled = order.filled;
+    double notional = order.notional;
+    for (const auto& trade : trades) {
+        filled += trade.quantity;
+        notional += trade.price * trade.quantity;
+        Report report;
+        report.orderId = orderId;
+        report.clOrdId = order.clOrdId;
+        report.symbol = order.symbol;
+        report.execId = ++execIds_;
+        report.transactTime = trade.timestamp;
+        report.execType = 'F';
+        report.ordStatus = ordStatus(filled, order.quantity);
+        report.side = order.side;
+        report.orderQty = order.quantity;
+        report.price = order.price;
+        report.lastQty = trade.quantity;
+        report.lastPx = trade.price;
+        report.leavesQty = std::max(0.0, order.quantity - filled);
+        report.cumQty = filled;
+        report.avgPx = avgPx(notional, filled);
+        session.report(report);
+    }
+}
+
+// Runs on the matching thread, under the engine lock
+void FixGateway::onTrade(const TradeReport& trade) {
+    std::shared_ptr<Session> session;
+    OwnedOrder order;
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        // A taker's fills are reported with its request; only count them here, so the
+        // maker fills of its resting remainder start from the right cumulative quantity
+        auto taker = owners_.find(trade.takerOrderId);
+        if (taker != owners_.end()) {
+            taker->second.filled += trade.quantity;
+            taker->second.notional += trade.price * trade.quantity;
+        }
+
+        auto it = owners_.find(trade.makerOrderId);
+        if (it == owners_.end()) return;
+        OwnedOrder& owned = it->second;
+        owned.filled += trade.quantity;
+        owned.notional += trade.price * trade.quantity;
+        session = owned.session.lock();
+        if (!session) return;
+        order = owned;
+        if (owned.filled >= owned.quantity) owners_.erase(it);
+    }
+
+    Report report;
+    report.orderId = trade.makerOrderId;
+    report.clOrdId = order.clOrdId;
+    report.symbol = order.symbol;
+    report.execId = ++execIds_;
+    report.transactTime = trade.timestamp;
+    report.execType = 'F';
+    report.ordStatus = ordStatus(order.filled, order.quantity);
+    report.side = order.side;
+    report.orderQty = order.quantity;
+    report.price = order.price;
+    report.lastQty = trade.quantity;
+    report.lastPx = trade.price;
+    report.leavesQty = std::max(0.0, order.quantity - order.filled);
+    report.cumQty = order.filled;
+    report.avgPx = avgPx(order.notional, order.filled);
+    session->report(report);
+    session->postFlush();
+}
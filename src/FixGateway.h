@@ -0,0 +1,82 @@
+#pragma once
+#include "MatchingEngine.h"
+#include "FixProtocol.h"
+#include <asio.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// FIX 4.4 order entry, acceptor side.
+//
+//   in   Logon (A), Heartbeat (0), TestRequest (1), Logout (5), NewOrderSingle (D),
+//        OrderCancelRequest (F), OrderCancelReplaceRequest (G)
+//   out  Logon, Heartbeat, TestRequest, Logout, Reject (3), ExecutionReport (8),
+//        OrderCancelReject (9)
+//
+// Like OrderGateway, one io thread parses each connection's receive buffer in
+// place (FixProtocol.h), calls the engine directly and writes the replies of
+// one read batch in a single send.
+//
+// Sessions are not persistent: both sides start at MsgSeqNum 1 on every
+// connection and there is no resend, so a sequence gap ends the session with a
+// Logout. The engine order id of a FIX order is "<SenderCompID>:<ClOrdID>" of
+// its NewOrderSingle, reported as OrderID(37); later requests refer to the
+// latest ClOrdID through OrigClOrdID(41). A session only manages its own
+// orders and gets ExecutionReports for their fills as they trade.
+class FixGateway {
+public:
+    explicit FixGateway(MatchingEngine& engine, uint16_t port = 18082,   // 0 = any free port
+                        std::string compId = "ENGINE");
+    ~FixGateway();
+
+    FixGateway(const FixGateway&) = delete;
+    FixGateway& operator=(const FixGateway&) = delete;
+
+    uint16_t port() const { return acceptor_.local_endpoint().port(); }
+    size_t sessionCount() const { return sessions_.load(); }
+
+private:
+    class Session;
+
+    // Resting order entered through a session
+    struct OwnedOrder {
+        std::weak_ptr<Session> session;
+        std::string clOrdId;        // latest, changes on replace
+        std::string symbol;
+        Side side = Side::BUY;
+        double price = 0.0;
+        double quantity = 0.0;
+        double filled = 0.0;
+        double notional = 0.0;      // sum of fill price * quantity, for AvgPx
+    };
+
+    void startAccept();
+    void onTrade(const TradeReport& trade);
+
+    // Application messages, called on the io thread after session checks
+    void handleNewOrder(const std::shared_ptr<Session>& session, const Fix::Message& message);
+    void handleCancel(const std::shared_ptr<Session>& session, const Fix::Message& message);
+    void handleReplace(const std::shared_ptr<Session>& session, const Fix::Message& message);
+    void sendTakerFills(Session& session, const std::string& orderId, const OwnedOrder& order,
+                        const std::vector<TradeReport>& trades);
+    void sessionClosed();
+
+    MatchingEngine& engine_;
+    EventFeed<TradeReport>::Token tradeSub_;
+    const std::string compId_;
+    std::atomic<size_t> sessions_{0};
+    std::atomic<long long> execIds_{0};
+
+    // Never held while calling into the engine (the trade callback takes it under the engine lock).
+    // Declared before io_: sessions destroyed with the io_context still unregister here.
+    std::mutex ownersMu_;
+    std::unordered_map<std::string, OwnedOrder> owners_;
+
+    asio::io_context io_;
+    asio::ip::tcp::acceptor acceptor_;
+    std::thread ioThread_;
+};
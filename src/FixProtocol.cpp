@@ -0,0 +1,238 @@
+#include "FixProtocol.h"
+#include "CivilTime.h"
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+} // namespace
+
+namespace Fix {
+
+uint32_t Message::seqNum() const {
+    long long seq;
+    return getInt(Tag::MsgSeqNum, seq) && seq > 0 ? static_cast<uint32_t>(seq) : 0;
+}
+
+bool Message::has(int tag) const {
+    for (size_t i = 0; i < count_; ++i) {
+        if (fields_[i].tag == tag) return true;
+    }
+    return false;
+}
+
+std::string_view Message::get(int tag) const {
+    for (size_t i = 0; i < count_; ++i) {
+        if (fields_[i].tag == tag) return fields_[i].value;
+    }
+    return {};
+}
+
+bool Message::getDouble(int tag, double& value) const {
+    std::string_view v = get(tag);
+    if (v.empty()) return false;
+    auto res = std::from_chars(v.data(), v.data() + v.size(), value);
+    return res.ec == std::errc() && res.ptr == v.data() + v.size();
+}
+
+bool Message::getInt(int tag, long long& value) const {
+    std::string_view v = get(tag);
+    if (v.empty()) return false;
+    auto res = std::from_chars(v.data(), v.data() + v.size(), value);
+    return res.ec == std::errc() && res.ptr == v.data() + v.size();
+}
+
+char Message::getChar(int tag) const {
+    std::string_view v = get(tag);
+    return v.size() == 1 ? v[0] : '\0';
+}
+
+ParseStatus parse(const char* data, size_t size, Message& message, size_t& consumed) {
+    // 8=FIX.4.4<SOH>9=
+    static constexpr char kPrefix[] = "8=FIX.4.4\x01" "9=";
+    constexpr size_t kPrefixSize = sizeof(kPrefix) - 1;
+    if (std::memcmp(data, kPrefix, size < kPrefixSize ? size : kPrefixSize) != 0) return ParseStatus::BAD_FRAMING;
+    if (size < kPrefixSize) return ParseStatus::INCOMPLETE;
+
+    size_t pos = kPrefixSize;
+    size_t bodyLength = 0;
+    for (;; ++pos) {
+        if (pos == size) return ParseStatus::INCOMPLETE;
+        char c = data[pos];
+        if (c == kSoh) break;
+        if (!isDigit(c)) return ParseStatus::BAD_FRAMING;
+        bodyLength = bodyLength * 10 + static_cast<size_t>(c - '0');
+        if (bodyLength > kMaxBodyLength) return ParseStatus::BAD_FRAMING;
+    }
+    if (pos == kPrefixSize) return ParseStatus::BAD_FRAMING;
+
+    // Body, then exactly "10=nnn<SOH>"
+    const size_t bodyStart = pos + 1;
+    const size_t trailer = bodyStart + bodyLength;
+    if (size < trailer + 7) return ParseStatus::INCOMPLETE;
+    consumed = trailer + 7;
+
+    const char* t = data + trailer;
+    if (t[0] != '1' || t[1] != '0' || t[2] != '=' || !isDigit(t[3]) || !isDigit(t[4]) || !isDigit(t[5])
+        || t[6] != kSoh) {
+        return ParseStatus::GARBLED;
+    }
+    unsigned sum = 0;
+    for (size_t i = 0; i < trailer; ++i) sum += static_cast<uint8_t>(data[i]);
+    unsigned expected = static_cast<unsigned>((t[3] - '0') * 100 + (t[4] - '0') * 10 + (t[5] - '0'));
+    if ((sum & 0xFF) != expected) return ParseStatus::GARBLED;
+
+    // Fields: views into the body, no copies
+    message.count_ = 0;
+    const char* p = data + bodyStart;
+    const char* end = data + trailer;
+    while (p < end) {
+        int tag = 0;
+        const char* q = p;
+        while (q < end && isDigit(*q) && q - p < 9) tag = tag * 10 + (*q++ - '0');
+        if (q == p || q == end || *q != '=') return ParseStatus::GARBLED;
+        const char* value = q + 1;
+        const char* soh = static_cast<const char*>(std::memchr(value, kSoh, static_cast<size_t>(end - value)));
+        if (!soh || message.count_ == Message::kMaxFields) return ParseStatus::GARBLED;
+        message.fields_[message.count_++] = Field{tag, std::string_view(value, static_cast<size_t>(soh - value))};
+        p = soh + 1;
+    }
+    if (message.count_ == 0 || message.fields_[0].tag != Tag::MsgType) return ParseStatus::GARBLED;
+    return ParseStatus::COMPLETE;
+}
+
+const char* toOrder(const Message& message, Order& order) {
+    std::string_view clOrdId = message.get(Tag::ClOrdID);
+    std::string_view symbol = message.get(Tag::Symbol);
+    if (clOrdId.empty()) return "Missing ClOrdID(11)";
+    if (symbol.empty()) return "Missing Symbol(55)";
+
+    switch (message.getChar(Tag::Side)) {
+        case '1': order.side = Side::BUY; break;
+        case '2': order.side = Side::SELL; break;
+        default:  return "Unsupported Side(54)";
+    }
+    if (!message.getDouble(Tag::OrderQty, order.quantity)) return "Missing or invalid OrderQty(38)";
+
+    char timeInForce = message.has(Tag::TimeInForce) ? message.getChar(Tag::TimeInForce) : '0';
+    switch (message.getChar(Tag::OrdType)) {
+        case '1':
+            if (timeInForce != '0' && timeInForce != '1' && timeInForce != '3') {
+                return "Unsupported TimeInForce(59) for a market order";
+            }
+            order.type = OrderType::MARKET;
+            order.price = 0.0;
+            break;
+        case '2':
+            if (!message.getDouble(Tag::Price, order.price)) return "Missing or invalid Price(44)";
+            switch (timeInForce) {
+                case '0':
+                case '1': order.type = OrderType::LIMIT; break;
+                case '3': order.type = OrderType::IOC; break;
+                case '4': order.type = OrderType::FOK; break;
+                default:  return "Unsupported TimeInForce(59)";
+            }
+            break;
+        default:
+            return "Unsupported OrdType(40)";
+    }
+
+    order.displayQty = 0.0;
+    if (message.has(Tag::MaxFloor) && !message.getDouble(Tag::MaxFloor, order.displayQty)) {
+        return "Invalid MaxFloor(111)";
+    }
+
+    order.orderId.assign(clOrdId.data(), clOrdId.size());
+    order.symbol.assign(symbol.data(), symbol.size());
+    order.stopPrice = 0.0;
+    order.filledQty = 0.0;
+    return nullptr;
+}
+
+void MessageWriter::begin(std::string_view msgType, std::string_view sender, std::string_view target,
+                          uint32_t seq, long long sendingTimeMs) {
+    body_.clear();
+    add(Tag::MsgType, msgType);
+    add(Tag::SenderCompID, sender);
+    add(Tag::TargetCompID, target);
+    add(Tag::MsgSeqNum, static_cast<long long>(seq));
+    addTime(Tag::SendingTime, sendingTimeMs);
+}
+
+void MessageWriter::tag(int t) {
+    char buf[16];
+    auto res = std::to_chars(buf, buf + sizeof(buf), t);
+    body_.append(buf, res.ptr);
+    body_.push_back('=');
+}
+
+void MessageWriter::add(int t, std::string_view value) {
+    tag(t);
+    body_.append(value.data(), value.size());
+    body_.push_back(kSoh);
+}
+
+void MessageWriter::add(int t, char value) {
+    tag(t);
+    body_.push_back(value);
+    body_.push_back(kSoh);
+}
+
+void MessageWriter::add(int t, long long value) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    add(t, std::string_view(buf, static_cast<size_t>(res.ptr - buf)));
+}
+
+void MessageWriter::add(int t, double value) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    add(t, std::string_view(buf, static_cast<size_t>(res.ptr - buf)));
+}
+
+void MessageWriter::addTime(int t, long long epochMs) {
+    long long days = epochMs / 86400000;
+    long long msOfDay = epochMs % 86400000;
+    if (msOfDay < 0) {
+        msOfDay += 86400000;
+        --days;
+    }
+    int year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    char buf[21];   // YYYYMMDD-HH:MM:SS.sss
+    char* p = putDigits(buf, static_cast<unsigned>(year), 4);
+    p = putDigits(p, month, 2);
+    p = putDigits(p, day, 2);
+    *p++ = '-';
+    p = putDigits(p, static_cast<unsigned>(msOfDay / 3600000), 2);
+    *p++ = ':';
+    p = putDigits(p, static_cast<unsigned>(msOfDay / 60000 % 60), 2);
+    *p++ = ':';
+    p = putDigits(p, static_cast<unsigned>(msOfDay / 1000 % 60), 2);
+    *p++ = '.';
+    p = putDigits(p, static_cast<unsigned>(msOfDay % 1000), 3);
+    add(t, std::string_view(buf, static_cast<size_t>(p - buf)));
+}
+
+void MessageWriter::finish(std::string& out) {
+    size_t start = out.size();
+    out.append("8=FIX.4.4\x01" "9=");
+    char buf[16];
+    auto res = std::to_chars(buf, buf + sizeof(buf), body_.size());
+    out.append(buf, res.ptr);
+    out.push_back(kSoh);
+    out.append(body_);
+
+    unsigned sum = 0;
+    for (size_t i = start; i < out.size(); ++i) sum += static_cast<uint8_t>(out[i]);
+    char trailer[7] = {'1', '0', '='};
+    putDigits(trailer + 3, sum & 0xFF, 3);
+    trailer[6] = kSoh;
+    out.append(trailer, sizeof(trailer));
+}
+
+} // namespace Fix
@@ -0,0 +1,131 @@
+#pragma once
+#include "Order.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// FIX 4.4 tag=value framing for FixGateway.
+//
+// The parser works in place on the receive buffer: a parsed Message is an
+// array of (tag, view) pairs pointing into the bytes it was parsed from, so it
+// is only valid until that buffer is compacted or refilled. Nothing is copied
+// or allocated per field; numbers are converted on access with from_chars.
+//
+// The writer builds the body of one outbound message in a reusable buffer and
+// appends the framed message (8, 9, body, 10) to an output string.
+namespace Fix {
+
+constexpr char kSoh = '\x01';
+constexpr std::string_view kBeginString = "FIX.4.4";
+constexpr size_t kMaxBodyLength = 8 * 1024;
+
+// Tags used by the gateway
+namespace Tag {
+constexpr int AvgPx = 6;
+constexpr int BeginString = 8;
+constexpr int BodyLength = 9;
+constexpr int CheckSum = 10;
+constexpr int ClOrdID = 11;
+constexpr int CumQty = 14;
+constexpr int ExecID = 17;
+constexpr int LastPx = 31;
+constexpr int LastQty = 32;
+constexpr int MsgSeqNum = 34;
+constexpr int MsgType = 35;
+constexpr int OrderID = 37;
+constexpr int OrderQty = 38;
+constexpr int OrdStatus = 39;
+constexpr int OrdType = 40;
+constexpr int OrigClOrdID = 41;
+constexpr int Price = 44;
+constexpr int RefSeqNum = 45;
+constexpr int SenderCompID = 49;
+constexpr int SendingTime = 52;
+constexpr int Side = 54;
+constexpr int Symbol = 55;
+constexpr int TargetCompID = 56;
+constexpr int Text = 58;
+constexpr int TimeInForce = 59;
+constexpr int TransactTime = 60;
+constexpr int EncryptMethod = 98;
+constexpr int CxlRejReason = 102;
+constexpr int OrdRejReason = 103;
+constexpr int HeartBtInt = 108;
+constexpr int MaxFloor = 111;
+constexpr int TestReqID = 112;
+constexpr int ExecType = 150;
+constexpr int LeavesQty = 151;
+constexpr int RefMsgType = 372;
+constexpr int SessionRejectReason = 373;
+constexpr int CxlRejResponseTo = 434;
+} // namespace Tag
+
+enum class ParseStatus {
+    COMPLETE,       // message parsed, consumed = its length
+    INCOMPLETE,     // need more bytes
+    GARBLED,        // framing intact but checksum or fields bad: skip consumed bytes
+    BAD_FRAMING     // no valid 8=/9= prefix or BodyLength too large; cannot resynchronise
+};
+
+struct Field {
+    int tag = 0;
+    std::string_view value;
+};
+
+// One parsed message; views into the buffer it was parsed from
+class Message {
+public:
+    static constexpr size_t kMaxFields = 64;
+
+    std::string_view msgType() const { return get(Tag::MsgType); }
+    uint32_t seqNum() const;
+
+    bool has(int tag) const;
+    std::string_view get(int tag) const;               // empty when absent
+    bool getDouble(int tag, double& value) const;      // false when absent or not a number
+    bool getInt(int tag, long long& value) const;
+    char getChar(int tag) const;                       // '\0' unless the value is one character
+
+    const Field* begin() const { return fields_; }
+    const Field* end() const { return fields_ + count_; }
+    size_t size() const { return count_; }
+
+private:
+    friend ParseStatus parse(const char*, size_t, Message&, size_t&);
+    Field fields_[kMaxFields];
+    size_t count_ = 0;
+};
+
+// Parse the message starting at data
+ParseStatus parse(const char* data, size_t size, Message& message, size_t& consumed);
+
+// NewOrderSingle -> Order. orderId is ClOrdID; timestamp is left to the caller.
+// Returns nullptr on success, otherwise a reason fit for Text(58).
+//   54 Side: 1=BUY 2=SELL   40 OrdType: 1=MARKET 2=LIMIT
+//   59 TimeInForce: 0 (Day), 1 (GTC) rest; 3=IOC 4=FOK (limit orders only)
+//   111 MaxFloor: display quantity of an iceberg limit order (optional)
+const char* toOrder(const Message& message, Order& order);
+
+// Builds outbound messages; the buffer is reused across messages
+class MessageWriter {
+public:
+    // Starts a message: MsgType, SenderCompID, TargetCompID, MsgSeqNum, SendingTime
+    void begin(std::string_view msgType, std::string_view sender, std::string_view target,
+               uint32_t seq, long long sendingTimeMs);
+
+    void add(int tag, std::string_view value);
+    void add(int tag, char value);
+    void add(int tag, long long value);
+    void add(int tag, double value);
+    void addTime(int tag, long long epochMs);        // UTCTimestamp YYYYMMDD-HH:MM:SS.sss
+
+    // Appends 8, 9, the body and 10 to out
+    void finish(std::string& out);
+
+private:
+    void tag(int t);
+    std::string body_;
+};
+
+} // namespace Fix
@@ -0,0 +1,468 @@
+#include "JournalSegment.h"
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+constexpr char kMagic[4] = {'G', 'Q', 'S', 'G'};
+constexpr char kIndexMagic[4] = {'G', 'Q', 'I', 'X'};
+constexpr uint16_t kVersion = 1;
+constexpr double kTickScale = 1e8;   // fixed-point scale for prices/quantities
+
+// ---- varint / zigzag helpers ----
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+void putString(std::vector<uint8_t>& out, const std::string& s) {
+    putVarint(out, s.size());
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+bool getString(const uint8_t*& p, const uint8_t* end, std::string& s) {
+    uint64_t len;
+    if (!getVarint(p, end, len) || static_cast<uint64_t>(end - p) < len) return false;
+    s.assign(reinterpret_cast<const char*>(p), len);
+    p += len;
+    return true;
+}
+
+template<typename T>
+void putRaw(std::vector<uint8_t>& out, T v) {
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &v, sizeof(T));
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+bool getRaw(const uint8_t*& p, const uint8_t* end, T& v) {
+    if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+// ---- fixed-point decimals ----
+// Exact values go out as (zigzag(ticks - prev) << 1); anything else as 1 + raw double.
+
+void putDecimal(std::vector<uint8_t>& out, double value, int64_t& prevTicks) {
+    double scaled = value * kTickScale;
+    if (std::isfinite(scaled) && std::fabs(scaled) < 1e17) {
+        int64_t ticks = std::llround(scaled);
+        int64_t delta = ticks - prevTicks;
+        if (static_cast<double>(ticks) / kTickScale == value && delta > -(1LL << 61) && delta < (1LL << 61)) {
+            putVarint(out, zigzag(delta) << 1);
+            prevTicks = ticks;
+            return;
+        }
+    }
+    putVarint(out, 1);
+    putRaw(out, value);
+}
+
+bool getDecimal(const uint8_t*& p, const uint8_t* end, double& value, int64_t& prevTicks) {
+    uint64_t v;
+    if (!getVarint(p, end, v)) return false;
+    if (v & 1) return getRaw(p, end, value);
+    prevTicks += unzigzag(v >> 1);
+    value = static_cast<double>(prevTicks) / kTickScale;
+    return true;
+}
+
+// ---- order ids: "<prefix><number>" ids are delta encoded on the number ----
+
+bool splitOrderId(const std::string& id, size_t& digitsAt, int64_t& number) {
+    size_t i = id.size();
+    while (i > 0 && id[i - 1] >= '0' && id[i - 1] <= '9') --i;
+    size_t digits = id.size() - i;
+    if (digits == 0 || digits > 18 || (digits > 1 && id[i] == '0')) return false;
+    number = std::stoll(id.substr(i));
+    digitsAt = i;
+    return true;
+}
+
+struct OrderIdCodec {
+    std::string prefix;
+    int64_t number = 0;
+    bool valid = false;
+
+    // Tags: 0 = same prefix, zigzag delta follows; 1 = literal; 2 = new prefix + number
+    void put(std::vector<uint8_t>& out, const std::string& id) {
+        size_t at;
+        int64_t n;
+        if (!splitOrderId(id, at, n)) {
+            putVarint(out, 1);
+            putString(out, id);
+            valid = false;
+            return;
+        }
+        if (valid && id.compare(0, at, prefix) == 0 && prefix.size() == at) {
+            putVarint(out, 0);
+            putVarint(out, zigzag(n - number));
+        } else {
+            prefix = id.substr(0, at);
+            putVarint(out, 2);
+            putString(out, prefix);
+            putVarint(out, zigzag(n));
+        }
+        number = n;
+        valid = true;
+    }
+
+    bool get(const uint8_t*& p, const uint8_t* end, std::string& id) {
+        uint64_t tag, v;
+        if (!getVarint(p, end, tag)) return false;
+        if (tag == 1) {
+            valid = false;
+            return getString(p, end, id);
+        }
+        if (tag == 2) {
+            if (!getString(p, end, prefix) || !getVarint(p, end, v)) return false;
+            number = unzigzag(v);
+        } else {
+            if (!valid || !getVarint(p, end, v)) return false;
+            number += unzigzag(v);
+        }
+        valid = true;
+        id = prefix + std::to_string(number);
+        return true;
+    }
+};
+
+bool hasPriceAndQty(CommandRecord::Kind kind) { return kind != CommandRecord::Kind::CANCEL; }
+
+// Column order inside a block
+enum Column { SEQ, JTS, KIND, SIDE_TYPE, SYMBOL, ORDER_ID, PRICE, QTY, ORDER_TS, COLUMN_COUNT };
+
+// Side/type byte: bit 0 side, bits 1-6 OrderType, bit 7 set for icebergs
+constexpr uint8_t kIcebergFlag = 0x80;
+
+void encodeBlock(const CommandRecord* recs, size_t n, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> cols[COLUMN_COUNT];
+    std::unordered_map<std::string, uint64_t> symbolIds;
+    std::vector<const std::string*> symbols;
+
+    uint64_t prevSeq = 0;
+    long long prevTs = 0;
+    int64_t prevPrice = 0;
+    OrderIdCodec ids;
+
+    for (size_t i = 0; i < n; ++i) {
+        const CommandRecord& r = recs[i];
+        const Order& o = r.order;
+        putVarint(cols[SEQ], zigzag(static_cast<int64_t>(r.seq - prevSeq)));
+        putVarint(cols[JTS], zigzag(r.journalTs - prevTs));
+        cols[KIND].push_back(static_cast<uint8_t>(r.kind));
+        ids.put(cols[ORDER_ID], o.orderId);
+        prevSeq = r.seq;
+        prevTs = r.journalTs;
+
+        if (r.kind == CommandRecord::Kind::NEW) {
+            cols[SIDE_TYPE].push_back(static_cast<uint8_t>(
+                (o.side == Side::SELL ? 1 : 0) | (static_cast<uint8_t>(o.type) << 1) |
+                (o.isIceberg() ? kIcebergFlag : 0)));
+            auto [it, inserted] = symbolIds.emplace(o.symbol, symbols.size());
+            if (inserted) symbols.push_back(&it->first);
+            putVarint(cols[SYMBOL], it->second);
+            putVarint(cols[ORDER_TS], zigzag(o.timestamp - r.journalTs));
+        }
+        if (hasPriceAndQty(r.kind)) {
+            putDecimal(cols[PRICE], o.price, prevPrice);
+            // Conditional NEWs carry their trigger right behind the price
+            if (r.kind == CommandRecord::Kind::NEW && o.isConditional()) {
+                putDecimal(cols[PRICE], o.stopPrice, prevPrice);
+            }
+            int64_t noDelta = 0;
+            putDecimal(cols[QTY], o.quantity, noDelta);
+            if (r.kind == CommandRecord::Kind::NEW && o.isIceberg()) {
+                putDecimal(cols[QTY], o.displayQty, noDelta);
+            }
+        }
+    }
+
+    putVarint(out, n);
+    putVarint(out, symbols.size());
+    for (const auto* s : symbols) putString(out, *s);
+    for (const auto& col : cols) {
+        putVarint(out, col.size());
+        out.insert(out.end(), col.begin(), col.end());
+    }
+}
+
+// expectedCount comes from the block index; counts are checked against it and
+// against the bytes left before anything is sized from them
+bool decodeBlock(const uint8_t* p, const uint8_t* end, uint64_t expectedCount,
+                 std::vector<CommandRecord>& out) {
+    uint64_t n, symbolCount;
+    if (!getVarint(p, end, n) || !getVarint(p, end, symbolCount)) return false;
+    // Every record takes at least its kind byte and every symbol its length byte
+    uint64_t left = static_cast<uint64_t>(end - p);
+    if (n != expectedCount || n > left || symbolCount > left) return false;
+    std::vector<std::string> symbols(symbolCount);
+    for (auto& s : symbols) {
+        if (!getString(p, end, s)) return false;
+    }
+
+    // Column cursors
+    const uint8_t* cur[COLUMN_COUNT];
+    const uint8_t* colEnd[COLUMN_COUNT];
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        uint64_t len;
+        if (!getVarint(p, end, len) || static_cast<uint64_t>(end - p) < len) return false;
+        cur[c] = p;
+        colEnd[c] = p + len;
+        p += len;
+    }
+
+    uint64_t seq = 0;
+    long long ts = 0;
+    int64_t prevPrice = 0;
+    OrderIdCodec ids;
+    out.resize(n);
+
+    for (uint64_t i = 0; i < n; ++i) {
+        CommandRecord& r = out[i];
+        Order& o = r.order;
+        uint64_t v;
+        bool iceberg = false;
+        if (!getVarint(cur[SEQ], colEnd[SEQ], v)) return false;
+        seq += unzigzag(v);
+        if (!getVarint(cur[JTS], colEnd[JTS], v)) return false;
+        ts += unzigzag(v);
+        if (cur[KIND] >= colEnd[KIND]) return false;
+        r.seq = seq;
+        r.journalTs = ts;
+        r.kind = static_cast<CommandRecord::Kind>(*cur[KIND]++);
+        if (!ids.get(cur[ORDER_ID], colEnd[ORDER_ID], o.orderId)) return false;
+
+        if (r.kind == CommandRecord::Kind::NEW) {
+            if (cur[SIDE_TYPE] >= colEnd[SIDE_TYPE]) return false;
+            uint8_t st = *cur[SIDE_TYPE]++;
+            o.side = (st & 1) ? Side::SELL : Side::BUY;
+            o.type = static_cast<OrderType>((st & ~kIcebergFlag) >> 1);
+            iceberg = (st & kIcebergFlag) != 0;
+            if (!getVarint(cur[SYMBOL], colEnd[SYMBOL], v) || v >= symbols.size()) return false;
+            o.symbol = symbols[v];
+            if (!getVarint(cur[ORDER_TS], colEnd[ORDER_TS], v)) return false;
+            o.timestamp = ts + unzigzag(v);
+        }
+        if (hasPriceAndQty(r.kind)) {
+            int64_t noDelta = 0;
+            if (!getDecimal(cur[PRICE], colEnd[PRICE], o.price, prevPrice)) return false;
+            if (r.kind == CommandRecord::Kind::NEW && o.isConditional() &&
+                !getDecimal(cur[PRICE], colEnd[PRICE], o.stopPrice, prevPrice)) return false;
+            if (!getDecimal(cur[QTY], colEnd[QTY], o.quantity, noDelta)) return false;
+            if (iceberg && !getDecimal(cur[QTY], colEnd[QTY], o.displayQty, noDelta)) return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    std::string field;
+    std::istringstream ss(line);
+    while (std::getline(ss, field, '|')) fields.push_back(field);
+    return fields;
+}
+
+} // namespace
+
+// Text layouts written by Persistence in COMMANDS mode:
+//   <ts>|CMD|seq|NEW|orderId|symbol|side|type|price|quantity|timestamp[|stopPrice[|displayQty]]
+//   <ts>|CMD|seq|CANCEL|orderId
+//   <ts>|CMD|seq|AMEND|orderId|price|quantity
+bool parseCommandLine(const std::string& line, CommandRecord& record) {
+    auto f = splitFields(line);
+    if (f.size() < 5 || f[1] != "CMD") return false;
+    try {
+        record = CommandRecord{};
+        record.journalTs = std::stoll(f[0]);
+        record.seq = std::stoull(f[2]);
+        Order& o = record.order;
+        o.orderId = f[4];
+        if (f[3] == "NEW" && f.size() >= 11) {
+            record.kind = CommandRecord::Kind::NEW;
+            o.symbol = f[5];
+            o.side = (f[6] == "BUY" ? Side::BUY : Side::SELL);
+            o.type = static_cast<OrderType>(std::stoi(f[7]));
+            o.price = std::stod(f[8]);
+            o.quantity = std::stod(f[9]);
+            o.timestamp = std::stoll(f[10]);
+            if (f.size() >= 12) o.stopPrice = std::stod(f[11]);
+            if (f.size() >= 13) o.displayQty = std::stod(f[12]);
+        } else if (f[3] == "CANCEL") {
+            record.kind = CommandRecord::Kind::CANCEL;
+        } else if (f[3] == "AMEND" && f.size() >= 7) {
+            record.kind = CommandRecord::Kind::AMEND;
+            o.price = std::stod(f[5]);
+            o.quantity = std::stod(f[6]);
+        } else {
+            return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+namespace JournalSegment {
+
+size_t encode(const std::vector<CommandRecord>& records, const std::string& path,
+              size_t blockRecords) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open() || blockRecords == 0) return 0;
+
+    std::vector<uint8_t> buf;
+    buf.insert(buf.end(), kMagic, kMagic + 4);
+    putRaw(buf, kVersion);
+    putRaw(buf, uint16_t{0});
+
+    std::vector<BlockIndexEntry> index;
+    for (size_t start = 0; start < records.size(); start += blockRecords) {
+        size_t n = std::min(blockRecords, records.size() - start);
+        index.push_back({buf.size(), records[start].seq, records[start].journalTs,
+                         static_cast<uint32_t>(n)});
+        encodeBlock(&records[start], n, buf);
+    }
+
+    uint64_t indexOffset = buf.size();
+    for (const auto& e : index) {
+        putRaw(buf, e.offset);
+        putRaw(buf, e.firstSeq);
+        putRaw(buf, static_cast<int64_t>(e.firstTs));
+        putRaw(buf, e.recordCount);
+    }
+    putRaw(buf, static_cast<uint32_t>(index.size()));
+    putRaw(buf, indexOffset);
+    buf.insert(buf.end(), kIndexMagic, kIndexMagic + 4);
+
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    return out.good() ? buf.size() : 0;
+}
+
+size_t encodeTextSegment(const std::string& textPath, const std::string& segmentPath,
+                         size_t* commandCount) {
+    std::ifstream in(textPath);
+    if (!in.is_open()) return 0;
+
+    std::vector<CommandRecord> records;
+    std::string line;
+    CommandRecord record;
+    while (std::getline(in, line)) {
+        if (parseCommandLine(line, record)) records.push_back(std::move(record));
+    }
+    if (commandCount) *commandCount = records.size();
+    return encode(records, segmentPath);
+}
+
+bool isSegmentFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    in.read(magic, 4);
+    return in.gcount() == 4 && std::memcmp(magic, kMagic, 4) == 0;
+}
+
+Reader::Reader(const std::string& path) : in_(path, std::ios::binary) {
+    if (!in_.is_open()) return;
+
+    constexpr size_t footerSize = sizeof(uint32_t) + sizeof(uint64_t) + 4;
+    constexpr size_t entrySize = 2 * sizeof(uint64_t) + sizeof(int64_t) + sizeof(uint32_t);
+    in_.seekg(0, std::ios::end);
+    auto fileSize = static_cast<uint64_t>(in_.tellg());
+    if (fileSize < 8 + footerSize) return;
+
+    uint8_t footer[footerSize];
+    in_.seekg(fileSize - footerSize);
+    in_.read(reinterpret_cast<char*>(footer), footerSize);
+    if (std::memcmp(footer + footerSize - 4, kIndexMagic, 4) != 0) return;
+
+    uint32_t blockCount;
+    uint64_t indexOffset;
+    std::memcpy(&blockCount, footer, sizeof(blockCount));
+    std::memcpy(&indexOffset, footer + sizeof(blockCount), sizeof(indexOffset));
+    if (indexOffset > fileSize || indexOffset + blockCount * entrySize + footerSize != fileSize) return;
+
+    std::vector<uint8_t> raw(blockCount * entrySize);
+    in_.seekg(indexOffset);
+    in_.read(reinterpret_cast<char*>(raw.data()), raw.size());
+    if (!in_.good()) return;
+    const uint8_t* p = raw.data();
+    const uint8_t* end = p + raw.size();
+    index_.resize(blockCount);
+    for (auto& e : index_) {
+        int64_t ts;
+        if (!getRaw(p, end, e.offset) || !getRaw(p, end, e.firstSeq) ||
+            !getRaw(p, end, ts) || !getRaw(p, end, e.recordCount)) {
+            index_.clear();
+            return;
+        }
+        e.firstTs = ts;
+    }
+    // Block i spans [offset_i, offset_{i+1}); the last ends at the index
+    indexOffset_ = indexOffset;
+    if (!index_.empty() && index_[0].offset < 8) return;   // inside the header
+    for (size_t i = 0; i < index_.size(); ++i) {
+        uint64_t next = (i + 1 < index_.size()) ? index_[i + 1].offset : indexOffset;
+        if (index_[i].offset >= next) return;
+    }
+    buffer_.reserve(1 << 16);
+    ok_ = in_.good();
+}
+
+bool Reader::readBlock(size_t i, std::vector<CommandRecord>& out) {
+    out.clear();
+    if (!ok_ || i >= index_.size()) return false;
+
+    uint64_t begin = index_[i].offset;
+    uint64_t end = (i + 1 < index_.size()) ? index_[i + 1].offset : indexOffset_;
+
+    buffer_.resize(end - begin);
+    in_.seekg(begin);
+    in_.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size());
+    if (!in_.good()) return false;
+    return decodeBlock(buffer_.data(), buffer_.data() + buffer_.size(), index_[i].recordCount, out);
+}
+
+size_t Reader::findBlock(uint64_t seq) const {
+    size_t lo = 0, hi = index_.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (index_[mid].firstSeq <= seq) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo == 0 ? 0 : lo - 1;
+}
+
+bool Reader::readAll(std::vector<CommandRecord>& out) {
+    out.clear();
+    std::vector<CommandRecord> block;
+    for (size_t i = 0; i < index_.size(); ++i) {
+        if (!readBlock(i, block)) return false;
+        out.insert(out.end(), std::make_move_iterator(block.begin()),
+                   std::make_move_iterator(block.end()));
+    }
+    return ok_;
+}
+
+} // namespace JournalSegment
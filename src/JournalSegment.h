@@ -0,0 +1,86 @@
+#pragma once
+#include "Order.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// One accepted input command from a command-sourced journal (JournalMode::COMMANDS)
+struct CommandRecord {
+    enum class Kind : uint8_t { NEW = 0, CANCEL = 1, AMEND = 2 };
+
+    uint64_t seq = 0;
+    long long journalTs = 0;   // wall-clock time the record was written
+    Kind kind = Kind::NEW;
+    Order order{};             // NEW: full order; CANCEL: orderId; AMEND: orderId, price, quantity
+};
+
+// Parse one text journal line ("<ts>|CMD|seq|...") into a command record.
+// Returns false for non-command lines (TRADE, EVENTS-mode records, garbage).
+bool parseCommandLine(const std::string& line, CommandRecord& record);
+
+// Sealed journal segments re-encoded column by column.
+//
+// File layout (all integers little-endian or LEB128 varints):
+//   header   "GQSG" u16 version u16 reserved
+//   blocks   per block: varint recordCount, symbol dictionary, then one
+//            length-prefixed column each for seq, journal ts, kind, side/type,
+//            symbol, order id, price, quantity and order timestamp (a
+//            conditional NEW's stop price follows its price in the price column,
+//            an iceberg NEW's display size its quantity in the quantity column)
+//   index    per block: u64 offset, u64 firstSeq, i64 firstTs, u32 recordCount
+//   footer   u32 blockCount, u64 indexOffset, "GQIX"
+//
+// Sequence numbers, timestamps, numeric order-id suffixes and prices are
+// delta encoded against the previous record in the block. Prices and
+// quantities are stored as 1e-8 fixed-point ticks when that is exact, and as
+// raw doubles otherwise, so decoding always reproduces the journaled value.
+namespace JournalSegment {
+
+constexpr size_t kDefaultBlockRecords = 4096;
+
+struct BlockIndexEntry {
+    uint64_t offset = 0;
+    uint64_t firstSeq = 0;
+    long long firstTs = 0;
+    uint32_t recordCount = 0;
+};
+
+// Encode commands into a segment file. Returns bytes written (0 on failure).
+size_t encode(const std::vector<CommandRecord>& records, const std::string& path,
+              size_t blockRecords = kDefaultBlockRecords);
+
+// Re-encode a sealed text journal segment. Non-command lines are skipped.
+size_t encodeTextSegment(const std::string& textPath, const std::string& segmentPath,
+                         size_t* commandCount = nullptr);
+
+// True if the file starts with the segment magic
+bool isSegmentFile(const std::string& path);
+
+// Streams blocks out of a segment file, decoding each block straight into
+// CommandRecords (no intermediate text).
+class Reader {
+public:
+    explicit Reader(const std::string& path);
+
+    bool ok() const { return ok_; }
+    const std::vector<BlockIndexEntry>& index() const { return index_; }
+
+    // Decode block i into out (cleared first)
+    bool readBlock(size_t i, std::vector<CommandRecord>& out);
+
+    // Index of the first block that may contain seq (binary search on the block index)
+    size_t findBlock(uint64_t seq) const;
+
+    // Convenience: decode every block in order
+    bool readAll(std::vector<CommandRecord>& out);
+
+private:
+    std::ifstream in_;
+    std::vector<BlockIndexEntry> index_;
+    uint64_t indexOffset_ = 0;
+    std::vector<uint8_t> buffer_;
+    bool ok_ = false;
+};
+
+} // namespace JournalSegment
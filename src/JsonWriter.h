@@ -0,0 +1,74 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Minimal append-only JSON writer for the hot market-data path.
+// Writes straight into a caller-owned buffer (reuse it to stay allocation-free);
+// numbers are quoted strings, as on the existing wire schema, formatted with
+// std::to_chars shortest round-trip.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out) {}
+    
+    void raw(char c) { out_.push_back(c); }
+    void raw(std::string_view s) { out_.append(s); }
+    
+    // "key":
+    void key(std::string_view k) {
+        out_.push_back('"');
+        out_.append(k);
+        out_.append("\":", 2);
+    }
+    
+    void string(std::string_view s) {
+        out_.push_back('"');
+        for (char c : s) {
+            switch (c) {
+                case '"':  out_.append("\\\"", 2); break;
+                case '\\': out_.append("\\\\", 2); break;
+                case '\n': out_.append("\\n", 2); break;
+                case '\r': out_.append("\\r", 2); break;
+                case '\t': out_.append("\\t", 2); break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        static const char hex[] = "0123456789abcdef";
+                        char esc[6] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xf], hex[c & 0xf]};
+                        out_.append(esc, 6);
+                    } else {
+                        out_.push_back(c);
+                    }
+            }
+        }
+        out_.push_back('"');
+    }
+    
+    // Quoted shortest round-trip decimal, e.g. "46000.5", "1e-07"
+    void quotedNumber(double v) {
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.push_back('"');
+        out_.append(buf, res.ptr - buf);
+        out_.push_back('"');
+    }
+    
+    void quotedNumber(long long v) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.push_back('"');
+        out_.append(buf, res.ptr - buf);
+        out_.push_back('"');
+    }
+    
+    void quotedNumber(uint64_t v) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.push_back('"');
+        out_.append(buf, res.ptr - buf);
+        out_.push_back('"');
+    }
+    
+private:
+    std::string& out_;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "OrderBook.h"
+#include <functional>
+#include <map>
+#include <string>
+
+// Full-depth L2 book for one symbol, rebuilt from the delta feed.
+// MarketDataServer keeps one per symbol so subscription and resync
+// snapshots never touch the engine's book lock.
+class L2BookCache {
+public:
+    // Apply the next delta. Returns false (and leaves the cache untouched)
+    // when delta.seq does not directly follow the cached seq.
+    bool apply(const L2Delta& delta) {
+        if (delta.seq != seq_ + 1) return false;
+        for (const auto& level : delta.changes) {
+            if (level.side == Side::BUY) setLevel(bids_, level.price, level.quantity);
+            else setLevel(asks_, level.price, level.quantity);
+        }
+        seq_ = delta.seq;
+        timestamp_ = delta.timestamp;
+        return true;
+    }
+
+    // Replace the cached state with a full-depth snapshot
+    void reset(const L2Update& update) {
+        bids_.clear();
+        asks_.clear();
+        for (const auto& [price, qty] : update.bids) bids_[price] = qty;
+        for (const auto& [price, qty] : update.asks) asks_[price] = qty;
+        seq_ = update.seq;
+        timestamp_ = update.timestamp;
+    }
+
+    // Fill update with the cached book (update's vectors are reused)
+    void snapshot(const std::string& symbol, L2Update& update) const {
+        update.symbol = symbol;
+        update.seq = seq_;
+        update.timestamp = timestamp_;
+        update.bids.assign(bids_.begin(), bids_.end());
+        update.asks.assign(asks_.begin(), asks_.end());
+    }
+
+    uint64_t seq() const { return seq_; }
+
+private:
+    template<typename Levels>
+    static void setLevel(Levels& levels, double price, double qty) {
+        if (qty > 0) levels[price] = qty;
+        else levels.erase(price);
+    }
+
+    std::map<double, double, std::greater<double>> bids_;
+    std::map<double, double> asks_;
+    uint64_t seq_ = 0;
+    long long timestamp_ = 0;
+};
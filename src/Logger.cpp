@@ -0,0 +1,528 @@
+#include "Logger.h"
+#include "CivilTime.h"
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Log {
+std::atomic<uint8_t> g_runtimeLevel{static_cast<uint8_t>(LogLevel::Info)};
+}
+
+namespace {
+
+using Log::ArgType;
+using Log::Format;
+using Log::kRecordHeader;
+
+constexpr uint16_t kPadId = 0xFFFF;      // ring only: rest of the buffer is unused, continue at 0
+constexpr uint16_t kDefineId = 0xFFFE;   // binary files only: a Format, before its first record
+constexpr size_t kMaxFormats = 4096;     // call sites; ids past this are dropped by the backend
+constexpr size_t kMinRingBytes = 64 * 1024;   // the largest record is ~16.5 KiB
+constexpr char kFileMagic[8] = {'M', 'E', 'L', 'O', 'G', '0', '0', '1'};
+
+template<typename T>
+T load(const char* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+template<typename T>
+void append(std::string& out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+// ---- formatting ----
+
+// "YYYY-MM-DD HH:MM:SS.uuuuuu " in UTC
+void appendTimestamp(std::string& out, int64_t nanos) {
+    long long us = nanos / 1000;
+    long long days = us / 86400000000LL;
+    long long usOfDay = us % 86400000000LL;
+    if (usOfDay < 0) {
+        usOfDay += 86400000000LL;
+        --days;
+    }
+    int year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    char buf[27];
+    char* p = putDigits(buf, static_cast<unsigned>(year), 4);
+    *p++ = '-';
+    p = putDigits(p, month, 2);
+    *p++ = '-';
+    p = putDigits(p, day, 2);
+    *p++ = ' ';
+    p = putDigits(p, static_cast<unsigned>(usOfDay / 3600000000LL), 2);
+    *p++ = ':';
+    p = putDigits(p, static_cast<unsigned>(usOfDay / 60000000 % 60), 2);
+    *p++ = ':';
+    p = putDigits(p, static_cast<unsigned>(usOfDay / 1000000 % 60), 2);
+    *p++ = '.';
+    p = putDigits(p, static_cast<unsigned>(usOfDay % 1000000), 6);
+    *p++ = ' ';
+    out.append(buf, p);
+}
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info:  return "INFO ";
+        case LogLevel::Warn:  return "WARN ";
+        case LogLevel::Error: return "ERROR";
+        default:              return "?????";
+    }
+}
+
+template<typename T>
+void appendNumber(std::string& out, T value) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+}
+
+// One argument; nullptr when the record is too short for it
+const char* appendArg(std::string& out, ArgType type, const char* p, const char* end) {
+    if (type == ArgType::STR) {
+        if (end - p < 4) return nullptr;
+        uint32_t n = load<uint32_t>(p);
+        if (static_cast<size_t>(end - p - 4) < n) return nullptr;
+        out.append(p + 4, n);
+        return p + 4 + n;
+    }
+    if (end - p < 8) return nullptr;
+    switch (type) {
+        case ArgType::I64:  appendNumber(out, load<int64_t>(p)); break;
+        case ArgType::U64:  appendNumber(out, load<uint64_t>(p)); break;
+        case ArgType::F64:  appendNumber(out, load<double>(p)); break;
+        case ArgType::BOOL: out += load<int64_t>(p) ? "true" : "false"; break;
+        case ArgType::CHAR: out.push_back(static_cast<char>(load<int64_t>(p))); break;
+        default: return nullptr;
+    }
+    return p + 8;
+}
+
+// "timestamp LEVEL [file:line] text\n"; used by the backend and by decodeFile so both agree
+void formatRecord(std::string& out, const Format& format, const char* record, size_t size) {
+    appendTimestamp(out, load<int64_t>(record + 8));
+    out += levelName(format.level);
+    out += " [";
+    out += format.file;
+    out.push_back(':');
+    appendNumber(out, format.line);
+    out += "] ";
+
+    const char* p = record + kRecordHeader;
+    const char* end = record + size;
+    size_t arg = 0;
+    std::string_view text = format.text;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '{' && i + 1 < text.size() && text[i + 1] == '}' && arg < format.argCount && p) {
+            p = appendArg(out, format.args[arg++], p, end);
+            ++i;
+        } else {
+            out.push_back(text[i]);
+        }
+    }
+    // Arguments without a placeholder are appended rather than lost
+    for (; arg < format.argCount && p; ++arg) {
+        out.push_back(' ');
+        p = appendArg(out, format.args[arg], p, end);
+    }
+    out.push_back('\n');
+}
+
+// Definition record: u16 kDefineId  u16 size  u16 formatId  u8 level  u8 argCount
+//                    u32 line  u16 fileLen  u16 textLen  then types, file, text, padded to 8
+void appendDefinition(std::string& out, uint16_t id, const Format& format) {
+    size_t fileLen = std::min<size_t>(format.file.size(), 1024);
+    size_t textLen = std::min<size_t>(format.text.size(), 16 * 1024);
+    size_t size = (16 + format.argCount + fileLen + textLen + 7) & ~size_t{7};
+    size_t start = out.size();
+    append(out, kDefineId);
+    append(out, static_cast<uint16_t>(size));
+    append(out, id);
+    append(out, static_cast<uint8_t>(format.level));
+    append(out, format.argCount);
+    append(out, format.line);
+    append(out, static_cast<uint16_t>(fileLen));
+    append(out, static_cast<uint16_t>(textLen));
+    for (size_t i = 0; i < format.argCount; ++i) out.push_back(static_cast<char>(format.args[i]));
+    out.append(format.file.data(), fileLen);
+    out.append(format.text.data(), textLen);
+    out.resize(start + size, '\0');
+}
+
+// ---- per-thread ring ----
+
+// Single-producer single-consumer ring of whole records. head_ and tail_ are
+// byte counts that only grow; a record never straddles the end of the buffer.
+class Ring {
+public:
+    explicit Ring(size_t bytes) {
+        size_t capacity = kMinRingBytes;
+        while (capacity < bytes) capacity <<= 1;
+        buffer_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    // Producer side
+    char* reserve(size_t size) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        size_t offset = head & mask_;
+        uint64_t start = size > buffer_.size() - offset ? head + (buffer_.size() - offset) : head;
+        if (start + size - tailCache_ > buffer_.size()) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (start + size - tailCache_ > buffer_.size()) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        if (start != head) std::memcpy(&buffer_[offset], &kPadId, 2);
+        pending_ = start + size;
+        return &buffer_[start & mask_];
+    }
+
+    void commit() { head_.store(pending_, std::memory_order_release); }
+
+    // Consumer side: fn(record, size) for every published record; returns how many
+    template<typename Fn>
+    size_t drain(Fn&& fn) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (tail < head) {
+            const char* record = &buffer_[tail & mask_];
+            if (load<uint16_t>(record) == kPadId) {
+                tail += buffer_.size() - (tail & mask_);
+                continue;
+            }
+            uint16_t size = load<uint16_t>(record + 2);
+            fn(record, size);
+            tail += size;
+            ++count;
+        }
+        tail_.store(tail, std::memory_order_release);
+        return count;
+    }
+
+    uint64_t takeDropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+    std::atomic<bool> retired{false};   // owning thread has exited
+
+private:
+    std::vector<char> buffer_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<uint64_t> head_{0};
+    uint64_t pending_ = 0;      // producer only
+    uint64_t tailCache_ = 0;    // producer only
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// ---- backend ----
+
+class Backend {
+public:
+    static Backend& instance() {
+        static Backend backend;
+        return backend;
+    }
+
+    Backend() { thread_ = std::thread([this] { run(); }); }
+
+    ~Backend() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        thread_.join();
+        closeFiles();
+    }
+
+    std::shared_ptr<Ring> addRing() {
+        auto ring = std::make_shared<Ring>(ringBytes_.load(std::memory_order_relaxed));
+        std::lock_guard<std::mutex> lock(ringsMu_);
+        rings_.push_back(ring);
+        return ring;
+    }
+
+    uint16_t registerFormat(const Format& format) {
+        std::lock_guard<std::mutex> lock(formatsMu_);
+        if (formatCount_ >= kMaxFormats) return static_cast<uint16_t>(kMaxFormats);
+        formatStore_.push_back(std::make_unique<Format>(format));
+        formats_[formatCount_].store(formatStore_.back().get(), std::memory_order_release);
+        return static_cast<uint16_t>(formatCount_++);
+    }
+
+    void configure(const LogConfig& config) {
+        flush();   // earlier records go to the sinks they were logged under
+        std::lock_guard<std::mutex> lock(sinkMu_);
+        Log::g_runtimeLevel.store(static_cast<uint8_t>(config.level), std::memory_order_relaxed);
+        ringBytes_.store(config.ringBytes, std::memory_order_relaxed);
+        console_ = config.console;
+        closeFiles();
+        if (!config.textFile.empty()) {
+            textFile_ = std::fopen(config.textFile.c_str(), "ab");
+        }
+        if (!config.binaryFile.empty()) {
+            binaryFile_ = std::fopen(config.binaryFile.c_str(), "ab");
+            if (binaryFile_) {
+                std::fseek(binaryFile_, 0, SEEK_END);
+                if (std::ftell(binaryFile_) == 0) std::fwrite(kFileMagic, 1, sizeof(kFileMagic), binaryFile_);
+                defined_.assign(kMaxFormats, false);
+            }
+        }
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mu_);
+        uint64_t ticket = ++flushRequested_;
+        wake_.notify_all();
+        flushed_.wait(lock, [&] { return flushDone_ >= ticket; });
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void run() {
+        for (;;) {
+            uint64_t ticket;
+            bool stopping;
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                ticket = flushRequested_;
+                stopping = stopping_;
+            }
+            size_t records = drainAll();
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                if (flushDone_ < ticket) {
+                    flushDone_ = ticket;
+                    flushed_.notify_all();
+                }
+            }
+            if (records > 0) continue;
+            if (stopping) return;
+            std::unique_lock<std::mutex> lock(mu_);
+            wake_.wait_for(lock, std::chrono::milliseconds(1),
+                           [&] { return stopping_ || flushRequested_ != ticket; });
+        }
+    }
+
+    // One pass over every ring; the formatted text and raw records are written in one go per sink
+    size_t drainAll() {
+        std::lock_guard<std::mutex> sinkLock(sinkMu_);
+        bool wantText = console_ || textFile_;
+        size_t records = 0;
+        uint64_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(ringsMu_);
+            for (auto it = rings_.begin(); it != rings_.end();) {
+                Ring& ring = **it;
+                bool retired = ring.retired.load(std::memory_order_acquire);
+                records += ring.drain([&](const char* record, size_t size) {
+                    uint16_t id = load<uint16_t>(record);
+                    const Format* format = id < kMaxFormats ? formats_[id].load(std::memory_order_acquire) : nullptr;
+                    if (!format) return;
+                    if (wantText) formatRecord(text_, *format, record, size);
+                    if (binaryFile_) {
+                        if (!defined_[id]) {
+                            appendDefinition(binary_, id, *format);
+                            defined_[id] = true;
+                        }
+                        binary_.append(record, size);
+                    }
+                });
+                dropped += ring.takeDropped();
+                it = retired ? rings_.erase(it) : it + 1;   // drained after the owner stopped writing
+            }
+        }
+        if (dropped > 0) {
+            dropped_.fetch_add(dropped, std::memory_order_relaxed);
+            if (wantText) {
+                appendTimestamp(text_, Log::nowNanos());
+                text_ += "WARN  [Logger] ";
+                appendNumber(text_, dropped);
+                text_ += " records dropped, ring full\n";
+            }
+        }
+        writeOut();
+        return records;
+    }
+
+    void writeOut() {
+        if (!text_.empty()) {
+            if (console_) {
+                std::fwrite(text_.data(), 1, text_.size(), stdout);
+                std::fflush(stdout);
+            }
+            if (textFile_) {
+                std::fwrite(text_.data(), 1, text_.size(), textFile_);
+                std::fflush(textFile_);
+            }
+            text_.clear();
+        }
+        if (!binary_.empty()) {
+            std::fwrite(binary_.data(), 1, binary_.size(), binaryFile_);
+            std::fflush(binaryFile_);
+            binary_.clear();
+        }
+    }
+
+    void closeFiles() {
+        if (textFile_) std::fclose(textFile_);
+        if (binaryFile_) std::fclose(binaryFile_);
+        textFile_ = nullptr;
+        binaryFile_ = nullptr;
+    }
+
+    // Call sites
+    std::mutex formatsMu_;
+    std::vector<std::unique_ptr<Format>> formatStore_;
+    std::atomic<const Format*> formats_[kMaxFormats] = {};
+    size_t formatCount_ = 0;
+
+    // Producer rings
+    std::mutex ringsMu_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::atomic<size_t> ringBytes_{1 << 20};
+    std::atomic<uint64_t> dropped_{0};
+
+    // Sinks; backend thread only, except configure()
+    std::mutex sinkMu_;
+    bool console_ = true;
+    std::FILE* textFile_ = nullptr;
+    std::FILE* binaryFile_ = nullptr;
+    std::vector<bool> defined_;   // format written to the current binary file
+    std::string text_;
+    std::string binary_;
+
+    // Wake-ups and flush tickets
+    std::mutex mu_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    uint64_t flushRequested_ = 0;
+    uint64_t flushDone_ = 0;
+    bool stopping_ = false;
+
+    std::thread thread_;
+};
+
+// Marks the ring retired when its thread exits; the backend drains and drops it
+struct LocalRing {
+    std::shared_ptr<Ring> ring;
+    ~LocalRing() {
+        if (ring) ring->retired.store(true, std::memory_order_release);
+    }
+};
+
+thread_local LocalRing t_ring;
+
+Ring& localRing() {
+    if (!t_ring.ring) t_ring.ring = Backend::instance().addRing();
+    return *t_ring.ring;
+}
+
+} // namespace
+
+namespace Log {
+
+void configure(const LogConfig& config) { Backend::instance().configure(config); }
+
+void flush() { Backend::instance().flush(); }
+
+uint64_t dropped() { return Backend::instance().dropped(); }
+
+uint16_t registerFormat(const Format& format) { return Backend::instance().registerFormat(format); }
+
+char* reserve(size_t size) { return localRing().reserve(size); }
+
+void commit() { t_ring.ring->commit(); }
+
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool decodeFile(const std::string& path, std::ostream& out, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(kFileMagic) || std::memcmp(data.data(), kFileMagic, sizeof(kFileMagic)) != 0) {
+        error = "not a binary log file";
+        return false;
+    }
+
+    // Formats as defined in the file; the views point into the owned strings
+    struct Defined {
+        std::string file;
+        std::string text;
+        Format format;
+    };
+    std::vector<std::unique_ptr<Defined>> formats(kMaxFormats);
+    std::string line;
+
+    size_t pos = sizeof(kFileMagic);
+    while (pos < data.size()) {
+        const char* record = data.data() + pos;
+        size_t remaining = data.size() - pos;
+        if (remaining < 4) {
+            error = "truncated record at offset " + std::to_string(pos);
+            return false;
+        }
+        uint16_t id = load<uint16_t>(record);
+        uint16_t size = load<uint16_t>(record + 2);
+        if (size < kRecordHeader || size % 8 != 0 || size > remaining) {
+            error = "bad record size at offset " + std::to_string(pos);
+            return false;
+        }
+
+        if (id == kDefineId) {
+            uint16_t formatId = load<uint16_t>(record + 4);
+            uint8_t argCount = load<uint8_t>(record + 7);
+            uint16_t fileLen = load<uint16_t>(record + 12);
+            uint16_t textLen = load<uint16_t>(record + 14);
+            if (formatId >= kMaxFormats || argCount > kMaxArgs || 16u + argCount + fileLen + textLen > size) {
+                error = "bad format definition at offset " + std::to_string(pos);
+                return false;
+            }
+            auto defined = std::make_unique<Defined>();
+            const char* p = record + 16;
+            defined->format.level = static_cast<LogLevel>(load<uint8_t>(record + 6));
+            defined->format.line = load<uint32_t>(record + 8);
+            defined->format.argCount = argCount;
+            for (size_t i = 0; i < argCount; ++i) defined->format.args[i] = static_cast<ArgType>(*p++);
+            defined->file.assign(p, fileLen);
+            defined->text.assign(p + fileLen, textLen);
+            defined->format.file = defined->file;
+            defined->format.text = defined->text;
+            formats[formatId] = std::move(defined);
+        } else {
+            if (id >= kMaxFormats || !formats[id]) {
+                error = "record for undefined format " + std::to_string(id) + " at offset " + std::to_string(pos);
+                return false;
+            }
+            line.clear();
+            formatRecord(line, formats[id]->format, record, size);
+            out << line;
+        }
+        pos += size;
+    }
+    return true;
+}
+
+} // namespace Log
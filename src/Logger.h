@@ -0,0 +1,206 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Asynchronous logger for the hot path.
+//
+//   LOG_INFO("order {} {} {}@{}", order.orderId, order.symbol, order.quantity, order.price);
+//
+// The calling thread does not format anything: it copies a compact binary
+// record (format id, timestamp, raw arguments) into its own single-producer
+// ring and returns. A background thread drains every thread's ring, formats
+// the records ("{}" placeholders) and writes them to the configured sinks:
+// stdout, a text file and/or a binary file that log_decode turns back into
+// text. When a ring is full the record is dropped and counted, never waited on.
+//
+// Levels are filtered twice: at compile time, calls below ENGINE_LOG_LEVEL
+// (0=Trace .. 5=Off) compile to nothing; at run time, LogConfig::level.
+//
+// Arguments may be integers, floating point, bool, char, enums and anything
+// convertible to std::string_view (strings longer than kMaxStringArg are cut).
+
+#ifndef ENGINE_LOG_LEVEL
+#define ENGINE_LOG_LEVEL 0
+#endif
+
+// Whether calls at a level are compiled in; at level 0 everything is, and the
+// comparison is left out rather than warned about as always true
+#if ENGINE_LOG_LEVEL > 0
+#define ENGINE_LOG_COMPILED(level) (static_cast<int>(level) >= ENGINE_LOG_LEVEL)
+#else
+#define ENGINE_LOG_COMPILED(level) true
+#endif
+
+// Mixed case like crow::LogLevel: DEBUG and ERROR are common macros
+enum class LogLevel : uint8_t { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+struct LogConfig {
+    LogLevel level = LogLevel::Info;   // run-time threshold
+    bool console = true;               // formatted lines on stdout
+    std::string textFile;              // formatted lines appended here; empty = none
+    std::string binaryFile;            // raw records for log_decode; empty = none
+    size_t ringBytes = 1 << 20;        // per producer thread, rounded up to a power of two
+};
+
+namespace Log {
+
+constexpr size_t kMaxArgs = 16;
+constexpr size_t kMaxStringArg = 1024;
+
+enum class ArgType : uint8_t { I64 = 1, U64 = 2, F64 = 3, BOOL = 4, CHAR = 5, STR = 6 };
+
+// One call site: registered once, referenced by id from every record
+struct Format {
+    LogLevel level = LogLevel::Info;
+    std::string_view file;             // basename of __FILE__
+    uint32_t line = 0;
+    std::string_view text;             // "{}" placeholders
+    uint8_t argCount = 0;
+    ArgType args[kMaxArgs] = {};
+};
+
+// Record layout, in the ring and in binary files (host byte order):
+//   u16 formatId  u16 size (whole record, multiple of 8)  u32 reserved  i64 timestamp (ns since epoch)
+//   then per argument: 8 bytes for scalars, u32 length + bytes for strings
+constexpr size_t kRecordHeader = 16;
+
+// Sinks and level; safe to call at any time (rings already created keep their size)
+void configure(const LogConfig& config);
+
+// Block until every record logged before the call has been written out
+void flush();
+
+// Records dropped so far because a ring was full
+uint64_t dropped();
+
+// Decode a binary log file into formatted lines; false with error set on a bad file
+bool decodeFile(const std::string& path, std::ostream& out, std::string& error);
+
+// ---- used by the LOG_* macros ----
+
+extern std::atomic<uint8_t> g_runtimeLevel;
+
+inline bool enabled(LogLevel level) {
+    return static_cast<uint8_t>(level) >= g_runtimeLevel.load(std::memory_order_relaxed);
+}
+
+uint16_t registerFormat(const Format& format);
+
+// Space for one record in this thread's ring (nullptr when full); commit() publishes it
+char* reserve(size_t size);
+void commit();
+
+template<typename T>
+constexpr ArgType argType() {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) return ArgType::BOOL;
+    else if constexpr (std::is_same_v<D, char>) return ArgType::CHAR;
+    else if constexpr (std::is_enum_v<D>) return ArgType::I64;
+    else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) return ArgType::I64;
+    else if constexpr (std::is_integral_v<D>) return ArgType::U64;
+    else if constexpr (std::is_floating_point_v<D>) return ArgType::F64;
+    else {
+        static_assert(std::is_convertible_v<const D&, std::string_view>, "unsupported log argument type");
+        return ArgType::STR;
+    }
+}
+
+template<typename T>
+size_t argSize(const T& value) {
+    if constexpr (argType<T>() == ArgType::STR) {
+        return 4 + std::min(std::string_view(value).size(), kMaxStringArg);
+    } else {
+        return 8;
+    }
+}
+
+template<typename T>
+char* putArg(char* p, const T& value) {
+    using D = std::decay_t<T>;
+    constexpr ArgType type = argType<T>();
+    if constexpr (type == ArgType::STR) {
+        std::string_view s(value);
+        uint32_t n = static_cast<uint32_t>(std::min(s.size(), kMaxStringArg));
+        std::memcpy(p, &n, 4);
+        std::memcpy(p + 4, s.data(), n);
+        return p + 4 + n;
+    } else if constexpr (type == ArgType::F64) {
+        double v = static_cast<double>(value);
+        std::memcpy(p, &v, 8);
+        return p + 8;
+    } else if constexpr (type == ArgType::U64) {
+        uint64_t v = static_cast<uint64_t>(value);
+        std::memcpy(p, &v, 8);
+        return p + 8;
+    } else {
+        int64_t v;
+        if constexpr (std::is_enum_v<D>) v = static_cast<int64_t>(static_cast<std::underlying_type_t<D>>(value));
+        else v = static_cast<int64_t>(value);
+        std::memcpy(p, &v, 8);
+        return p + 8;
+    }
+}
+
+template<typename... Args>
+uint16_t registerSite(LogLevel level, const char* file, int line, const char* text, const Args&...) {
+    static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+    Format format;
+    std::string_view path(file);
+    size_t slash = path.find_last_of("/\\");
+    format.level = level;
+    format.file = slash == std::string_view::npos ? path : path.substr(slash + 1);
+    format.line = static_cast<uint32_t>(line);
+    format.text = text;
+    format.argCount = static_cast<uint8_t>(sizeof...(Args));
+    size_t i = 0;
+    ((format.args[i++] = argType<Args>()), ...);
+    (void)i;
+    return registerFormat(format);
+}
+
+int64_t nowNanos();
+
+template<typename... Args>
+void write(uint16_t formatId, const char*, const Args&... args) {
+    size_t size = kRecordHeader + (size_t{0} + ... + argSize(args));
+    size = (size + 7) & ~size_t{7};
+    char* record = reserve(size);
+    if (!record) return;
+    uint16_t id = formatId;
+    uint16_t size16 = static_cast<uint16_t>(size);
+    int64_t ts = nowNanos();
+    std::memcpy(record, &id, 2);
+    std::memcpy(record + 2, &size16, 2);
+    std::memset(record + 4, 0, 4);
+    std::memcpy(record + 8, &ts, 8);
+    char* p = record + kRecordHeader;
+    ((p = putArg(p, args)), ...);
+    (void)p;
+    commit();
+}
+
+} // namespace Log
+
+#define ENGINE_LOG(level, ...)                                                                   \
+    do {                                                                                         \
+        if constexpr (ENGINE_LOG_COMPILED(level)) {                                              \
+            if (::Log::enabled(level)) {                                                         \
+                static const uint16_t engineLogFormat_ =                                         \
+                    ::Log::registerSite(level, __FILE__, __LINE__, __VA_ARGS__);                 \
+                ::Log::write(engineLogFormat_, __VA_ARGS__);                                     \
+            }                                                                                    \
+        }                                                                                        \
+    } while (0)
+
+#define LOG_TRACE(...) ENGINE_LOG(::LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...) ENGINE_LOG(::LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...)  ENGINE_LOG(::LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...)  ENGINE_LOG(::LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) ENGINE_LOG(::LogLevel::Error, __VA_ARGS__)
@@ -0,0 +1,129 @@
+#include "MarketDataSerializer.h"
+#include "JsonWriter.h"
+
+namespace MarketDataSerializer {
+
+void appendTrade(std::string& out, const TradeReport& trade) {
+    JsonWriter w(out);
+    w.raw('{');
+    w.key("aggressor_side");  w.string(trade.aggressor);       w.raw(',');
+    w.key("maker_fee");       w.quotedNumber(trade.makerFee);  w.raw(',');
+    w.key("maker_order_id");  w.string(trade.makerOrderId);    w.raw(',');
+    w.key("price");           w.quotedNumber(trade.price);     w.raw(',');
+    w.key("quantity");        w.quotedNumber(trade.quantity);  w.raw(',');
+    w.key("symbol");          w.string(trade.symbol);          w.raw(',');
+    w.key("taker_fee");       w.quotedNumber(trade.takerFee);  w.raw(',');
+    w.key("taker_order_id");  w.string(trade.takerOrderId);    w.raw(',');
+    w.key("timestamp");       w.quotedNumber(trade.timestamp); w.raw(',');
+    w.key("trade_id");        w.string(trade.tradeId);
+    w.raw('}');
+}
+
+void appendExecutionBatch(std::string& out, const ExecutionBatch& batch) {
+    JsonWriter w(out);
+    w.raw('{');
+    w.key("aggressor_side"); w.string(batch.aggressor); w.raw(',');
+    w.key("fills");          w.raw('[');
+    bool first = true;
+    for (const auto& fill : batch.fills) {
+        if (!first) w.raw(',');
+        first = false;
+        appendTrade(out, fill);
+    }
+    w.raw("],");
+    w.key("symbol");         w.string(batch.symbol);          w.raw(',');
+    w.key("taker_order_id"); w.string(batch.takerOrderId);    w.raw(',');
+    w.key("timestamp");      w.quotedNumber(batch.timestamp); w.raw(',');
+    w.key("type");           w.raw("\"trades\"");
+    w.raw('}');
+}
+
+void appendL2Delta(std::string& out, const std::string& symbol, uint64_t firstSeq, uint64_t seq,
+                   long long timestamp, const std::vector<L2Level>& changes) {
+    JsonWriter w(out);
+    w.raw("{\"changes\":[");
+    bool first = true;
+    for (const auto& level : changes) {
+        if (!first) w.raw(',');
+        first = false;
+        w.raw('{');
+        w.key("price");     w.quotedNumber(level.price);    w.raw(',');
+        w.key("quantity");  w.quotedNumber(level.quantity); w.raw(',');
+        w.key("side");      w.raw(level.side == Side::BUY ? "\"bid\"" : "\"ask\"");
+        w.raw('}');
+    }
+    w.raw("],");
+    w.key("first_seq"); w.quotedNumber(firstSeq);  w.raw(',');
+    w.key("seq");       w.quotedNumber(seq);       w.raw(',');
+    w.key("symbol");    w.string(symbol);          w.raw(',');
+    w.key("timestamp"); w.quotedNumber(timestamp); w.raw(',');
+    w.key("type");      w.raw("\"l2_delta\"");
+    w.raw('}');
+}
+
+void appendL3Event(std::string& out, const L3Event& event) {
+    static const char* const kTypes[] = {"\"l3_add\"", "\"l3_reduce\"", "\"l3_delete\"", "\"l3_execute\""};
+    bool execute = (event.type == L3Event::Type::EXECUTE);
+    JsonWriter w(out);
+    w.raw('{');
+    if (execute) {
+        w.key("exec_quantity"); w.quotedNumber(event.execQty); w.raw(',');
+    }
+    w.key("order_id");  w.string(event.orderId);         w.raw(',');
+    w.key("price");     w.quotedNumber(event.price);     w.raw(',');
+    w.key("quantity");  w.quotedNumber(event.quantity);  w.raw(',');
+    w.key("seq");       w.quotedNumber(event.seq);       w.raw(',');
+    w.key("side");      w.raw(event.side == Side::BUY ? "\"bid\"" : "\"ask\""); w.raw(',');
+    w.key("symbol");    w.string(event.symbol);          w.raw(',');
+    w.key("timestamp"); w.quotedNumber(event.timestamp); w.raw(',');
+    if (execute) {
+        w.key("trade_id"); w.string(event.tradeId); w.raw(',');
+    }
+    w.key("type");      w.raw(kTypes[static_cast<int>(event.type)]);
+    w.raw('}');
+}
+
+namespace {
+
+void appendLevels(JsonWriter& w, const std::vector<std::pair<double, double>>& levels) {
+    w.raw('[');
+    bool first = true;
+    for (const auto& [price, qty] : levels) {
+        if (!first) w.raw(',');
+        first = false;
+        w.raw('[');
+        w.quotedNumber(price);
+        w.raw(',');
+        w.quotedNumber(qty);
+        w.raw(']');
+    }
+    w.raw(']');
+}
+
+void appendBookFields(JsonWriter& w, const L2Update& update) {
+    w.key("asks");      appendLevels(w, update.asks);     w.raw(',');
+    w.key("bids");      appendLevels(w, update.bids);     w.raw(',');
+    w.key("seq");       w.quotedNumber(update.seq);       w.raw(',');
+    w.key("symbol");    w.string(update.symbol);          w.raw(',');
+    w.key("timestamp"); w.quotedNumber(update.timestamp);
+}
+
+} // namespace
+
+void appendL2Update(std::string& out, const L2Update& update) {
+    JsonWriter w(out);
+    w.raw('{');
+    appendBookFields(w, update);
+    w.raw('}');
+}
+
+void appendL2Snapshot(std::string& out, const L2Update& update) {
+    JsonWriter w(out);
+    w.raw('{');
+    appendBookFields(w, update);
+    w.raw(',');
+    w.key("type");      w.raw("\"l2_snapshot\"");
+    w.raw('}');
+}
+
+} // namespace MarketDataSerializer
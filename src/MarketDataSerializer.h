@@ -0,0 +1,38 @@
+#pragma once
+#include "OrderBook.h"
+#include "TradeExecutionFeed.h"
+#include <string>
+#include <vector>
+
+// Hand-written serializers for the market-data wire messages. They produce
+// the same schema (and key order) as the nlohmann::json DOM they replace but
+// append into a reusable buffer instead of building a DOM per event.
+// Numbers use shortest round-trip formatting instead of std::to_string's
+// fixed six decimals, so sub-1e-6 quantities and fees survive the wire.
+namespace MarketDataSerializer {
+
+// {"aggressor_side":..,"maker_fee":..,...,"trade_id":..} - same fields as TradeReport::toJson
+void appendTrade(std::string& out, const TradeReport& trade);
+
+// {"aggressor_side":..,"fills":[<appendTrade>,..],"symbol":..,"taker_order_id":..,
+//  "timestamp":..,"type":"trades"} - one message per aggressive order
+void appendExecutionBatch(std::string& out, const ExecutionBatch& batch);
+
+// {"changes":[{"price":..,"quantity":..,"side":"bid"|"ask"},..],"first_seq":..,"seq":..,
+//  "symbol":..,"timestamp":..,"type":"l2_delta"}
+void appendL2Delta(std::string& out, const std::string& symbol, uint64_t firstSeq, uint64_t seq,
+                   long long timestamp, const std::vector<L2Level>& changes);
+
+// {"exec_quantity":..,"order_id":..,"price":..,"quantity":..,"seq":..,"side":"bid"|"ask",
+//  "symbol":..,"timestamp":..,"trade_id":..,"type":"l3_add"|"l3_reduce"|"l3_delete"|"l3_execute"}
+// exec_quantity and trade_id are only present on l3_execute
+void appendL3Event(std::string& out, const L3Event& event);
+
+// {"asks":[[price,qty],..],"bids":[[price,qty],..],"seq":..,"symbol":..,"timestamp":..}
+void appendL2Update(std::string& out, const L2Update& update);
+
+// Same fields as appendL2Update plus "type":"l2_snapshot" - the first message of a
+// /ws/orderbook subscription and the answer to a resync
+void appendL2Snapshot(std::string& out, const L2Update& update);
+
+} // namespace MarketDataSerializer
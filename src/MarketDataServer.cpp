@@ -1,97 +1,207 @@
 #include "MarketDataServer.h"
+#include "MarketDataSerializer.h"
+#include "BinaryCodec.h"
+#include "Logger.h"
+#include "JsonWriter.h"
+#include <asio.hpp>
 #include <iostream>
 #include <algorithm>
+#include <climits>
+#include <cstdlib>
 using namespace std;
 
-MarketDataServer::MarketDataServer(MatchingEngine& engine, int port)
-    : engine_(engine), app_() {
+MarketDataServer::MarketDataServer(MatchingEngine& engine, int port, const MarketDataConfig& config)
+    : engine_(engine), config_(config), app_(), engineLoop_(engine, config.maxPendingOrders) {
     cout <<"=== CONSTRUCTING MarketDataServer ===" << endl;
     
     setupRestRoutes();
     setupWebSocketEndpoints();
     
     // Subscribe to engine events
-    engine_.tradeFeed().subscribe([this](const TradeReport& trade) {
-        broadcastTrade(trade);
+    // One /ws/trades frame per aggressive order, carrying all of its fills
+    executionSub_ = engine_.executionFeed().subscribe([this](const ExecutionBatch& batch) {
+        broadcastExecution(batch);
     });
     
-    engine_.l2Feed().subscribe([this](const L2Update& update) {
-        broadcastL2Update(update);
+    deltaSub_ = engine_.l2DeltaFeed().subscribe([this](const L2Delta& delta) {
+        broadcastL2Delta(delta);
+    });
+    
+    l3Sub_ = engine_.l3Feed().subscribe([this](const L3Event& event) {
+        broadcastL3Event(event);
+    });
+    
+    // Maker fills for orders entered on /ws/orders
+    tradeSub_ = engine_.tradeFeed().subscribe([this](const TradeReport& trade) {
+        onOrderTrade(trade);
+    });
+    // ... and the end of conditional orders that fired without resting
+    triggerSub_ = engine_.triggerFeed().subscribe([this](const TriggeredOrder& fired) {
+        onOrderTriggered(fired);
     });
     
     app_.port(port).multithreaded();
+    
+    dispatchThread_ = thread([this]() { dispatchLoop(); });
+}
+
+MarketDataServer::~MarketDataServer() {
+    // Gateways may still be matching; nothing they publish reaches this server from here on
+    engine_.executionFeed().unsubscribe(executionSub_);
+    engine_.l2DeltaFeed().unsubscribe(deltaSub_);
+    engine_.l3Feed().unsubscribe(l3Sub_);
+    engine_.tradeFeed().unsubscribe(tradeSub_);
+    engine_.triggerFeed().unsubscribe(triggerSub_);
+    {
+        // Under the lock, so the dispatch thread cannot miss it between check and wait
+        lock_guard<mutex> lock(clientsMutex_);
+        running_ = false;
+    }
+    dispatchCv_.notify_all();
+    if (dispatchThread_.joinable()) dispatchThread_.join();
 }
 
 void MarketDataServer::stop() {
     app_.stop();
 }
 
+uint16_t MarketDataServer::port() {
+    app_.wait_for_server_start();
+    return app_.port();
+}
+
+namespace {
+
+const char* statusName(OrderResult result) {
+    switch (result) {
+        case OrderResult::ACCEPTED: return "accepted";
+        case OrderResult::COMPLETELY_FILLED: return "filled";
+        case OrderResult::PARTIALLY_FILLED: return "partially_filled";
+        case OrderResult::REJECTED_INVALID_PARAMS: return "rejected_invalid";
+        case OrderResult::REJECTED_TRADE_THROUGH: return "rejected_trade_through";
+        case OrderResult::REJECTED_FOK_UNFILLABLE: return "rejected_fok";
+        case OrderResult::REJECTED_UNKNOWN_ORDER: return "rejected_unknown_order";
+        default: return "unknown";
+    }
+}
+
+nlohmann::json orderResponseJson(const string& orderId, const OrderResponse& response) {
+    nlohmann::json responseJson = {
+        {"order_id", orderId},
+        {"status", statusName(response.result)},
+        {"message", response.message},
+        {"filled_quantity", to_string(response.filledQuantity)},
+        {"trades", nlohmann::json::array()}
+    };
+    
+    // Add trade details
+    for (const auto& trade : response.trades) {
+        responseJson["trades"].push_back(trade.toJson());
+    }
+    return responseJson;
+}
+
+// Finish a deferred response on its connection's io thread; fill runs there too,
+// so the engine loop only copies the result and moves on. res lives in the
+// connection, which the unfinished response keeps alive until res.end() even if
+// the client has gone (include/crow_all.h), so it stays valid here.
+template<typename Fill>
+void completeOn(asio::io_context& io, crow::response& res, Fill&& fill) {
+    asio::post(io, [&res, fill = std::forward<Fill>(fill)]() mutable {
+        fill(res);
+        res.end();
+    });
+}
+
+// The engine loop's queue is full
+void replyBusy(crow::response& res) {
+    res.code = 503;
+    res.end(R"({"error":"engine busy, retry later"})");
+}
+
+} // namespace
+
 void MarketDataServer::setupRestRoutes() {
     using json = nlohmann::json;
 
-    // Order submission endpoint
+    // Order submission endpoint. Matching runs on the engine loop; the worker
+    // returns as soon as the order is queued and the response is written when
+    // the engine completes.
     CROW_ROUTE(app_, "/orders").methods("POST"_method)
-    ([this](const crow::request& req) {
-        cout << "POST /orders - Body: " << req.body << endl;
+    ([this](const crow::request& req, crow::response& res) {
+        LOG_DEBUG("POST /orders body: {}", req.body);
+        
+        Order order;
+        OrderParseError error;
+        if (!orderParser_.parse(req.body, order, error)) {
+            LOG_WARN("Order submission error: {} at offset {}", error.message, error.offset);
+            json errorJson = {{"error", error.message}, {"offset", error.offset}};
+            res.code = 400;
+            res.end(errorJson.dump());
+            return;
+        }
+        order.timestamp = Order::now();
         
+        string orderId = order.orderId;
+        bool queued = engineLoop_.submit(move(order), [io = req.io_context, &res, orderId](const OrderResponse& response) {
+            completeOn(*io, res, [orderId, response](crow::response& out) {
+                bool ok = response.result == OrderResult::ACCEPTED ||
+                          response.result == OrderResult::COMPLETELY_FILLED ||
+                          response.result == OrderResult::PARTIALLY_FILLED;
+                out.code = ok ? 201 : 400;
+                out.body = orderResponseJson(orderId, response).dump();
+            });
+        });
+        if (!queued) replyBusy(res);
+    });
+    
+    // Cancel a resting order
+    CROW_ROUTE(app_, "/orders/<string>").methods("DELETE"_method)
+    ([this](const crow::request& req, crow::response& res, const string& orderId) {
+        bool queued = engineLoop_.cancel(orderId, [io = req.io_context, &res, orderId](bool canceled) {
+            completeOn(*io, res, [orderId, canceled](crow::response& out) {
+                if (!canceled) {
+                    json errorJson = {{"order_id", orderId}, {"error", "Order not found or not resting"}};
+                    out.code = 404;
+                    out.body = errorJson.dump();
+                    return;
+                }
+                json response = {{"order_id", orderId}, {"status", "canceled"}};
+                out.code = 200;
+                out.body = response.dump();
+            });
+        });
+        if (!queued) replyBusy(res);
+    });
+    
+    // Amend a resting order: {"price":..,"quantity":..}, either may be omitted
+    CROW_ROUTE(app_, "/orders/<string>").methods("PATCH"_method)
+    ([this](const crow::request& req, crow::response& res, const string& orderId) {
+        double price = 0.0;
+        double quantity = 0.0;
         try {
             auto body = json::parse(req.body);
-            
-            Order order;
-            order.orderId = body.at("order_id").get<string>();
-            order.symbol = body.at("symbol").get<string>();
-            order.side = (body.at("side").get<string>() == "buy" ? Side::BUY : Side::SELL);
-            
-            // Parse order type
-            string typeStr = body.at("order_type").get<string>();
-            if (typeStr == "market") order.type = OrderType::MARKET;
-            else if (typeStr == "limit") order.type = OrderType::LIMIT;
-            else if (typeStr == "ioc") order.type = OrderType::IOC;
-            else if (typeStr == "fok") order.type = OrderType::FOK;
-            else throw invalid_argument("Invalid order_type: " + typeStr);
-            
-            order.quantity = body.at("quantity").get<double>();
-            order.price = body.value("price", 0.0);
-            order.timestamp = Order::now();
-
-            // Submit to matching engine
-            auto response = engine_.submitOrder(order);
-            
-            // Create response JSON
-            json responseJson = {
-                {"order_id", order.orderId},
-                {"status", [&]() {
-                    switch (response.result) {
-                        case OrderResult::ACCEPTED: return "accepted";
-                        case OrderResult::COMPLETELY_FILLED: return "filled";
-                        case OrderResult::PARTIALLY_FILLED: return "partially_filled";
-                        case OrderResult::REJECTED_INVALID_PARAMS: return "rejected_invalid";
-                        case OrderResult::REJECTED_TRADE_THROUGH: return "rejected_trade_through";
-                        case OrderResult::REJECTED_FOK_UNFILLABLE: return "rejected_fok";
-                        default: return "unknown";
-                    }
-                }()},
-                {"message", response.message},
-                {"filled_quantity", to_string(response.filledQuantity)},
-                {"trades", json::array()}
-            };
-            
-            // Add trade details
-            for (const auto& trade : response.trades) {
-                responseJson["trades"].push_back(trade.toJson());
-            }
-            
-            int httpStatus = (response.result == OrderResult::ACCEPTED || 
-                            response.result == OrderResult::COMPLETELY_FILLED ||
-                            response.result == OrderResult::PARTIALLY_FILLED) ? 201 : 400;
-            
-            return crow::response(httpStatus, responseJson.dump());
+            price = body.value("price", 0.0);
+            quantity = body.value("quantity", 0.0);
+            if (price == 0.0 && quantity == 0.0) throw invalid_argument("price or quantity required");
         }
         catch (const exception& e) {
-            cerr << "Order submission error: " << e.what() << endl;
             json errorJson = {{"error", e.what()}};
-            return crow::response(400, errorJson.dump());
+            res.code = 400;
+            res.end(errorJson.dump());
+            return;
         }
+        
+        bool queued = engineLoop_.amend(orderId, price, quantity, [io = req.io_context, &res, orderId](const OrderResponse& response) {
+            completeOn(*io, res, [orderId, response](crow::response& out) {
+                out.code = 200;
+                if (response.result == OrderResult::REJECTED_UNKNOWN_ORDER) out.code = 404;
+                else if (response.result == OrderResult::REJECTED_INVALID_PARAMS ||
+                         response.result == OrderResult::REJECTED_TRADE_THROUGH) out.code = 400;
+                out.body = orderResponseJson(orderId, response).dump();
+            });
+        });
+        if (!queued) replyBusy(res);
     });
 
     // BBO endpoint
@@ -123,30 +233,25 @@ void MarketDataServer::setupRestRoutes() {
         
         auto l2Update = engine_.getL2Update(symbol, depth);
         
-        json response = {
-            {"timestamp", to_string(l2Update.timestamp)},
-            {"symbol", l2Update.symbol},
-            {"bids", json::array()},
-            {"asks", json::array()}
-        };
-        
-        for (const auto& [price, qty] : l2Update.bids) {
-            response["bids"].push_back({to_string(price), to_string(qty)});
-        }
-        
-        for (const auto& [price, qty] : l2Update.asks) {
-            response["asks"].push_back({to_string(price), to_string(qty)});
-        }
-        
-        return crow::response(200, response.dump());
+        string body;
+        MarketDataSerializer::appendL2Update(body, l2Update);
+        return crow::response(200, body);
+    });
+
+    // Per-connection outbound queue metrics
+    CROW_ROUTE(app_, "/marketdata/clients").methods("GET"_method)
+    ([this]() {
+        return crow::response(200, clientStats().dump());
     });
 
     // Health check endpoint
     CROW_ROUTE(app_, "/health").methods("GET"_method)
-    ([]() {
+    ([this]() {
         json response = {
             {"status", "healthy"},
-            {"timestamp", to_string(Order::now())}
+            {"timestamp", to_string(Order::now())},
+            {"engine_queue_depth", engineLoop_.pending()},
+            {"engine_busy_rejects", engineLoop_.rejected()}
         };
         return crow::response(200, response.dump());
     });
@@ -157,111 +262,1098 @@ void MarketDataServer::setupWebSocketEndpoints() {
     CROW_ROUTE(app_, "/ws/trades")
         .websocket(&app_)
         .onopen([this](crow::websocket::connection& conn) {
-            addTradeClient(&conn);
-            cout << "[WS] Trade client connected, total=" << tradeClients_.size() << endl;
+            size_t total = addFeedClient(tradeSubs_, &conn);
+            LOG_INFO("[WS] Trade client connected, total={}", total);
         })
         .onclose([this](crow::websocket::connection& conn, const string&, bool) {
-            removeTradeClient(&conn);
-            cout << "[WS] Trade client disconnected, remaining=" << tradeClients_.size() << endl;
+            size_t remaining = removeFeedClient(tradeSubs_, &conn);
+            LOG_INFO("[WS] Trade client disconnected, remaining={}", remaining);
         })
-        .onmessage([](crow::websocket::connection&, const string& message, bool) {
-            // Echo or handle client messages if needed
-            cout << "[WS] Trade client message: " << message << endl;
+        .onmessage([this](crow::websocket::connection& conn, const string& message, bool) {
+            handleFeedClientMessage(tradeSubs_, &conn, message);
         });
 
     // L2 order book feed WebSocket
     CROW_ROUTE(app_, "/ws/orderbook")
         .websocket(&app_)
         .onopen([this](crow::websocket::connection& conn) {
-            addL2Client(&conn);
-            cout << "[WS] L2 client connected, total=" << l2Clients_.size() << endl;
+            size_t total = addL2Client(&conn);
+            LOG_INFO("[WS] L2 client connected, total={}", total);
         })
         .onclose([this](crow::websocket::connection& conn, const string&, bool) {
-            removeL2Client(&conn);
-            cout << "[WS] L2 client disconnected, remaining=" << l2Clients_.size() << endl;
+            size_t remaining = removeL2Client(&conn);
+            LOG_INFO("[WS] L2 client disconnected, remaining={}", remaining);
         })
-        .onmessage([](crow::websocket::connection&, const string& message, bool) {
-            // Handle client messages (e.g., symbol subscriptions)
-            cout << "[WS] L2 client message: " << message << endl;
+        .onmessage([this](crow::websocket::connection& conn, const string& message, bool) {
+            handleL2ClientMessage(&conn, message);
         });
+
+    // L3 order-by-order feed WebSocket
+    CROW_ROUTE(app_, "/ws/l3")
+        .websocket(&app_)
+        .onopen([this](crow::websocket::connection& conn) {
+            size_t total = addFeedClient(l3Subs_, &conn);
+            LOG_INFO("[WS] L3 client connected, total={}", total);
+        })
+        .onclose([this](crow::websocket::connection& conn, const string&, bool) {
+            size_t remaining = removeFeedClient(l3Subs_, &conn);
+            LOG_INFO("[WS] L3 client disconnected, remaining={}", remaining);
+        })
+        .onmessage([this](crow::websocket::connection& conn, const string& message, bool) {
+            handleFeedClientMessage(l3Subs_, &conn, message);
+        });
+
+    // Order-entry session WebSocket: one request per text frame, replies on the same socket
+    CROW_ROUTE(app_, "/ws/orders")
+        .websocket(&app_)
+        .onaccept([](const crow::request& req, void** userdata) {
+            // Session options from the query string; the session is handed to onopen
+            auto session = make_unique<OrderSession>();
+            if (const char* cancel = req.url_params.get("cancel_on_disconnect")) {
+                string value(cancel);
+                if (value == "true" || value == "1") session->cancelOnDisconnect = true;
+                else if (value != "false" && value != "0") return false;
+            }
+            if (const char* heartbeat = req.url_params.get("heartbeat_ms")) {
+                char* end;
+                long ms = strtol(heartbeat, &end, 10);
+                if (*heartbeat == '\0' || *end != '\0' || ms < 0) return false;
+                session->heartbeat = chrono::milliseconds(ms);
+            }
+            *userdata = session.release();
+            return true;
+        })
+        .onopen([this](crow::websocket::connection& conn) {
+            size_t total = addOrderSession(&conn);
+            LOG_INFO("[WS] Order session opened, total={}", total);
+        })
+        .onclose([this](crow::websocket::connection& conn, const string&, bool) {
+            size_t remaining = removeOrderSession(&conn);
+            LOG_INFO("[WS] Order session closed, remaining={}", remaining);
+        })
+        .onmessage([this](crow::websocket::connection& conn, const string& message, bool) {
+            handleOrderRequest(&conn, message);
+        });
+}
+
+uint32_t MarketDataServer::internSymbol(const string& symbol) {
+    auto [it, inserted] = symbolIds_.emplace(symbol, static_cast<uint32_t>(symbolNames_.size()));
+    if (inserted) {
+        symbolNames_.push_back(symbol);
+        tradeSubs_.subscribers.emplace_back();
+        l3Subs_.subscribers.emplace_back();
+        l2Subscribers_.emplace_back();
+        bookCache_.emplace_back();
+    }
+    return it->second;
+}
+
+uint32_t MarketDataServer::findSymbol(const string& symbol) const {
+    auto it = symbolIds_.find(symbol);
+    return it == symbolIds_.end() ? kUnknownSymbol : it->second;
+}
+
+namespace {
+
+// Accepts {"symbols":["A","B"]} or {"symbol":"A"}; "*" means every symbol
+vector<string> requestedSymbols(const nlohmann::json& msg) {
+    vector<string> symbols;
+    if (msg.contains("symbols")) {
+        for (const auto& s : msg.at("symbols")) symbols.push_back(s.get<string>());
+    } else if (msg.contains("symbol")) {
+        symbols.push_back(msg.at("symbol").get<string>());
+    }
+    if (symbols.empty()) throw invalid_argument("symbols required");
+    return symbols;
+}
+
+// {"op":"encoding","format":"binary"|"json"}; returns true for binary
+bool requestedBinary(const nlohmann::json& msg) {
+    string format = msg.value("format", "json");
+    if (format != "binary" && format != "json") throw invalid_argument("unknown format: " + format);
+    return format == "binary";
+}
+
+const char* policyName(SlowConsumerPolicy policy) {
+    switch (policy) {
+        case SlowConsumerPolicy::CONFLATE: return "conflate";
+        case SlowConsumerPolicy::DROP: return "drop";
+        case SlowConsumerPolicy::DISCONNECT: return "disconnect";
+    }
+    return "unknown";
+}
+
+// {"op":"slow_consumer","policy":"conflate"|"drop"|"disconnect"}
+SlowConsumerPolicy requestedPolicy(const nlohmann::json& msg) {
+    string policy = msg.value("policy", "");
+    if (policy == "conflate") return SlowConsumerPolicy::CONFLATE;
+    if (policy == "drop") return SlowConsumerPolicy::DROP;
+    if (policy == "disconnect") return SlowConsumerPolicy::DISCONNECT;
+    throw invalid_argument("unknown policy: " + policy);
+}
+
+// {"dropped":"N","type":"gap"} (a BinaryCodec GAP frame for binary clients): N
+// messages were dropped for this connection
+shared_ptr<const string> gapMarker(uint64_t dropped, bool binary) {
+    if (!binary) {
+        return make_shared<const string>("{\"dropped\":\"" + to_string(dropped) + "\",\"type\":\"gap\"}");
+    }
+    string frame;
+    BinaryCodec::encodeGap(frame, dropped);
+    return make_shared<const string>(move(frame));
+}
+
+} // namespace
+
+void MarketDataServer::sendControl(crow::websocket::connection* conn, const nlohmann::json& msg) {
+    enqueue(conn, make_shared<const string>(msg.dump()), false);
 }
 
-void MarketDataServer::addTradeClient(crow::websocket::connection* conn) {
+size_t MarketDataServer::addFeedClient(SymbolFeed& feed, crow::websocket::connection* conn) {
     lock_guard<mutex> lock(clientsMutex_);
-    tradeClients_.push_back(conn);
+    feed.clients.emplace(conn, FeedClientState{});
+    ClientQueue& queue = queues_[conn];
+    queue.feed = (&feed == &tradeSubs_) ? "trades" : "l3";
+    queue.policy = config_.slowConsumerPolicy;
+    return feed.clients.size();
 }
 
-void MarketDataServer::removeTradeClient(crow::websocket::connection* conn) {
+size_t MarketDataServer::removeFeedClient(SymbolFeed& feed, crow::websocket::connection* conn) {
+    lock_guard<mutex> sendLock(sendMutex_);   // wait out an in-progress dispatch to conn
     lock_guard<mutex> lock(clientsMutex_);
-    tradeClients_.erase(
-        remove(tradeClients_.begin(), tradeClients_.end(), conn),
-        tradeClients_.end()
-    );
+    queues_.erase(conn);
+    auto it = feed.clients.find(conn);
+    if (it != feed.clients.end()) {
+        for (uint32_t id : it->second.symbols) feed.subscribers[id].erase(conn);
+        feed.allSymbols.erase(conn);
+        feed.clients.erase(it);
+    }
+    return feed.clients.size();
 }
 
-void MarketDataServer::addL2Client(crow::websocket::connection* conn) {
+size_t MarketDataServer::addL2Client(crow::websocket::connection* conn) {
     lock_guard<mutex> lock(clientsMutex_);
-    l2Clients_.push_back(conn);
+    l2Clients_.emplace(conn, L2ClientState{});
+    ClientQueue& queue = queues_[conn];
+    queue.feed = "orderbook";
+    queue.policy = config_.slowConsumerPolicy;
+    return l2Clients_.size();
 }
 
-void MarketDataServer::removeL2Client(crow::websocket::connection* conn) {
+size_t MarketDataServer::removeL2Client(crow::websocket::connection* conn) {
+    lock_guard<mutex> sendLock(sendMutex_);
     lock_guard<mutex> lock(clientsMutex_);
-    l2Clients_.erase(
-        remove(l2Clients_.begin(), l2Clients_.end(), conn),
-        l2Clients_.end()
-    );
+    queues_.erase(conn);
+    auto it = l2Clients_.find(conn);
+    if (it != l2Clients_.end()) {
+        for (const auto& [id, sub] : it->second.subs) l2Subscribers_[id].erase(conn);
+        l2AllSymbols_.erase(conn);
+        l2Clients_.erase(it);
+    }
+    return l2Clients_.size();
+}
+
+// Control messages on /ws/trades and /ws/l3:
+//   {"op":"subscribe","symbols":["BTC-USDT","ETH-USDT"]}   ("*" = all symbols)
+//   {"op":"unsubscribe","symbols":["ETH-USDT"]}
+//   {"op":"encoding","format":"binary"}   -> BinaryCodec frames ("json" to switch back)
+//   {"op":"slow_consumer","policy":"drop"}   -> what to do when the outbound queue is full
+void MarketDataServer::handleFeedClientMessage(SymbolFeed& feed, crow::websocket::connection* conn,
+                                               const string& message) {
+    using json = nlohmann::json;
+    try {
+        auto msg = json::parse(message);
+        string op = msg.value("op", "");
+        if (op == "encoding") {
+            bool binary = requestedBinary(msg);
+            lock_guard<mutex> lock(clientsMutex_);
+            auto it = feed.clients.find(conn);
+            if (it == feed.clients.end()) return;
+            it->second.binary = binary;
+            queues_.at(conn).binary = binary;
+            sendControl(conn, {{"type", "encoding_ack"}, {"format", binary ? "binary" : "json"}});
+            return;
+        }
+        if (op == "slow_consumer") {
+            SlowConsumerPolicy policy = requestedPolicy(msg);
+            lock_guard<mutex> lock(clientsMutex_);
+            auto it = queues_.find(conn);
+            if (it == queues_.end()) return;
+            it->second.policy = policy;
+            sendControl(conn, {{"type", "slow_consumer_ack"}, {"policy", policyName(policy)}});
+            return;
+        }
+        if (op != "subscribe" && op != "unsubscribe") {
+            throw invalid_argument("unknown op: " + op);
+        }
+        auto symbols = requestedSymbols(msg);
+        bool subscribe = (op == "subscribe");
+        
+        lock_guard<mutex> lock(clientsMutex_);
+        auto it = feed.clients.find(conn);
+        if (it == feed.clients.end()) return;
+        FeedClientState& state = it->second;
+        for (const auto& symbol : symbols) {
+            if (symbol == "*") {
+                state.allSymbols = subscribe;
+                if (subscribe) feed.allSymbols.insert(conn);
+                else feed.allSymbols.erase(conn);
+            } else if (subscribe) {
+                uint32_t id = internSymbol(symbol);
+                state.symbols.insert(id);
+                feed.subscribers[id].insert(conn);
+            } else {
+                uint32_t id = findSymbol(symbol);
+                if (id == kUnknownSymbol) continue;
+                state.symbols.erase(id);
+                feed.subscribers[id].erase(conn);
+            }
+        }
+        sendControl(conn, {{"type", subscribe ? "subscribed" : "unsubscribed"}, {"symbols", symbols}});
+    } catch (const exception& e) {
+        lock_guard<mutex> lock(clientsMutex_);
+        sendControl(conn, {{"type", "error"}, {"message", e.what()}});
+    }
 }
 
-void MarketDataServer::broadcastTrade(const TradeReport& trade) {
+// Control messages on /ws/orderbook:
+//   {"op":"subscribe","symbols":["BTC-USDT"],"interval_ms":10}   ("*" = all symbols)
+//   {"op":"unsubscribe","symbols":["BTC-USDT"]}
+//   {"op":"conflate","interval_ms":100}   -> interval for all current and future subscriptions
+//   {"op":"encoding","format":"binary"}   -> BinaryCodec frames ("json" to switch back)
+//   {"op":"slow_consumer","policy":"conflate"}   -> what to do when the outbound queue is full
+//   {"op":"resync","symbols":["BTC-USDT"]}   -> fresh snapshot after a gap ("*" = every subscription)
+// interval_ms 0 streams every delta as it happens; N > 0 sends at most one
+// conflated update per symbol every N ms.
+// Every subscription starts with an l2_snapshot; apply deltas with seq > its seq.
+void MarketDataServer::handleL2ClientMessage(crow::websocket::connection* conn, const string& message) {
+    using json = nlohmann::json;
+    try {
+        auto msg = json::parse(message);
+        string op = msg.value("op", "");
+        
+        lock_guard<mutex> lock(clientsMutex_);
+        auto it = l2Clients_.find(conn);
+        if (it == l2Clients_.end()) return;
+        L2ClientState& state = it->second;
+        auto now = chrono::steady_clock::now();
+        
+        auto setInterval = [&](uint32_t id, L2Subscription& sub, int interval) {
+            if (interval == 0) flushL2Subscription(conn, id, sub);   // don't strand pending state
+            sub.intervalMs = interval;
+            sub.nextFlush = now + chrono::milliseconds(interval);
+            wakeDispatch();   // may be sooner than the one the dispatch thread sleeps until
+        };
+        
+        if (op == "conflate") {
+            int interval = max(0, min(msg.value("interval_ms", 0), 60000));
+            state.defaultIntervalMs = interval;
+            for (auto& [id, sub] : state.subs) setInterval(id, sub, interval);
+            sendControl(conn, {{"type", "conflate_ack"}, {"interval_ms", interval}});
+        } else if (op == "encoding") {
+            state.binary = requestedBinary(msg);
+            queues_.at(conn).binary = state.binary;
+            sendControl(conn, {{"type", "encoding_ack"}, {"format", state.binary ? "binary" : "json"}});
+        } else if (op == "slow_consumer") {
+            SlowConsumerPolicy policy = requestedPolicy(msg);
+            queues_.at(conn).policy = policy;
+            sendControl(conn, {{"type", "slow_consumer_ack"}, {"policy", policyName(policy)}});
+        } else if (op == "subscribe") {
+            auto symbols = requestedSymbols(msg);
+            int interval = max(0, min(msg.value("interval_ms", state.defaultIntervalMs), 60000));
+            sendControl(conn, {{"type", "subscribed"}, {"symbols", symbols}, {"interval_ms", interval}});
+            for (const auto& symbol : symbols) {
+                if (symbol == "*") {
+                    state.allSymbols = true;
+                    state.defaultIntervalMs = interval;
+                    l2AllSymbols_.insert(conn);
+                    // Every symbol with a book so far; later symbols start from an empty book at seq 0
+                    for (uint32_t id = 0; id < bookCache_.size(); ++id) {
+                        if (bookCache_[id].seq() == 0) continue;
+                        auto [subIt, created] = state.subs.try_emplace(id);
+                        if (created) subIt->second.intervalMs = interval;
+                        enqueueSnapshot(conn, id, subIt->second);
+                    }
+                    continue;
+                }
+                uint32_t id = internSymbol(symbol);
+                L2Subscription& sub = state.subs[id];
+                setInterval(id, sub, interval);
+                l2Subscribers_[id].insert(conn);
+                enqueueSnapshot(conn, id, sub);
+            }
+        } else if (op == "unsubscribe") {
+            auto symbols = requestedSymbols(msg);
+            for (const auto& symbol : symbols) {
+                if (symbol == "*") {
+                    state.allSymbols = false;
+                    l2AllSymbols_.erase(conn);
+                    continue;
+                }
+                uint32_t id = findSymbol(symbol);
+                if (id == kUnknownSymbol) continue;
+                state.subs.erase(id);
+                l2Subscribers_[id].erase(conn);
+            }
+            sendControl(conn, {{"type", "unsubscribed"}, {"symbols", symbols}});
+        } else if (op == "resync") {
+            auto symbols = requestedSymbols(msg);
+            for (const auto& symbol : symbols) {
+                if (symbol == "*") {
+                    for (auto& [id, sub] : state.subs) enqueueSnapshot(conn, id, sub);
+                    continue;
+                }
+                uint32_t id = findSymbol(symbol);
+                auto subIt = (id == kUnknownSymbol) ? state.subs.end() : state.subs.find(id);
+                if (subIt == state.subs.end()) {
+                    if (!state.allSymbols) throw invalid_argument("not subscribed: " + symbol);
+                    if (id == kUnknownSymbol) id = internSymbol(symbol);
+                    subIt = state.subs.try_emplace(id).first;
+                    subIt->second.intervalMs = state.defaultIntervalMs;
+                }
+                enqueueSnapshot(conn, id, subIt->second);
+            }
+        } else {
+            throw invalid_argument("unknown op: " + op);
+        }
+    } catch (const exception& e) {
+        lock_guard<mutex> lock(clientsMutex_);
+        sendControl(conn, {{"type", "error"}, {"message", e.what()}});
+    }
+}
+
+// ---- order-entry sessions (/ws/orders) ----
+
+namespace {
+
+// {"type":"ack","req_id":..,"op":..,"order_id":..,"status":..,"filled_quantity":..,
+//  "leaves_quantity":..,"message":..}; req_id only when the request had one
+string orderAck(const string& requestId, const char* op, const string& orderId, const char* status,
+                double filled, double leaves, const string& message) {
+    string out;
+    JsonWriter w(out);
+    w.raw("{\"type\":\"ack\"");
+    if (!requestId.empty()) {
+        w.raw(',');
+        w.key("req_id");
+        w.raw(requestId);
+    }
+    w.raw(",\"op\":\"");
+    w.raw(op);
+    w.raw("\",");
+    w.key("order_id");
+    w.string(orderId);
+    w.raw(",\"status\":\"");
+    w.raw(status);
+    w.raw("\",");
+    w.key("filled_quantity");
+    w.quotedNumber(filled);
+    w.raw(',');
+    w.key("leaves_quantity");
+    w.quotedNumber(leaves);
+    w.raw(',');
+    w.key("message");
+    w.string(message);
+    w.raw('}');
+    return out;
+}
+
+// {"type":"fill","order_id":..,"trade_id":..,"symbol":..,"side":..,"price":..,"quantity":..,
+//  "leaves_quantity":..,"fee":..,"liquidity":"taker"|"maker","timestamp":..}
+string orderFill(const string& orderId, const TradeReport& trade, Side side, double leaves, bool taker) {
+    string out;
+    JsonWriter w(out);
+    w.raw("{\"type\":\"fill\",");
+    w.key("order_id");
+    w.string(orderId);
+    w.raw(',');
+    w.key("trade_id");
+    w.string(trade.tradeId);
+    w.raw(',');
+    w.key("symbol");
+    w.string(trade.symbol);
+    w.raw(side == Side::BUY ? ",\"side\":\"buy\"," : ",\"side\":\"sell\",");
+    w.key("price");
+    w.quotedNumber(trade.price);
+    w.raw(',');
+    w.key("quantity");
+    w.quotedNumber(trade.quantity);
+    w.raw(',');
+    w.key("leaves_quantity");
+    w.quotedNumber(leaves);
+    w.raw(',');
+    w.key("fee");
+    w.quotedNumber(taker ? trade.takerFee : trade.makerFee);
+    w.raw(taker ? ",\"liquidity\":\"taker\"," : ",\"liquidity\":\"maker\",");
+    w.key("timestamp");
+    w.quotedNumber(trade.timestamp);
+    w.raw('}');
+    return out;
+}
+
+// {"type":"heartbeat","req_id":..}
+string orderHeartbeat(const string& requestId) {
+    string out;
+    JsonWriter w(out);
+    w.raw("{\"type\":\"heartbeat\"");
+    if (!requestId.empty()) {
+        w.raw(',');
+        w.key("req_id");
+        w.raw(requestId);
+    }
+    w.raw('}');
+    return out;
+}
+
+// {"type":"error","req_id":..,"error":..,"offset":..}; offset only for parse errors
+string orderError(const string& requestId, const char* error, const size_t* offset = nullptr) {
+    string out;
+    JsonWriter w(out);
+    w.raw("{\"type\":\"error\"");
+    if (!requestId.empty()) {
+        w.raw(',');
+        w.key("req_id");
+        w.raw(requestId);
+    }
+    w.raw(',');
+    w.key("error");
+    w.string(error);
+    if (offset) {
+        w.raw(',');
+        w.key("offset");
+        w.quotedNumber(static_cast<uint64_t>(*offset));
+    }
+    w.raw('}');
+    return out;
+}
+
+// Engine owner tag of each session, unique within the process
+atomic<uint64_t> orderSessionCounter{0};
+
+void appendTakerFills(vector<string>& out, const string& orderId, Side side, double quantity,
+                      double filledBefore, const vector<TradeReport>& trades) {
+    double filled = filledBefore;
+    for (const auto& trade : trades) {
+        filled += trade.quantity;
+        out.push_back(orderFill(orderId, trade, side, max(0.0, quantity - filled), true));
+    }
+}
+
+} // namespace
+
+size_t MarketDataServer::addOrderSession(crow::websocket::connection* conn) {
+    // Created with its options by the accept handler
+    shared_ptr<OrderSession> session(static_cast<OrderSession*>(conn->userdata()));
+    conn->userdata(nullptr);
+    session->conn = conn;
+    session->owner = "ws:" + to_string(++orderSessionCounter);
+    session->lastActivity = chrono::steady_clock::now();
     lock_guard<mutex> lock(clientsMutex_);
-    string message = trade.toJson().dump();
+    orderSessions_.emplace(conn, move(session));
+    ClientQueue& queue = queues_[conn];
+    queue.feed = "orders";
+    queue.policy = SlowConsumerPolicy::DISCONNECT;
+    queue.limit = config_.maxOrderSessionQueueDepth;
+    wakeDispatch();   // its heartbeat deadline
+    return orderSessions_.size();
+}
+
+size_t MarketDataServer::removeOrderSession(crow::websocket::connection* conn) {
+    shared_ptr<OrderSession> session;
+    size_t remaining;
+    {
+        lock_guard<mutex> sendLock(sendMutex_);
+        lock_guard<mutex> lock(clientsMutex_);
+        queues_.erase(conn);
+        auto it = orderSessions_.find(conn);
+        if (it != orderSessions_.end()) {
+            session = move(it->second);
+            session->open = false;
+            orderSessions_.erase(it);
+        }
+        remaining = orderSessions_.size();
+    }
+    if (session) endOrderSession(session);
+    return remaining;
+}
+
+void MarketDataServer::expireOrderSession(crow::websocket::connection* conn) {
+    shared_ptr<OrderSession> session;
+    {
+        lock_guard<mutex> lock(clientsMutex_);
+        auto it = orderSessions_.find(conn);
+        if (it == orderSessions_.end()) return;
+        session = move(it->second);
+        session->open = false;
+        orderSessions_.erase(it);   // later requests are ignored; onclose finds nothing to do
+        
+        ClientQueue& queue = queues_.at(conn);
+        queue.closing = true;
+        queue.closeReason = "heartbeat timeout";
+        dispatchPending_ = true;
+    }
+    LOG_WARN("[WS] Order session {} missed its heartbeat, closing", session->owner);
+    endOrderSession(session);
+}
+
+void MarketDataServer::endOrderSession(const shared_ptr<OrderSession>& session) {
+    if (session->cancelOnDisconnect) {
+        // Queued behind everything the session sent before it went, so those orders go too
+        MassCancelRequest request;
+        request.owner = session->owner;
+        engineLoop_.massCancel(move(request), [owner = session->owner](const vector<string>& canceled) {
+            if (!canceled.empty()) LOG_INFO("[WS] Canceled {} orders of {} on disconnect", canceled.size(), owner);
+        });
+    }
     
-    for (auto* client : tradeClients_) {
-        try {
-            client->send_text(message);
-        } catch (const exception& e) {
-            cerr << "Failed to send trade to client: " << e.what() << endl;
+    // Forget the owners that can no longer be reached (without cancel-on-disconnect
+    // the orders stay on the book)
+    lock_guard<mutex> lock(ownersMu_);
+    for (auto it = orderOwners_.begin(); it != orderOwners_.end();) {
+        auto owner = it->second.session.lock();
+        if (!owner || owner == session) it = orderOwners_.erase(it);
+        else ++it;
+    }
+}
+
+bool MarketDataServer::ownedBy(const string& orderId, const OrderSession* session) {
+    lock_guard<mutex> lock(ownersMu_);
+    auto it = orderOwners_.find(orderId);
+    return it != orderOwners_.end() && it->second.session.lock().get() == session;
+}
+
+void MarketDataServer::deliverToSession(const OrderSession& session, vector<string>& messages) {
+    lock_guard<mutex> lock(clientsMutex_);
+    if (!session.open) return;
+    for (auto& message : messages) enqueue(session.conn, make_shared<const string>(move(message)), false);
+}
+
+// Requests on /ws/orders (see OrderRequest for the schema). Each is parsed on the
+// connection's io thread and handed to the engine loop like POST /orders, so a
+// client may pipeline any number of them without waiting. Replies carry the
+// request's req_id; those the engine ran come back in the order it ran them,
+// while requests refused up front (bad message, not this session's order, engine
+// busy) are answered at once:
+//   {"type":"ack",..}    one per request
+//   {"type":"fill",..}   taker fills right after their ack, maker fills as they happen
+//   {"type":"error",..}  unparseable request or engine busy; nothing was done
+void MarketDataServer::handleOrderRequest(crow::websocket::connection* conn, const string& message) {
+    shared_ptr<OrderSession> session;
+    {
+        lock_guard<mutex> lock(clientsMutex_);
+        auto it = orderSessions_.find(conn);
+        if (it == orderSessions_.end()) return;
+        session = it->second;
+        session->lastActivity = chrono::steady_clock::now();
+    }
+    vector<string> replies;
+    
+    OrderRequest request;
+    OrderParseError error;
+    if (!orderParser_.parseRequest(message, request, error)) {
+        LOG_DEBUG("Order session request error: {} at offset {}", error.message, error.offset);
+        replies.push_back(orderError(request.requestId, error.message, &error.offset));
+        deliverToSession(*session, replies);
+        return;
+    }
+    const string& orderId = request.order.orderId;
+    
+    bool queued = true;
+    switch (request.op) {
+        case OrderRequest::Op::NEW: {
+            Order& order = request.order;
+            order.timestamp = Order::now();
+            order.owner = session->owner;
+            
+            // Own the order before it can rest, so no maker fill is missed; a duplicate
+            // id keeps its current owner (the engine rejects the duplicate)
+            bool registered;
+            {
+                lock_guard<mutex> lock(ownersMu_);
+                registered = orderOwners_.try_emplace(orderId, OwnedOrder{session, order.side, order.quantity, 0.0,
+                                                                          order.isConditional()}).second;
+            }
+            Side side = order.side;
+            double quantity = order.quantity;
+            bool conditional = order.isConditional();
+            auto onResponse = [this, session, requestId = request.requestId, orderId, side, quantity,
+                               registered, conditional](const OrderResponse& response) {
+                bool resting = (response.result == OrderResult::ACCEPTED);
+                if (registered) {
+                    lock_guard<mutex> lock(ownersMu_);
+                    auto it = orderOwners_.find(orderId);
+                    if (it != orderOwners_.end() && !resting) orderOwners_.erase(it);
+                }
+                double leaves = resting ? quantity - response.filledQuantity : 0.0;
+                vector<string> out;
+                out.push_back(orderAck(requestId, "new", orderId, statusName(response.result),
+                                       response.filledQuantity, leaves, response.message));
+                // A conditional order that fired at once got its fills from the trade feed
+                if (!conditional) appendTakerFills(out, orderId, side, quantity, 0.0, response.trades);
+                deliverToSession(*session, out);
+            };
+            queued = engineLoop_.submit(order, move(onResponse));
+            if (!queued && registered) {
+                lock_guard<mutex> lock(ownersMu_);
+                orderOwners_.erase(orderId);
+            }
+            break;
+        }
+        case OrderRequest::Op::CANCEL: {
+            if (!ownedBy(orderId, session.get())) {
+                replies.push_back(orderAck(request.requestId, "cancel", orderId, "rejected_unknown_order",
+                                           0.0, 0.0, "Order not found or not resting"));
+                break;
+            }
+            queued = engineLoop_.cancel(orderId, [this, session, requestId = request.requestId,
+                                                  orderId](bool canceled) {
+                double filled = 0.0;
+                if (canceled) {
+                    lock_guard<mutex> lock(ownersMu_);
+                    auto it = orderOwners_.find(orderId);
+                    if (it != orderOwners_.end()) {
+                        filled = it->second.filled;
+                        orderOwners_.erase(it);
+                    }
+                }
+                vector<string> out;
+                out.push_back(orderAck(requestId, "cancel", orderId,
+                                       canceled ? "canceled" : "rejected_unknown_order", filled, 0.0,
+                                       canceled ? "Order canceled" : "Order not found or not resting"));
+                deliverToSession(*session, out);
+            });
+            break;
+        }
+        case OrderRequest::Op::AMEND: {
+            if (!ownedBy(orderId, session.get())) {
+                replies.push_back(orderAck(request.requestId, "amend", orderId, "rejected_unknown_order",
+                                           0.0, 0.0, "Order not found or not resting"));
+                break;
+            }
+            double newQuantity = request.order.quantity;
+            queued = engineLoop_.amend(orderId, request.order.price, newQuantity,
+                                       [this, session, requestId = request.requestId, orderId,
+                                        newQuantity](const OrderResponse& response) {
+                vector<string> out;
+                bool rejected = response.result != OrderResult::ACCEPTED &&
+                                response.result != OrderResult::PARTIALLY_FILLED &&
+                                response.result != OrderResult::COMPLETELY_FILLED;
+                if (rejected) {
+                    out.push_back(orderAck(requestId, "amend", orderId, statusName(response.result),
+                                           0.0, 0.0, response.message));
+                    deliverToSession(*session, out);
+                    return;
+                }
+                
+                double quantity = newQuantity;
+                // Its fills were counted as they traded; the ack reports the ones this amend made
+                double filledBefore = response.filledQuantity;
+                for (const auto& trade : response.trades) filledBefore -= trade.quantity;
+                Side side = Side::BUY;
+                bool conditional = false;
+                {
+                    lock_guard<mutex> lock(ownersMu_);
+                    auto it = orderOwners_.find(orderId);
+                    if (it != orderOwners_.end()) {
+                        OwnedOrder& owned = it->second;
+                        if (newQuantity > 0) owned.quantity = newQuantity;
+                        quantity = owned.quantity;
+                        side = owned.side;
+                        conditional = owned.conditional;
+                        if (response.result == OrderResult::COMPLETELY_FILLED) orderOwners_.erase(it);
+                    }
+                }
+                double leaves = response.result == OrderResult::COMPLETELY_FILLED
+                                    ? 0.0 : quantity - response.filledQuantity;
+                out.push_back(orderAck(requestId, "amend", orderId, statusName(response.result),
+                                       response.filledQuantity, leaves, response.message));
+                if (!conditional) appendTakerFills(out, orderId, side, quantity, filledBefore, response.trades);
+                deliverToSession(*session, out);
+            });
+            break;
+        }
+        case OrderRequest::Op::HEARTBEAT:
+            replies.push_back(orderHeartbeat(request.requestId));
+            break;
+    }
+    if (!queued) replies.push_back(orderError(request.requestId, "engine busy, retry later"));
+    if (!replies.empty()) deliverToSession(*session, replies);
+}
+
+// Runs on the matching thread, under the engine lock
+void MarketDataServer::onOrderTrade(const TradeReport& trade) {
+    // Maker and taker may both be owned, by different sessions or by the same one
+    shared_ptr<OrderSession> makerSession, takerSession;
+    vector<string> makerOut, takerOut;
+    {
+        lock_guard<mutex> lock(ownersMu_);
+        auto it = orderOwners_.find(trade.makerOrderId);
+        if (it != orderOwners_.end()) {
+            OwnedOrder& owned = it->second;
+            owned.filled += trade.quantity;
+            double leaves = max(0.0, owned.quantity - owned.filled);
+            makerSession = owned.session.lock();
+            if (makerSession) makerOut.push_back(orderFill(trade.makerOrderId, trade, owned.side, leaves, false));
+            if (leaves <= 0.0) orderOwners_.erase(it);
+        }
+        // The taker's own fills are counted here too, before any other thread can hit its
+        // remainder. Only a fired conditional order gets them as fills from here; anything
+        // else gets them with the ack of the request that matched, which also forgets it.
+        it = orderOwners_.find(trade.takerOrderId);
+        if (it != orderOwners_.end()) {
+            OwnedOrder& owned = it->second;
+            owned.filled += trade.quantity;
+            if (owned.conditional) {
+                double leaves = max(0.0, owned.quantity - owned.filled);
+                takerSession = owned.session.lock();
+                if (takerSession) takerOut.push_back(orderFill(trade.takerOrderId, trade, owned.side, leaves, true));
+                if (leaves <= 0.0) orderOwners_.erase(it);
+            }
+        }
+    }
+    if (makerSession) deliverToSession(*makerSession, makerOut);
+    if (takerSession) deliverToSession(*takerSession, takerOut);
+}
+
+// Runs on the matching thread, under the engine lock. A fired order that rests stays
+// owned for its maker fills; one that filled completely was forgotten by its last fill.
+// Anything else (rejected for trading through, market remainder canceled) is forgotten
+// here and reported with an unsolicited "trigger" ack.
+void MarketDataServer::onOrderTriggered(const TriggeredOrder& fired) {
+    if (fired.resting) return;
+    shared_ptr<OrderSession> session;
+    {
+        lock_guard<mutex> lock(ownersMu_);
+        auto it = orderOwners_.find(fired.orderId);
+        if (it == orderOwners_.end()) return;
+        session = it->second.session.lock();
+        orderOwners_.erase(it);
+    }
+    if (!session) return;
+    vector<string> out;
+    out.push_back(orderAck("", "trigger", fired.orderId, statusName(fired.result), fired.filledQuantity,
+                           0.0, fired.message));
+    deliverToSession(*session, out);
+}
+
+void MarketDataServer::enqueue(crow::websocket::connection* conn,
+                               const shared_ptr<const string>& payload, bool binary) {
+    auto it = queues_.find(conn);
+    if (it == queues_.end()) return;
+    ClientQueue& queue = it->second;
+    if (queue.closing) return;
+    
+    if (queueFull(queue)) {
+        ++queue.dropped;
+        if (queue.policy == SlowConsumerPolicy::DISCONNECT) {
+            queue.closing = true;
+            wakeDispatch();
+        } else {
+            ++queue.gapDropped;
+        }
+        return;
+    }
+    // Tell the client how much it missed before it sees anything newer
+    if (queue.gapDropped > 0) {
+        queue.messages.push_back({gapMarker(queue.gapDropped, queue.binary), queue.binary});
+        queue.gapDropped = 0;
+    }
+    queue.messages.push_back({payload, binary});
+    ++queue.enqueued;
+    queue.maxDepth = max(queue.maxDepth, queue.messages.size());
+    wakeDispatch();
+}
+
+template<typename EncodeJson, typename EncodeBinary>
+void MarketDataServer::fanOut(SymbolFeed& feed, uint32_t symbolId,
+                              EncodeJson&& encodeJson, EncodeBinary&& encodeBinary) {
+    bool hasSymbolSubscribers = (symbolId != kUnknownSymbol && !feed.subscribers[symbolId].empty());
+    if (!hasSymbolSubscribers && feed.allSymbols.empty()) return;
+    
+    // Each encoding is built at most once, on first use, and shared by all queues
+    shared_ptr<const string> message, binary;
+    auto deliver = [&](crow::websocket::connection* client) {
+        if (feed.clients.at(client).binary) {
+            if (!binary) {
+                binaryBuffer_.clear();
+                encodeBinary(binaryBuffer_);
+                binary = make_shared<const string>(binaryBuffer_);
+            }
+            enqueue(client, binary, true);
+        } else {
+            if (!message) {
+                messageBuffer_.clear();
+                encodeJson(messageBuffer_);
+                message = make_shared<const string>(messageBuffer_);
+            }
+            enqueue(client, message, false);
+        }
+    };
+    
+    for (auto* client : feed.allSymbols) deliver(client);
+    if (hasSymbolSubscribers) {
+        for (auto* client : feed.subscribers[symbolId]) {
+            if (!feed.allSymbols.count(client)) deliver(client);
         }
     }
 }
 
-void MarketDataServer::broadcastL2Update(const L2Update& update) {
+void MarketDataServer::broadcastExecution(const ExecutionBatch& batch) {
     lock_guard<mutex> lock(clientsMutex_);
+    fanOut(tradeSubs_, findSymbol(batch.symbol),
+           [&](string& out) { MarketDataSerializer::appendExecutionBatch(out, batch); },
+           [&](string& out) { BinaryCodec::encodeExecutionBatch(out, batch); });
+}
+
+void MarketDataServer::broadcastL3Event(const L3Event& event) {
+    lock_guard<mutex> lock(clientsMutex_);
+    fanOut(l3Subs_, findSymbol(event.symbol),
+           [&](string& out) { MarketDataSerializer::appendL3Event(out, event); },
+           [&](string& out) { BinaryCodec::encodeL3Event(out, event); });
+}
+
+void MarketDataServer::broadcastL2Delta(const L2Delta& delta) {
+    unique_lock<mutex> lock(clientsMutex_);
+    
+    // Every symbol gets an id: the book cache follows all of them
+    uint32_t id = internSymbol(delta.symbol);
+    if (!bookCache_[id].apply(delta)) {
+        // The engine's book had history before this server attached; seed once from it.
+        // The full-depth copy is built with clientsMutex_ released so it never stalls the
+        // dispatch thread or the control handlers. Deltas are published one at a time under
+        // the engine lock, so no other delta reaches this cache in between.
+        lock.unlock();
+        L2Update seed = engine_.getL2Update(delta.symbol, INT_MAX);
+        lock.lock();
+        bookCache_[id].reset(seed);
+    }
+    if (l2Subscribers_[id].empty() && l2AllSymbols_.empty()) return;
+    
+    // Built lazily, once per encoding, for all raw subscribers
+    shared_ptr<const string> rawMessage, rawBinary;
     
-    nlohmann::json json = {
-        {"timestamp", to_string(update.timestamp)},
-        {"symbol", update.symbol},
-        {"bids", nlohmann::json::array()},
-        {"asks", nlohmann::json::array()}
+    auto deliver = [&](crow::websocket::connection* client) {
+        L2ClientState& state = l2Clients_.at(client);
+        auto [subIt, created] = state.subs.try_emplace(id);
+        L2Subscription& sub = subIt->second;
+        if (created) sub.intervalMs = state.defaultIntervalMs;   // lazily created "*" subscription
+        
+        // A raw subscriber whose queue is full (or still has folded state to catch up on)
+        // is conflated too under the CONFLATE policy; the dispatch thread flushes it once
+        // the queue drains
+        bool congested = false;
+        if (sub.intervalMs == 0) {
+            ClientQueue& queue = queues_.at(client);
+            congested = sub.pending.firstSeq != 0
+                || (queue.policy == SlowConsumerPolicy::CONFLATE && queueFull(queue));
+            if (congested) ++queue.conflated;
+        }
+        
+        if (sub.intervalMs > 0 || congested) {
+            // Fold into the latest state; the dispatch thread sends it
+            PendingL2& pending = sub.pending;
+            if (pending.firstSeq == 0) {
+                pending.firstSeq = delta.seq;
+                wakeDispatch();   // a new flush deadline
+            }
+            pending.lastSeq = delta.seq;
+            pending.timestamp = delta.timestamp;
+            for (const auto& level : delta.changes) {
+                pending.levels[{static_cast<int>(level.side), level.price}] = level.quantity;
+            }
+            return;
+        }
+        
+        if (state.binary) {
+            if (!rawBinary) {
+                binaryBuffer_.clear();
+                BinaryCodec::encodeL2Delta(binaryBuffer_, delta.symbol, delta.seq, delta.seq,
+                                           delta.timestamp, delta.changes);
+                rawBinary = make_shared<const string>(binaryBuffer_);
+            }
+            enqueue(client, rawBinary, true);
+        } else {
+            if (!rawMessage) {
+                messageBuffer_.clear();
+                MarketDataSerializer::appendL2Delta(messageBuffer_, delta.symbol, delta.seq, delta.seq,
+                                                    delta.timestamp, delta.changes);
+                rawMessage = make_shared<const string>(messageBuffer_);
+            }
+            enqueue(client, rawMessage, false);
+        }
     };
     
-    for (const auto& [price, qty] : update.bids) {
-        json["bids"].push_back({to_string(price), to_string(qty)});
+    for (auto* client : l2AllSymbols_) deliver(client);
+    for (auto* client : l2Subscribers_[id]) {
+        if (!l2AllSymbols_.count(client)) deliver(client);
     }
+}
+
+// Caller holds clientsMutex_
+void MarketDataServer::flushL2Subscription(crow::websocket::connection* conn, uint32_t symbolId,
+                                           L2Subscription& sub) {
+    PendingL2& pending = sub.pending;
+    if (pending.firstSeq == 0) return;
     
-    for (const auto& [price, qty] : update.asks) {
-        json["asks"].push_back({to_string(price), to_string(qty)});
+    // first_seq < seq tells the client several deltas were folded together
+    levelScratch_.clear();
+    for (const auto& [key, qty] : pending.levels) {
+        levelScratch_.push_back({static_cast<Side>(key.first), key.second, qty});
+    }
+    flushBuffer_.clear();
+    bool binary = l2Clients_.at(conn).binary;
+    if (binary) {
+        BinaryCodec::encodeL2Delta(flushBuffer_, symbolNames_[symbolId], pending.firstSeq,
+                                   pending.lastSeq, pending.timestamp, levelScratch_);
+    } else {
+        MarketDataSerializer::appendL2Delta(flushBuffer_, symbolNames_[symbolId], pending.firstSeq,
+                                            pending.lastSeq, pending.timestamp, levelScratch_);
     }
+    enqueue(conn, make_shared<const string>(flushBuffer_), binary);
+    pending = PendingL2{};
+}
+
+void MarketDataServer::enqueueSnapshot(crow::websocket::connection* conn, uint32_t symbolId,
+                                       L2Subscription& sub) {
+    // Anything folded so far is covered by the snapshot
+    sub.pending = PendingL2{};
     
-    string message = json.dump();
+    bookCache_[symbolId].snapshot(symbolNames_[symbolId], snapshotScratch_);
+    flushBuffer_.clear();
+    bool binary = l2Clients_.at(conn).binary;
+    if (binary) BinaryCodec::encodeL2Snapshot(flushBuffer_, snapshotScratch_);
+    else MarketDataSerializer::appendL2Snapshot(flushBuffer_, snapshotScratch_);
+    enqueue(conn, make_shared<const string>(flushBuffer_), binary);
+}
+
+void MarketDataServer::dispatchLoop() {
+    struct Outgoing {
+        crow::websocket::connection* conn;
+        OutboundMessage message;
+    };
+    vector<Outgoing> batch;
+    vector<pair<crow::websocket::connection*, const char*>> toClose;   // with the reason
+    vector<crow::websocket::connection*> lapsed;                        // order sessions past their heartbeat
     
-    for (auto* client : l2Clients_) {
-        try {
-            client->send_text(message);
-        } catch (const exception& e) {
-            cerr << "Failed to send L2 update to client: " << e.what() << endl;
+    // Idle, the thread sleeps until the earliest conflation flush or heartbeat deadline,
+    // or until woken (wakeDispatch); it never polls clientsMutex_
+    using Clock = chrono::steady_clock;
+    auto wakeAt = Clock::time_point::max();
+    while (running_) {
+        {
+            unique_lock<mutex> lock(clientsMutex_);
+            auto woken = [this]() { return dispatchPending_ || !running_; };
+            if (wakeAt == Clock::time_point::max()) dispatchCv_.wait(lock, woken);
+            else dispatchCv_.wait_until(lock, wakeAt, woken);
+            // Cleared before the scan: anything queued or scheduled after it wakes us again
+            dispatchPending_ = false;
+            
+            auto now = Clock::now();
+            wakeAt = Clock::time_point::max();
+            for (auto& [client, state] : l2Clients_) {
+                const ClientQueue& queue = queues_.at(client);
+                bool full = queueFull(queue);
+                for (auto& [id, sub] : state.subs) {
+                    if (sub.pending.firstSeq == 0) continue;
+                    if (sub.intervalMs > 0 && now < sub.nextFlush) {
+                        wakeAt = min(wakeAt, sub.nextFlush);
+                        continue;
+                    }
+                    // CONFLATE keeps folding until there is room to send the folded state;
+                    // the drain below makes room, so look again right after it
+                    if (full && queue.policy == SlowConsumerPolicy::CONFLATE) {
+                        wakeAt = now;
+                        continue;
+                    }
+                    flushL2Subscription(client, id, sub);
+                    if (sub.intervalMs > 0) sub.nextFlush = now + chrono::milliseconds(sub.intervalMs);
+                }
+            }
+            for (const auto& [conn, session] : orderSessions_) {
+                if (session->heartbeat.count() == 0) continue;
+                auto deadline = session->lastActivity + session->heartbeat;
+                if (now > deadline) lapsed.push_back(conn);
+                else wakeAt = min(wakeAt, deadline + chrono::milliseconds(1));
+            }
+        }
+        for (auto* conn : lapsed) expireOrderSession(conn);
+        lapsed.clear();
+        
+        // Hand everything queued to the sockets. clientsMutex_ is only held to take the
+        // messages, so broadcasts never wait on sends; sendMutex_ keeps the connections
+        // alive until the batch is out.
+        lock_guard<mutex> sendLock(sendMutex_);
+        {
+            lock_guard<mutex> lock(clientsMutex_);
+            for (auto& [conn, queue] : queues_) {
+                if (queue.closing) {
+                    if (!queue.closeSent) toClose.push_back({conn, queue.closeReason});
+                    queue.closeSent = true;
+                    queue.messages.clear();
+                    continue;
+                }
+                for (auto& message : queue.messages) batch.push_back({conn, move(message)});
+                queue.sent += queue.messages.size();
+                queue.messages.clear();
+                if (queue.gapDropped > 0) {   // drained: report what was dropped
+                    batch.push_back({conn, {gapMarker(queue.gapDropped, queue.binary), queue.binary}});
+                    queue.gapDropped = 0;
+                }
+            }
+        }
+        for (auto& out : batch) {
+            try {
+                if (out.message.binary) out.conn->send_binary(*out.message.payload);
+                else out.conn->send_text(*out.message.payload);
+            } catch (const exception& e) {
+                LOG_WARN("Failed to send to client: {}", e.what());
+            }
+        }
+        for (auto [conn, reason] : toClose) {
+            LOG_WARN("[WS] Disconnecting client: {}", reason);
+            conn->close(reason, crow::websocket::PolicyViolated);
         }
+        batch.clear();
+        toClose.clear();
     }
 }
 
+nlohmann::json MarketDataServer::clientStats() {
+    using json = nlohmann::json;
+    lock_guard<mutex> lock(clientsMutex_);
+    json clients = json::array();
+    for (const auto& [conn, queue] : queues_) {
+        clients.push_back({
+            {"feed", queue.feed},
+            {"policy", policyName(queue.policy)},
+            {"queue_depth", queue.messages.size()},
+            {"max_queue_depth", queue.maxDepth},
+            {"enqueued", queue.enqueued},
+            {"sent", queue.sent},
+            {"dropped", queue.dropped},
+            {"conflated", queue.conflated},
+            {"closing", queue.closing}
+        });
+    }
+    return {
+        {"queue_limit", config_.maxQueueDepth},
+        {"clients", clients}
+    };
+}
+
 void MarketDataServer::run() {
     cout << "=== STARTING ENHANCED MARKET DATA SERVER ===" << endl;
     cout << "Endpoints available:" << endl;
     cout << "  POST /orders - Submit orders" << endl;
+    cout << "  DELETE /orders/<id> - Cancel a resting order" << endl;
+    cout << "  PATCH /orders/<id> - Amend price/quantity of a resting order" << endl;
     cout << "  GET /bbo/<symbol> - Best bid/offer" << endl;
     cout << "  GET /orderbook/<symbol>?depth=N - L2 order book" << endl;
+    cout << "  GET /marketdata/clients - Per-connection queue metrics" << endl;
     cout << "  GET /health - Health check" << endl;
     cout << "  WS /ws/trades - Trade feed" << endl;
-    cout << "  WS /ws/orderbook - L2 order book feed" << endl;
+    cout << "  WS /ws/orderbook - L2 order book delta feed" << endl;
+    cout << "  WS /ws/l3 - L3 order-by-order feed" << endl;
+    cout << "  WS /ws/orders - Order-entry session (pipelined requests, acks and fills)" << endl;
     app_.run();
 }
\ No newline at end of file
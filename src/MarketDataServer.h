@@ -1,37 +1,253 @@
 #pragma once
 #include "MatchingEngine.h"
-#include <crow.h>
+#include "L2BookCache.h"
+#include "OrderJsonParser.h"
+#include "EngineLoop.h"
+#include "crow_all.h"   // vendored, with local fixes for deferred responses
 #include <nlohmann/json.hpp>
 #include <vector>
 #include <mutex>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+
+// What happens when a connection's outbound queue is full
+enum class SlowConsumerPolicy {
+    CONFLATE,     // L2: fold deltas into the latest size per level until the queue drains;
+                  // trades and L3 cannot be folded and fall back to DROP
+    DROP,         // drop new messages, then send {"type":"gap","dropped":N}
+    DISCONNECT    // close the connection
+};
+
+struct MarketDataConfig {
+    size_t maxQueueDepth = 1024;   // outbound messages per connection
+    SlowConsumerPolicy slowConsumerPolicy = SlowConsumerPolicy::CONFLATE;
+    size_t maxPendingOrders = 65536;   // order requests queued for the engine before 503s
+    size_t maxOrderSessionQueueDepth = 65536;   // /ws/orders replies are never dropped: a session
+                                                // this far behind is disconnected instead
+};
 
 class MarketDataServer {
 public:
-    MarketDataServer(MatchingEngine& engine, int port = 8080);
-    ~MarketDataServer() = default;
+    MarketDataServer(MatchingEngine& engine, int port = 8080,
+                     const MarketDataConfig& config = MarketDataConfig{});
+    ~MarketDataServer();
     
     void run();
     void stop();
+    // Port the server listens on; with port 0, waits for run() on another thread to bind
+    uint16_t port();
     
 private:
     void setupRestRoutes();
     void setupWebSocketEndpoints();
     
-    // WebSocket client management
-    void addTradeClient(crow::websocket::connection* conn);
-    void removeTradeClient(crow::websocket::connection* conn);
-    void addL2Client(crow::websocket::connection* conn);
-    void removeL2Client(crow::websocket::connection* conn);
+    // Client state on a plain per-symbol feed (/ws/trades, /ws/l3)
+    struct FeedClientState {
+        bool binary = false;         // BinaryCodec frames instead of JSON text
+        bool allSymbols = false;
+        std::unordered_set<uint32_t> symbols;
+    };
+    
+    // Clients and subscription index of one plain per-symbol feed
+    struct SymbolFeed {
+        std::unordered_map<crow::websocket::connection*, FeedClientState> clients;
+        std::vector<std::unordered_set<crow::websocket::connection*>> subscribers;   // by symbol id
+        std::unordered_set<crow::websocket::connection*> allSymbols;                // "*"
+    };
+    
+    // Bounded outbound queue of one connection, drained by the dispatch thread
+    struct OutboundMessage {
+        std::shared_ptr<const std::string> payload;   // shared by every client it fans out to
+        bool binary = false;
+    };
+    
+    struct ClientQueue {
+        const char* feed = "";
+        SlowConsumerPolicy policy = SlowConsumerPolicy::CONFLATE;
+        size_t limit = 0;          // 0 = MarketDataConfig::maxQueueDepth
+        bool binary = false;       // the client's encoding, for the gap markers queued here
+        std::deque<OutboundMessage> messages;
+        uint64_t gapDropped = 0;   // dropped since the last gap marker
+        bool closing = false;      // DISCONNECT policy tripped; dispatch thread closes it
+        const char* closeReason = "slow consumer";
+        bool closeSent = false;
+        
+        // Metrics
+        uint64_t enqueued = 0;
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+        uint64_t conflated = 0;
+        size_t maxDepth = 0;
+    };
+    
+    // Queue a message for conn, applying its slow-consumer policy (caller holds clientsMutex_)
+    void enqueue(crow::websocket::connection* conn, const std::shared_ptr<const std::string>& payload,
+                 bool binary);
+    // Queue a JSON control reply (ack or error) behind the data already queued for
+    // conn (caller holds clientsMutex_)
+    void sendControl(crow::websocket::connection* conn, const nlohmann::json& msg);
+    // Wake the dispatch thread: something is queued, or a deadline it sleeps past
+    // has appeared (caller holds clientsMutex_)
+    void wakeDispatch() {
+        if (dispatchPending_) return;
+        dispatchPending_ = true;
+        dispatchCv_.notify_one();
+    }
+    bool queueFull(const ClientQueue& queue) const {
+        return queue.messages.size() >= (queue.limit ? queue.limit : config_.maxQueueDepth);
+    }
+    nlohmann::json clientStats();
+    
+    // WebSocket client management; each returns the feed's client count after the
+    // change, read under clientsMutex_
+    size_t addFeedClient(SymbolFeed& feed, crow::websocket::connection* conn);
+    size_t removeFeedClient(SymbolFeed& feed, crow::websocket::connection* conn);
+    size_t addL2Client(crow::websocket::connection* conn);
+    size_t removeL2Client(crow::websocket::connection* conn);
+    void handleFeedClientMessage(SymbolFeed& feed, crow::websocket::connection* conn,
+                                 const std::string& message);
+    void handleL2ClientMessage(crow::websocket::connection* conn, const std::string& message);
+    
+    // Order-entry session (/ws/orders). Engine continuations hold it until they have
+    // replied; once the socket closes their replies are discarded. The options come
+    // from the URL: /ws/orders?cancel_on_disconnect=true&heartbeat_ms=N
+    struct OrderSession {
+        crow::websocket::connection* conn = nullptr;
+        std::string owner;                          // Order::owner of everything entered here
+        bool cancelOnDisconnect = false;            // mass-cancel its orders when it ends
+        std::chrono::milliseconds heartbeat{0};     // close it after this long without a message; 0 = never
+        bool open = true;                           // guarded by clientsMutex_
+        std::chrono::steady_clock::time_point lastActivity = std::chrono::steady_clock::now();   // ditto
+    };
+    
+    // Resting order entered through a session: only that session may cancel or
+    // amend it, and it receives the order's maker fills. A conditional order's
+    // taker fills also come from the trade feed, since the trade that fires it
+    // belongs to another order's response.
+    struct OwnedOrder {
+        std::weak_ptr<OrderSession> session;
+        Side side = Side::BUY;
+        double quantity = 0.0;
+        double filled = 0.0;
+        bool conditional = false;
+    };
+    
+    size_t addOrderSession(crow::websocket::connection* conn);
+    size_t removeOrderSession(crow::websocket::connection* conn);
+    // Heartbeat lapsed (dispatch thread): end the session now, close the socket after
+    void expireOrderSession(crow::websocket::connection* conn);
+    // The session is gone: cancel-on-disconnect, then forget its orders' owners
+    void endOrderSession(const std::shared_ptr<OrderSession>& session);
+    void handleOrderRequest(crow::websocket::connection* conn, const std::string& message);
+    bool ownedBy(const std::string& orderId, const OrderSession* session);
+    void onOrderTrade(const TradeReport& trade);
+    void onOrderTriggered(const TriggeredOrder& fired);
+    
+    // Queue replies for a session unless it has closed (takes clientsMutex_)
+    void deliverToSession(const OrderSession& session, std::vector<std::string>& messages);
     
     // Broadcast to clients
-    void broadcastTrade(const TradeReport& trade);
-    void broadcastL2Update(const L2Update& update);
+    void broadcastExecution(const ExecutionBatch& batch);
+    void broadcastL2Delta(const L2Delta& delta);
+    void broadcastL3Event(const L3Event& event);
+    
+    // Queue one event for every subscriber of symbolId on a plain feed, encoding it
+    // at most once per format (caller holds clientsMutex_)
+    template<typename EncodeJson, typename EncodeBinary>
+    void fanOut(SymbolFeed& feed, uint32_t symbolId, EncodeJson&& encodeJson, EncodeBinary&& encodeBinary);
+    
+    // Symbol interning for the subscription index (caller holds clientsMutex_)
+    static constexpr uint32_t kUnknownSymbol = UINT32_MAX;
+    uint32_t internSymbol(const std::string& symbol);
+    uint32_t findSymbol(const std::string& symbol) const;
+    
+    // Conflated L2 state for one symbol: latest size per touched level since the last flush
+    struct PendingL2 {
+        uint64_t firstSeq = 0;   // first delta folded in; 0 == nothing pending
+        uint64_t lastSeq = 0;    // latest delta folded in
+        long long timestamp = 0;
+        std::map<std::pair<int, double>, double> levels;   // (side, price) -> size
+    };
+    
+    // One symbol subscription; intervalMs == 0 streams every delta as it happens
+    struct L2Subscription {
+        int intervalMs = 0;
+        std::chrono::steady_clock::time_point nextFlush;
+        PendingL2 pending;
+    };
+    
+    struct L2ClientState {
+        bool binary = false;         // BinaryCodec frames instead of JSON text
+        bool allSymbols = false;     // subscribed to "*"
+        int defaultIntervalMs = 0;   // for "*" and for subscribes without interval_ms
+        std::unordered_map<uint32_t, L2Subscription> subs;   // symbol id -> subscription
+    };
+    
+    void dispatchLoop();
+    void flushL2Subscription(crow::websocket::connection* conn, uint32_t symbolId, L2Subscription& sub);
+    
+    // Queue a snapshot of the cached book and restart the subscription's
+    // conflation state from it (caller holds clientsMutex_)
+    void enqueueSnapshot(crow::websocket::connection* conn, uint32_t symbolId, L2Subscription& sub);
     
     MatchingEngine& engine_;
+    MarketDataConfig config_;
+    
+    // Engine feed subscriptions, released first thing in the destructor
+    EventFeed<ExecutionBatch>::Token executionSub_;
+    EventFeed<L2Delta>::Token deltaSub_;
+    EventFeed<L3Event>::Token l3Sub_;
+    EventFeed<TradeReport>::Token tradeSub_;
+    EventFeed<TriggeredOrder>::Token triggerSub_;
     crow::SimpleApp app_;
+    OrderJsonParser orderParser_;   // POST /orders bodies and /ws/orders requests
     
-    // WebSocket client connections
+    // WebSocket client connections. Lock order: sendMutex_, then clientsMutex_.
+    // sendMutex_ keeps connections alive while the dispatch thread writes to them.
+    std::mutex sendMutex_;
     std::mutex clientsMutex_;
-    std::vector<crow::websocket::connection*> tradeClients_;
-    std::vector<crow::websocket::connection*> l2Clients_;
+    std::unordered_map<crow::websocket::connection*, ClientQueue> queues_;
+    SymbolFeed tradeSubs_;
+    SymbolFeed l3Subs_;
+    std::unordered_map<crow::websocket::connection*, L2ClientState> l2Clients_;
+    std::unordered_map<crow::websocket::connection*, std::shared_ptr<OrderSession>> orderSessions_;
+    
+    // Subscription index: symbol id -> subscribed connections ("*" kept separately)
+    std::unordered_map<std::string, uint32_t> symbolIds_;
+    std::vector<std::string> symbolNames_;
+    std::vector<std::unordered_set<crow::websocket::connection*>> l2Subscribers_;
+    std::unordered_set<crow::websocket::connection*> l2AllSymbols_;
+    
+    // Owners of the orders entered on /ws/orders. Never held while calling into the
+    // engine or with clientsMutex_ (the trade callback takes it under the engine lock).
+    std::mutex ownersMu_;
+    std::unordered_map<std::string, OwnedOrder> orderOwners_;
+    
+    // Full-depth book per symbol id, kept current from the delta feed
+    std::vector<L2BookCache> bookCache_;
+    
+    // Reusable serialization buffers (guarded by clientsMutex_)
+    std::string messageBuffer_;
+    std::string binaryBuffer_;
+    std::string flushBuffer_;
+    std::vector<L2Level> levelScratch_;
+    L2Update snapshotScratch_;
+    
+    // Dispatch thread: drains the queues and runs the conflation timer
+    std::thread dispatchThread_;
+    std::condition_variable dispatchCv_;
+    bool dispatchPending_ = false;   // guarded by clientsMutex_
+    std::atomic<bool> running_{true};
+    
+    // Order requests. Declared last so it stops first: its destructor still runs the
+    // queued commands, whose feeds and continuations use everything above.
+    EngineLoop engineLoop_;
 };
\ No newline at end of file
@@ -1,20 +1,28 @@
 #include "MatchingEngine.h"
+#include "Logger.h"
 #include <iostream>
 #include <algorithm>
 #include <chrono>
 #include <sstream>
 
 MatchingEngine::MatchingEngine()
-    : persist_("journal.log", "snapshot.json"),
-      fees_(0.001, 0.002) {
-    std::cout << "=== MatchingEngine initialized ===" << std::endl;
+    : MatchingEngine(EngineConfig{}) {}
+
+MatchingEngine::MatchingEngine(const EngineConfig& config)
+    : config_(config),
+      fees_(0.001, 0.002),
+      persist_(config.journalFile, config.snapshotFile,
+               config.journalMode, config.fillLogFile, config.journalSegmentBytes) {
+    if (config_.consoleLogging) {
+        std::cout << "=== MatchingEngine initialized ===" << std::endl;
+    }
 }
 
 OrderResponse MatchingEngine::submitOrder(const Order& order) {
-    std::cout << "=== SUBMIT ORDER ===" << std::endl;
-    std::cout << "Order: " << order.orderId << " " << order.symbol 
-              << " " << (order.side == Side::BUY ? "BUY" : "SELL")
-              << " " << order.quantity << "@" << order.price << std::endl;
+    if (config_.consoleLogging) {
+        LOG_INFO("SUBMIT ORDER {} {} {} {}@{}", order.orderId, order.symbol,
+                 order.side == Side::BUY ? "BUY" : "SELL", order.quantity, order.price);
+    }
     
     // Validate order
     std::string errorMsg;
@@ -28,15 +36,16 @@ OrderResponse MatchingEngine::submitOrder(const Order& order) {
         allOrders_.emplace(order.orderId, order);
     }
     
-    // Log order creation
-    logOrderEvent(order, "NEW");
-    
     // Process based on order type
     OrderResponse response;
     {
         std::unique_lock lk(ordersMu_);
         Order& storedOrder = allOrders_.at(order.orderId);
         
+        // Journal under the processing lock so journal order == matching order
+        persist_.logNewCommand(++commandSeq_, storedOrder);
+        logOrderEvent(storedOrder, "NEW");
+        
         switch (order.type) {
             case OrderType::MARKET:
                 response = processMarketOrder(storedOrder);
@@ -50,7 +59,13 @@ OrderResponse MatchingEngine::submitOrder(const Order& order) {
             case OrderType::FOK:
                 response = processFOKOrder(storedOrder);
                 break;
+            case OrderType::STOP_LOSS:
+            case OrderType::STOP_LIMIT:
+            case OrderType::TAKE_PROFIT:
+                response = processConditionalOrder(storedOrder);
+                break;
         }
+        if (!response.trades.empty()) runTriggers(storedOrder.symbol, response.trades);
     }
     
     return response;
@@ -100,10 +115,11 @@ OrderResponse MatchingEngine::processLimitOrder(Order& order) {
     } else {
         // Rest on book
         book.addOrder(&order);
+        linkOwner(order);
         response.result = OrderResult::ACCEPTED;
         response.message = "Limit order rested on book";
         logOrderEvent(order, "RESTED");
-        publishL2Update(order.symbol);
+        publishBookChanges(order.symbol);
     }
     
     return response;
@@ -149,117 +165,323 @@ OrderResponse MatchingEngine::processFOKOrder(Order& order) {
     return response;
 }
 
+OrderResponse MatchingEngine::processConditionalOrder(Order& order) {
+    TriggerBook& triggers = triggers_[order.symbol];
+    if (triggers.isTriggered(order)) {
+        return triggerOrder(order);
+    }
+    
+    triggers.add(&order);
+    linkOwner(order);
+    logOrderEvent(order, "PENDING");
+    return {OrderResult::ACCEPTED, "Conditional order waiting for its trigger"};
+}
+
+OrderResponse MatchingEngine::triggerOrder(Order& order) {
+    logOrderEvent(order, "TRIGGERED");
+    order.type = (order.type == OrderType::STOP_LIMIT) ? OrderType::LIMIT : OrderType::MARKET;
+    if (order.type == OrderType::MARKET) return processMarketOrder(order);
+    
+    OrderResponse response = processLimitOrder(order);
+    if (response.result == OrderResult::REJECTED_TRADE_THROUGH) logOrderEvent(order, "CANCELED");
+    return response;
+}
+
+void MatchingEngine::runTriggers(const std::string& symbol, const std::vector<TradeReport>& trades) {
+    TriggerBook& triggers = triggers_[symbol];
+    std::vector<Order*> fired;
+    for (const auto& trade : trades) triggers.onTrade(trade.price, fired);
+    
+    // Fired orders match one at a time in firing order; whatever their trades
+    // fire queues up behind them, so a cascade stays deterministic
+    for (size_t next = 0; next < fired.size(); ++next) {
+        Order& order = *fired[next];
+        unlinkOwner(order);
+        OrderResponse response = triggerOrder(order);
+        triggerFeed_.publish({symbol, order.orderId, order.owner, response.result, response.message,
+                              order.filledQty, response.result == OrderResult::ACCEPTED});
+        for (const auto& trade : response.trades) triggers.onTrade(trade.price, fired);
+    }
+}
+
+bool MatchingEngine::cancelOrder(const std::string& orderId) {
+    std::unique_lock lk(ordersMu_);
+    auto it = allOrders_.find(orderId);
+    if (it == allOrders_.end()) return false;
+    Order& order = it->second;
+    
+    OrderBook& book = getOrCreateBook(order.symbol);
+    bool resting = book.removeOrder(&order);
+    if (!resting) {
+        auto triggers = triggers_.find(order.symbol);
+        if (triggers == triggers_.end() || !triggers->second.remove(&order)) return false;
+    }
+    unlinkOwner(order);
+    
+    persist_.logCancelCommand(++commandSeq_, orderId);
+    logOrderEvent(order, "CANCELED");
+    if (resting) publishBookChanges(order.symbol);
+    return true;
+}
+
+OrderResponse MatchingEngine::amendOrder(const std::string& orderId, double newPrice, double newQuantity) {
+    std::unique_lock lk(ordersMu_);
+    auto it = allOrders_.find(orderId);
+    if (it == allOrders_.end()) {
+        return {OrderResult::REJECTED_UNKNOWN_ORDER, "Order not found"};
+    }
+    Order& order = it->second;
+    OrderBook& book = getOrCreateBook(order.symbol);
+    if (!book.isResting(&order)) {
+        return {OrderResult::REJECTED_UNKNOWN_ORDER, "Order is not resting"};
+    }
+    
+    Order amended = order;
+    if (newPrice > 0) amended.price = newPrice;
+    if (newQuantity > 0) amended.quantity = newQuantity;
+    if (newPrice < 0 || newQuantity < 0 || amended.quantity <= order.filledQty) {
+        return {OrderResult::REJECTED_INVALID_PARAMS, "Quantity must exceed the filled quantity"};
+    }
+    bool repriced = (amended.price != order.price);
+    if (repriced && book.wouldTradeThrough(amended)) {
+        return {OrderResult::REJECTED_TRADE_THROUGH, "Amended price would trade through BBO"};
+    }
+    
+    persist_.logAmendCommand(++commandSeq_, orderId, amended.price, amended.quantity);
+    logOrderEvent(amended, "AMENDED");
+    
+    OrderResponse response;
+    response.result = OrderResult::ACCEPTED;
+    if (!repriced && amended.quantity <= order.quantity) {
+        // Size down (or no change): in place, queue position kept
+        if (amended.quantity < order.quantity) book.reduceOrder(&order, amended.quantity);
+        response.message = "Order amended in place";
+    } else {
+        auto [bid, ask] = book.bestBidOffer();
+        if (!amended.isMarketable(bid, ask)) {
+            // Loses time priority; unlinked and re-linked under one book lock
+            book.requeueOrder(&order, amended.price, amended.quantity);
+            response.message = "Order re-queued";
+        } else {
+            // Crosses at the new price: match as an aggressor, rest the remainder
+            book.removeOrder(&order);
+            order.price = amended.price;
+            order.quantity = amended.quantity;
+            matchAgainstBook(order, response.trades);
+            if (order.isFilled()) {
+                response.result = OrderResult::COMPLETELY_FILLED;
+                response.message = "Amended order completely filled";
+                logOrderEvent(order, "FILLED");
+                unlinkOwner(order);
+            } else {
+                book.addOrder(&order);
+                response.message = "Amended order re-queued after partial fill";
+                logOrderEvent(order, "RESTED");
+            }
+        }
+    }
+    response.filledQuantity = order.filledQty;
+    publishBookChanges(order.symbol);
+    if (!response.trades.empty()) runTriggers(order.symbol, response.trades);
+    return response;
+}
+
+std::vector<std::string> MatchingEngine::massCancel(const MassCancelRequest& request) {
+    std::vector<std::string> canceled;
+    std::vector<std::string> symbols;   // books to publish, each once
+    std::unique_lock lk(ordersMu_);
+    auto owner = ownerOrders_.find(request.owner);
+    if (owner == ownerOrders_.end()) return canceled;
+    
+    // unlinkOwner drops the list entry with its last order, so only the links are used from here
+    for (Order* order = owner->second.head; order;) {
+        Order* next = order->ownerNext;
+        if ((request.symbol.empty() || order->symbol == request.symbol) &&
+            (request.allSides || order->side == request.side)) {
+            // Linked orders rest on their book or wait in its trigger book
+            bool resting = getOrCreateBook(order->symbol).removeOrder(order);
+            if (!resting) triggers_[order->symbol].remove(order);
+            unlinkOwner(*order);
+            persist_.logCancelCommand(++commandSeq_, order->orderId);
+            logOrderEvent(*order, "CANCELED");
+            canceled.push_back(order->orderId);
+            if (resting && std::find(symbols.begin(), symbols.end(), order->symbol) == symbols.end()) {
+                symbols.push_back(order->symbol);
+            }
+        }
+        order = next;
+    }
+    
+    // One L3 batch, one delta and one snapshot per book for the whole operation
+    for (const auto& symbol : symbols) publishBookChanges(symbol);
+    return canceled;
+}
+
+void MatchingEngine::linkOwner(Order& order) {
+    if (order.owner.empty()) return;
+    OwnerOrders& list = ownerOrders_[order.owner];
+    order.ownerPrev = list.tail;
+    order.ownerNext = nullptr;
+    if (list.tail) list.tail->ownerNext = &order;
+    else list.head = &order;
+    list.tail = &order;
+}
+
+void MatchingEngine::unlinkOwner(Order& order) {
+    if (order.owner.empty()) return;
+    auto it = ownerOrders_.find(order.owner);
+    if (it == ownerOrders_.end()) return;
+    OwnerOrders& list = it->second;
+    if (order.ownerPrev) order.ownerPrev->ownerNext = order.ownerNext;
+    else list.head = order.ownerNext;
+    if (order.ownerNext) order.ownerNext->ownerPrev = order.ownerPrev;
+    else list.tail = order.ownerPrev;
+    order.ownerPrev = order.ownerNext = nullptr;
+    if (!list.head) ownerOrders_.erase(it);
+}
+
 void MatchingEngine::matchAgainstBook(Order& taker, std::vector<TradeReport>& trades) {
     OrderBook& book = getOrCreateBook(taker.symbol);
-    auto bookLock = book.acquireLock();
-    
-    if (taker.side == Side::BUY) {
-        auto& asks = book.getAsks();
-        for (auto it = asks.begin(); it != asks.end() && taker.remaining() > 0;) {
-            double level = it->first;
-            
-            // Price validation for limit orders
-            if (taker.type == OrderType::LIMIT && level > taker.price) break;
-            
-            auto& orderQueue = it->second;
-            for (auto orderIt = orderQueue.begin(); orderIt != orderQueue.end() && taker.remaining() > 0;) {
-                Order* maker = *orderIt;
-                double tradeQty = std::min(maker->remaining(), taker.remaining());
-                double tradePrice = maker->price; // Price-time priority: maker's price
-                
-                // Calculate fees
-                auto feeResult = fees_.computeFees(tradePrice, tradeQty, true);
-                
-                // Create trade report
-                TradeReport trade(
-                    taker.symbol, generateTradeId(), tradePrice, tradeQty,
-                    feeResult.makerFee, feeResult.takerFee, "BUY",
-                    maker->orderId, taker.orderId, Order::now()
-                );
+    size_t firstFill = trades.size();
+    {
+        auto bookLock = book.acquireLock();
+        
+        if (taker.side == Side::BUY) {
+            auto& asks = book.getAsks();
+            for (auto it = asks.begin(); it != asks.end() && taker.remaining() > 0;) {
+                double level = it->first;
                 
-                // Execute trade
-                maker->filledQty += tradeQty;
-                taker.filledQty += tradeQty;
-                trades.push_back(trade);
+                // Price validation for limit orders
+                if (taker.type == OrderType::LIMIT && level > taker.price) break;
                 
-                // Publish trade
-                tradeFeed_.publish(trade);
+                auto& priceLevel = it->second;
+                auto& orderQueue = priceLevel.orders;
+                for (auto orderIt = orderQueue.begin(); orderIt != orderQueue.end() && taker.remaining() > 0;) {
+                    Order* maker = *orderIt;
+                    double tradeQty = std::min(maker->displayed(), taker.remaining());
+                    double tradePrice = maker->price; // Price-time priority: maker's price
+                    
+                    // Calculate fees
+                    auto feeResult = fees_.computeFees(tradePrice, tradeQty, true);
+                    
+                    // Create trade report
+                    TradeReport trade(
+                        taker.symbol, generateTradeId(), tradePrice, tradeQty,
+                        feeResult.makerFee, feeResult.takerFee, "BUY",
+                        maker->orderId, taker.orderId, Order::now()
+                    );
+                    
+                    // Execute trade
+                    maker->filledQty += tradeQty;
+                    if (maker->isIceberg()) maker->visibleQty -= tradeQty;
+                    taker.filledQty += tradeQty;
+                    priceLevel.totalQty -= tradeQty;
+                    book.recordExecution(*maker, tradeQty, trade.tradeId);
+                    trades.push_back(trade);
+                    
+                    // Publish trade
+                    tradeFeed_.publish(trade);
+                    logTrade(trade);
+                    
+                    // Log fills
+                    logOrderEvent(*maker, maker->isFilled() ? "FILLED" : "PARTIAL_FILL");
+                    logOrderEvent(taker, taker.isFilled() ? "FILLED" : "PARTIAL_FILL");
+                    
+                    // Remove filled orders
+                    if (maker->isFilled()) {
+                        unlinkOwner(*maker);
+                        orderIt = book.eraseFilled(priceLevel, orderIt);
+                    } else if (maker->displayed() <= 0.0) {
+                        orderIt = book.replenish(priceLevel, orderIt);
+                    } else {
+                        ++orderIt;
+                    }
+                }
                 
-                // Log fills
-                logOrderEvent(*maker, maker->isFilled() ? "FILLED" : "PARTIAL_FILL");
-                logOrderEvent(taker, taker.isFilled() ? "FILLED" : "PARTIAL_FILL");
+                book.markLevelChanged(Side::SELL, level);
                 
-                // Remove filled orders
-                if (maker->isFilled()) {
-                    orderIt = orderQueue.erase(orderIt);
+                // Remove empty price levels
+                if (orderQueue.empty()) {
+                    it = asks.erase(it);
                 } else {
-                    ++orderIt;
+                    ++it;
                 }
             }
-            
-            // Remove empty price levels
-            if (orderQueue.empty()) {
-                it = asks.erase(it);
-            } else {
-                ++it;
-            }
-        }
-    } else { // SELL
-        auto& bids = book.getBids();
-        for (auto it = bids.begin(); it != bids.end() && taker.remaining() > 0;) {
-            double level = it->first;
-            
-            // Price validation for limit orders
-            if (taker.type == OrderType::LIMIT && level < taker.price) break;
-            
-            auto& orderQueue = it->second;
-            for (auto orderIt = orderQueue.begin(); orderIt != orderQueue.end() && taker.remaining() > 0;) {
-                Order* maker = *orderIt;
-                double tradeQty = std::min(maker->remaining(), taker.remaining());
-                double tradePrice = maker->price; // Price-time priority: maker's price
-                
-                // Calculate fees
-                auto feeResult = fees_.computeFees(tradePrice, tradeQty, true);
-                
-                // Create trade report
-                TradeReport trade(
-                    taker.symbol, generateTradeId(), tradePrice, tradeQty,
-                    feeResult.makerFee, feeResult.takerFee, "SELL",
-                    maker->orderId, taker.orderId, Order::now()
-                );
+        } else { // SELL
+            auto& bids = book.getBids();
+            for (auto it = bids.begin(); it != bids.end() && taker.remaining() > 0;) {
+                double level = it->first;
                 
-                // Execute trade
-                maker->filledQty += tradeQty;
-                taker.filledQty += tradeQty;
-                trades.push_back(trade);
+                // Price validation for limit orders
+                if (taker.type == OrderType::LIMIT && level < taker.price) break;
                 
-                // Publish trade
-                tradeFeed_.publish(trade);
+                auto& priceLevel = it->second;
+                auto& orderQueue = priceLevel.orders;
+                for (auto orderIt = orderQueue.begin(); orderIt != orderQueue.end() && taker.remaining() > 0;) {
+                    Order* maker = *orderIt;
+                    double tradeQty = std::min(maker->displayed(), taker.remaining());
+                    double tradePrice = maker->price; // Price-time priority: maker's price
+                    
+                    // Calculate fees
+                    auto feeResult = fees_.computeFees(tradePrice, tradeQty, true);
+                    
+                    // Create trade report
+                    TradeReport trade(
+                        taker.symbol, generateTradeId(), tradePrice, tradeQty,
+                        feeResult.makerFee, feeResult.takerFee, "SELL",
+                        maker->orderId, taker.orderId, Order::now()
+                    );
+                    
+                    // Execute trade
+                    maker->filledQty += tradeQty;
+                    if (maker->isIceberg()) maker->visibleQty -= tradeQty;
+                    taker.filledQty += tradeQty;
+                    priceLevel.totalQty -= tradeQty;
+                    book.recordExecution(*maker, tradeQty, trade.tradeId);
+                    trades.push_back(trade);
+                    
+                    // Publish trade
+                    tradeFeed_.publish(trade);
+                    logTrade(trade);
+                    
+                    // Log fills
+                    logOrderEvent(*maker, maker->isFilled() ? "FILLED" : "PARTIAL_FILL");
+                    logOrderEvent(taker, taker.isFilled() ? "FILLED" : "PARTIAL_FILL");
+                    
+                    // Remove filled orders
+                    if (maker->isFilled()) {
+                        unlinkOwner(*maker);
+                        orderIt = book.eraseFilled(priceLevel, orderIt);
+                    } else if (maker->displayed() <= 0.0) {
+                        orderIt = book.replenish(priceLevel, orderIt);
+                    } else {
+                        ++orderIt;
+                    }
+                }
                 
-                // Log fills
-                logOrderEvent(*maker, maker->isFilled() ? "FILLED" : "PARTIAL_FILL");
-                logOrderEvent(taker, taker.isFilled() ? "FILLED" : "PARTIAL_FILL");
+                book.markLevelChanged(Side::BUY, level);
                 
-                // Remove filled orders
-                if (maker->isFilled()) {
-                    orderIt = orderQueue.erase(orderIt);
+                // Remove empty price levels
+                if (orderQueue.empty()) {
+                    it = bids.erase(it);
                 } else {
-                    ++orderIt;
+                    ++it;
                 }
             }
-            
-            // Remove empty price levels
-            if (orderQueue.empty()) {
-                it = bids.erase(it);
-            } else {
-                ++it;
-            }
         }
-    }
+    } // release the book lock before publishing (L2 snapshot re-locks the book)
     
-    // Publish L2 update after matching
-    if (!trades.empty()) {
-        publishL2Update(taker.symbol);
+    // Publish market data after matching: every fill of this taker as one batch
+    if (trades.size() > firstFill) {
+        if (executionFeed_.subscriberCount() > 0) {
+            batchScratch_.symbol = taker.symbol;
+            batchScratch_.takerOrderId = taker.orderId;
+            batchScratch_.aggressor = taker.side == Side::BUY ? "BUY" : "SELL";
+            batchScratch_.timestamp = Order::now();
+            batchScratch_.fills.assign(trades.begin() + firstFill, trades.end());
+            executionFeed_.publish(batchScratch_);
+        }
+        publishBookChanges(taker.symbol);
     }
 }
 
@@ -272,10 +494,10 @@ bool MatchingEngine::canFillCompletely(const Order& order, double& avgPrice) {
     
     if (order.side == Side::BUY) {
         const auto& asks = book.getAsks();
-        for (const auto& [price, orderQueue] : asks) {
+        for (const auto& [price, level] : asks) {
             if (order.type == OrderType::LIMIT && price > order.price) break;
             
-            for (Order* maker : orderQueue) {
+            for (Order* maker : level.orders) {
                 double availableQty = maker->remaining();
                 double tradeQty = std::min(availableQty, remainingQty);
                 totalCost += tradeQty * price;
@@ -289,10 +511,10 @@ bool MatchingEngine::canFillCompletely(const Order& order, double& avgPrice) {
         }
     } else {
         const auto& bids = book.getBids();
-        for (const auto& [price, orderQueue] : bids) {
+        for (const auto& [price, level] : bids) {
             if (order.type == OrderType::LIMIT && price < order.price) break;
             
-            for (Order* maker : orderQueue) {
+            for (Order* maker : level.orders) {
                 double availableQty = maker->remaining();
                 double tradeQty = std::min(availableQty, remainingQty);
                 totalCost += tradeQty * price;
@@ -331,6 +553,22 @@ bool MatchingEngine::validateOrder(const Order& order, std::string& errorMsg) {
         return false;
     }
     
+    if (order.displayQty < 0 || (order.isIceberg() && order.type != OrderType::LIMIT)) {
+        errorMsg = "Display quantity applies to limit orders only";
+        return false;
+    }
+    
+    if (order.isConditional()) {
+        if (order.stopPrice <= 0) {
+            errorMsg = "Stop price must be positive for conditional orders";
+            return false;
+        }
+        if (order.type == OrderType::STOP_LIMIT && order.price <= 0) {
+            errorMsg = "Price must be positive for stop-limit orders";
+            return false;
+        }
+    }
+    
     // Check for duplicate order ID
     {
         std::shared_lock lk(ordersMu_);
@@ -344,8 +582,7 @@ bool MatchingEngine::validateOrder(const Order& order, std::string& errorMsg) {
 }
 
 std::string MatchingEngine::generateTradeId() {
-    static std::atomic<uint64_t> counter{0};
-    return "T" + std::to_string(++counter);
+    return "T" + std::to_string(++tradeCounter_);
 }
 
 OrderBook& MatchingEngine::getOrCreateBook(const std::string& symbol) {
@@ -353,16 +590,36 @@ OrderBook& MatchingEngine::getOrCreateBook(const std::string& symbol) {
     return books_[symbol]; // Creates if doesn't exist
 }
 
-void MatchingEngine::publishL2Update(const std::string& symbol) {
+void MatchingEngine::publishBookChanges(const std::string& symbol) {
     OrderBook& book = getOrCreateBook(symbol);
-    L2Update update = book.generateL2Update(symbol);
-    l2Feed_.publish(update);
+    
+    // Order-by-order feed: the events recorded as the book was mutated
+    if (book.collectL3(symbol, l3Scratch_)) {
+        for (const auto& event : l3Scratch_) l3Feed_.publish(event);
+    }
+    
+    // Incremental feed: only the levels this operation touched
+    L2Delta delta;
+    if (book.collectDelta(symbol, delta)) {
+        l2DeltaFeed_.publish(delta);
+    }
+    
+    // Full top-of-book rebuild only when someone still consumes it
+    if (l2Feed_.subscriberCount() > 0) {
+        L2Update update = book.generateL2Update(symbol);
+        l2Feed_.publish(update);
+    }
 }
 
 void MatchingEngine::logOrderEvent(const Order& order, const std::string& event) {
+    if (!persist_.journalsEvents()) return;
     persist_.logOrderEvent(order, event);
 }
 
+void MatchingEngine::logTrade(const TradeReport& trade) {
+    persist_.logTrade(trade);
+}
+
 std::pair<double, double> MatchingEngine::getBBO(const std::string& symbol) {
     std::shared_lock lk(booksMu_);
     auto it = books_.find(symbol);
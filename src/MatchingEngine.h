@@ -1,22 +1,33 @@
 #pragma once
 #include "Order.h"
 #include "OrderBook.h"
+#include "TriggerBook.h"
 #include "TradeExecutionFeed.h"
 #include "EventFeed.h"
 #include "FeeCalculator.h"  
 #include "PersistenceManager.h"
 #include <unordered_map>
 #include <shared_mutex>
+#include <atomic>
 
 enum class OrderResult {
     ACCEPTED,
     REJECTED_INVALID_PARAMS,
     REJECTED_TRADE_THROUGH,
     REJECTED_FOK_UNFILLABLE,
+    REJECTED_UNKNOWN_ORDER,     // cancel/amend of an order that is not resting
     PARTIALLY_FILLED,
     COMPLETELY_FILLED
 };
 
+// A REJECTED_* result: the request changed nothing
+inline bool isRejection(OrderResult result) {
+    return result == OrderResult::REJECTED_INVALID_PARAMS
+        || result == OrderResult::REJECTED_TRADE_THROUGH
+        || result == OrderResult::REJECTED_FOK_UNFILLABLE
+        || result == OrderResult::REJECTED_UNKNOWN_ORDER;
+}
+
 struct OrderResponse {
     OrderResult result;
     std::string message;
@@ -24,11 +35,51 @@ struct OrderResponse {
     std::vector<TradeReport> trades;
 };
 
+// Outcome of a conditional order fired by another command's trades, published
+// once it has matched. Its fills go out on the trade feed like any other; this
+// tells whoever entered it whether it now rests or is done, which a fired order
+// rejected for trading through, or a market remainder canceled, shows nowhere else.
+struct TriggeredOrder {
+    std::string symbol;
+    std::string orderId;
+    std::string owner;
+    OrderResult result;
+    std::string message;
+    double filledQuantity = 0.0;
+    bool resting = false;     // on the book now; its later fills are maker fills
+};
+
+// Orders to pull in one mass cancel: every resting order of owner, narrowed to
+// one symbol and/or one side when set
+struct MassCancelRequest {
+    std::string owner;
+    std::string symbol;       // empty = every symbol
+    bool allSides = true;
+    Side side = Side::BUY;    // when !allSides
+};
+
+// Runtime configuration; defaults match the production server
+struct EngineConfig {
+    std::string journalFile = "journal.log";   // empty disables journaling
+    std::string snapshotFile = "snapshot.json";
+    JournalMode journalMode = JournalMode::EVENTS;
+    std::string fillLogFile;                   // COMMANDS mode only; empty = no fill log
+    size_t journalSegmentBytes = 0;            // seal journal segments at this size; 0 = never
+    bool consoleLogging = true;                // per-order stdout tracing
+};
+
 class MatchingEngine {
 public:
     MatchingEngine();
+    explicit MatchingEngine(const EngineConfig& config);
     
-    // Core order submission API
+    // Core order submission API. Conditional orders (STOP_LOSS, STOP_LIMIT,
+    // TAKE_PROFIT) are ACCEPTED into the symbol's trigger book unless the last
+    // trade already reached stopPrice; once fired they match as MARKET (LIMIT for
+    // STOP_LIMIT) after the command that fired them, cascading in firing order.
+    // A LIMIT order with displayQty is an iceberg: it takes liquidity with its
+    // full size but rests showing one displayQty slice at a time, the next slice
+    // re-queued at the back of the level each time one trades away.
     OrderResponse submitOrder(const Order& order);
     
     // Market data access
@@ -37,10 +88,25 @@ public:
     
     // Event feeds for market data dissemination
     EventFeed<TradeReport>& tradeFeed() { return tradeFeed_; }
+    EventFeed<ExecutionBatch>& executionFeed() { return executionFeed_; }
     EventFeed<L2Update>& l2Feed() { return l2Feed_; }
+    EventFeed<L2Delta>& l2DeltaFeed() { return l2DeltaFeed_; }
+    EventFeed<L3Event>& l3Feed() { return l3Feed_; }
+    EventFeed<TriggeredOrder>& triggerFeed() { return triggerFeed_; }
     
-    // Order management
+    // Order management. Both act on resting orders only and bypass submitOrder:
+    // the order is found by id and unlinked from its level in O(1). Cancel also
+    // takes a conditional order out of its trigger book; amend does not apply to one.
     bool cancelOrder(const std::string& orderId);
+    // newPrice / newQuantity of 0 keep the current value; newQuantity is the new
+    // total size. Same price and smaller size amends in place (time priority kept);
+    // anything else re-queues at the back of the new level, matching first if the
+    // new price crosses.
+    OrderResponse amendOrder(const std::string& orderId, double newPrice, double newQuantity);
+    // Cancel the owner's resting and pending conditional orders that match the request; returns their ids.
+    // Walks the owner's own order list (cost proportional to its resting orders),
+    // journals one CANCEL per order and publishes each affected book once.
+    std::vector<std::string> massCancel(const MassCancelRequest& request);
     Order* getOrder(const std::string& orderId);
     
     // Statistics
@@ -53,6 +119,12 @@ private:
     OrderResponse processLimitOrder(Order& order);
     OrderResponse processIOCOrder(Order& order);
     OrderResponse processFOKOrder(Order& order);
+    OrderResponse processConditionalOrder(Order& order);
+    
+    // Conditional orders: convert a fired order and match it, then let the
+    // trades of a command fire pending orders, including those their own trades fire
+    OrderResponse triggerOrder(Order& order);
+    void runTriggers(const std::string& symbol, const std::vector<TradeReport>& trades);
     
     // Matching engine core
     void matchAgainstBook(Order& taker, std::vector<TradeReport>& trades);
@@ -64,24 +136,48 @@ private:
     // Thread-safe order storage
     mutable std::shared_mutex ordersMu_;
     std::unordered_map<std::string, Order> allOrders_;
+    uint64_t commandSeq_ = 0;   // sequence of accepted input commands (guarded by ordersMu_)
+    
+    // Resting orders per owner, oldest first, threaded through Order::ownerPrev/ownerNext.
+    // An order is linked exactly while it rests on a book or waits in a trigger
+    // book (guarded by ordersMu_).
+    struct OwnerOrders {
+        Order* head = nullptr;
+        Order* tail = nullptr;
+    };
+    std::unordered_map<std::string, OwnerOrders> ownerOrders_;
+    void linkOwner(Order& order);
+    void unlinkOwner(Order& order);
     
     // Per-symbol order books
     mutable std::shared_mutex booksMu_;
     std::unordered_map<std::string, OrderBook> books_;
     
+    // Per-symbol pending conditional orders (guarded by ordersMu_)
+    std::unordered_map<std::string, TriggerBook> triggers_;
+    
     // Event feeds
     EventFeed<TradeReport> tradeFeed_;
+    EventFeed<ExecutionBatch> executionFeed_;
+    ExecutionBatch batchScratch_;      // reused per match (guarded by ordersMu_)
     EventFeed<L2Update> l2Feed_;
+    EventFeed<L2Delta> l2DeltaFeed_;
+    EventFeed<L3Event> l3Feed_;
+    EventFeed<TriggeredOrder> triggerFeed_;
+    std::vector<L3Event> l3Scratch_;   // reused per publish (guarded by ordersMu_)
     
     // Supporting components
+    EngineConfig config_;
     FeeModel fees_;
     Persistence persist_;
     
-    // Trade ID generation
-    static std::string generateTradeId();
+    // Trade ID generation (per engine, so a replay reproduces the same IDs)
+    std::atomic<uint64_t> tradeCounter_{0};
+    std::string generateTradeId();
     
     // Helper methods
     OrderBook& getOrCreateBook(const std::string& symbol);
-    void publishL2Update(const std::string& symbol);
+    void publishBookChanges(const std::string& symbol);
     void logOrderEvent(const Order& order, const std::string& event);
+    void logTrade(const TradeReport& trade);
 };
\ No newline at end of file
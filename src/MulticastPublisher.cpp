@@ -0,0 +1,167 @@
+#include "MulticastPublisher.h"
+#include "BinaryCodec.h"
+#include "Logger.h"
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+void putU16(std::string& out, uint16_t v) {
+    char b[2] = {static_cast<char>(v), static_cast<char>(v >> 8)};
+    out.append(b, 2);
+}
+
+void putU32(std::string& out, uint32_t v) {
+    char b[4];
+    for (int i = 0; i < 4; ++i) b[i] = static_cast<char>(v >> (8 * i));
+    out.append(b, 4);
+}
+
+void putU64(std::string& out, uint64_t v) {
+    char b[8];
+    for (int i = 0; i < 8; ++i) b[i] = static_cast<char>(v >> (8 * i));
+    out.append(b, 8);
+}
+
+uint64_t readU64(const char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    return v;
+}
+
+uint32_t readU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    return v;
+}
+
+asio::ip::udp::socket openChannel(asio::io_context& io, const std::string& interfaceAddress, int ttl) {
+    asio::ip::udp::socket socket(io, asio::ip::udp::v4());
+    socket.set_option(asio::ip::multicast::outbound_interface(
+        asio::ip::make_address_v4(interfaceAddress)));
+    socket.set_option(asio::ip::multicast::hops(ttl));
+    socket.set_option(asio::ip::multicast::enable_loopback(true));
+    return socket;
+}
+
+// One retransmission client: request -> reply, until the client hangs up
+class RetransmitSession : public std::enable_shared_from_this<RetransmitSession> {
+public:
+    RetransmitSession(asio::ip::tcp::socket socket, const MulticastPublisher& publisher)
+        : socket_(std::move(socket)), publisher_(publisher) {}
+
+    void start() { readRequest(); }
+
+private:
+    void readRequest() {
+        auto self = shared_from_this();
+        asio::async_read(socket_, asio::buffer(request_),
+            [this, self](const asio::error_code& ec, size_t) {
+                if (ec) return;
+                uint64_t fromSeq = readU64(request_);
+                uint32_t count = std::min(readU32(request_ + 8), MulticastPublisher::kMaxRetransmit);
+                reply_.clear();
+                publisher_.retransmit(fromSeq, count, reply_);
+                asio::async_write(socket_, asio::buffer(reply_),
+                    [this, self](const asio::error_code& ec, size_t) {
+                        if (!ec) readRequest();
+                    });
+            });
+    }
+
+    asio::ip::tcp::socket socket_;
+    const MulticastPublisher& publisher_;
+    char request_[12];
+    std::string reply_;
+};
+
+} // namespace
+
+MulticastPublisher::MulticastPublisher(MatchingEngine& engine, const MulticastConfig& config)
+    : engine_(engine),
+      config_(config),
+      socketA_(openChannel(io_, config.interfaceA, config.ttl)),
+      socketB_(openChannel(io_, config.interfaceB, config.ttl)),
+      groupA_(asio::ip::make_address(config.groupA), config.portA),
+      groupB_(asio::ip::make_address(config.groupB), config.portB),
+      acceptor_(io_, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), config.retransmitPort)),
+      ring_(std::max<size_t>(config.ringPackets, 1)) {
+    tradeSub_ = engine_.tradeFeed().subscribe([this](const TradeReport& trade) {
+        std::lock_guard<std::mutex> lock(mu_);
+        message_.clear();
+        BinaryCodec::encodeTrade(message_, trade);
+        publish(message_);
+    });
+    deltaSub_ = engine_.l2DeltaFeed().subscribe([this](const L2Delta& delta) {
+        std::lock_guard<std::mutex> lock(mu_);
+        message_.clear();
+        BinaryCodec::encodeL2Delta(message_, delta.symbol, delta.seq, delta.seq,
+                                   delta.timestamp, delta.changes);
+        publish(message_);
+    });
+
+    startAccept();
+    ioThread_ = std::thread([this]() { io_.run(); });
+}
+
+MulticastPublisher::~MulticastPublisher() {
+    engine_.tradeFeed().unsubscribe(tradeSub_);
+    engine_.l2DeltaFeed().unsubscribe(deltaSub_);
+    io_.stop();
+    if (ioThread_.joinable()) ioThread_.join();
+}
+
+uint64_t MulticastPublisher::lastSeq() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return seq_;
+}
+
+uint64_t MulticastPublisher::sendErrors() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return sendErrors_;
+}
+
+// Caller holds mu_
+void MulticastPublisher::publish(const std::string& message) {
+    uint64_t seq = ++seq_;
+    std::string& packet = ring_[seq % ring_.size()];   // the slot's old packet falls out of the ring
+    packet.clear();
+    putU64(packet, seq);
+    putU16(packet, 1);
+    putU16(packet, static_cast<uint16_t>(message.size()));
+    packet.append(message);
+
+    // A and B carry identical packets; a failure on one channel doesn't stop the other
+    asio::error_code ec;
+    socketA_.send_to(asio::buffer(packet), groupA_, 0, ec);
+    if (ec) ++sendErrors_;
+    socketB_.send_to(asio::buffer(packet), groupB_, 0, ec);
+    if (ec) ++sendErrors_;
+}
+
+void MulticastPublisher::retransmit(uint64_t fromSeq, uint32_t count, std::string& out) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint64_t oldest = seq_ >= ring_.size() ? seq_ - ring_.size() + 1 : 1;
+    uint64_t first = std::max<uint64_t>(std::max<uint64_t>(fromSeq, oldest), 1);
+    uint64_t last = std::min<uint64_t>(seq_, fromSeq + count - 1);   // count >= 1 checked below
+    uint32_t packets = (count == 0 || first > last) ? 0 : static_cast<uint32_t>(last - first + 1);
+
+    putU32(out, packets);
+    for (uint32_t i = 0; i < packets; ++i) {
+        const std::string& packet = ring_[(first + i) % ring_.size()];
+        putU16(out, static_cast<uint16_t>(packet.size()));
+        out.append(packet);
+    }
+}
+
+void MulticastPublisher::startAccept() {
+    acceptor_.async_accept([this](const asio::error_code& ec, asio::ip::tcp::socket socket) {
+        if (ec == asio::error::operation_aborted) return;
+        if (!ec) {
+            std::make_shared<RetransmitSession>(std::move(socket), *this)->start();
+        } else {
+            LOG_ERROR("[MCAST] Retransmit accept failed: {}", ec.message());
+        }
+        startAccept();
+    });
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "MatchingEngine.h"
+#include <asio.hpp>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sequenced binary market data over UDP multicast.
+//
+// Every trade and L2 delta becomes one packet carrying BinaryCodec messages.
+// Each packet is sent on two redundant channels (A and B) with the same
+// sequence number, so a listener keeps whichever copy arrives first. A TCP
+// retransmission service replays missed sequence ranges from an in-memory ring.
+//
+//   packet               u64 seq | u16 messageCount | per message: u16 length + message
+//   retransmit request   u64 fromSeq | u32 count                        (TCP, little-endian)
+//   retransmit reply     u32 packetCount | per packet: u16 length + packet
+//
+// Packets that have left the ring cannot be replayed; the reply then starts
+// at the oldest packet still kept (check its seq) and the listener resyncs
+// from a /ws/orderbook snapshot.
+struct MulticastConfig {
+    std::string groupA = "239.255.0.1";
+    uint16_t portA = 30001;
+    std::string groupB = "239.255.0.2";
+    uint16_t portB = 30002;
+    std::string interfaceA = "127.0.0.1";   // outbound interface per channel
+    std::string interfaceB = "127.0.0.1";
+    int ttl = 1;
+    uint16_t retransmitPort = 30010;        // 0 = any free port
+    size_t ringPackets = 65536;
+};
+
+class MulticastPublisher {
+public:
+    explicit MulticastPublisher(MatchingEngine& engine, const MulticastConfig& config = MulticastConfig{});
+    ~MulticastPublisher();
+
+    MulticastPublisher(const MulticastPublisher&) = delete;
+    MulticastPublisher& operator=(const MulticastPublisher&) = delete;
+
+    uint64_t lastSeq() const;
+    uint64_t sendErrors() const;
+    uint16_t retransmitPort() const { return acceptor_.local_endpoint().port(); }
+
+    // Append the retransmit reply for [fromSeq, fromSeq + count) to out
+    void retransmit(uint64_t fromSeq, uint32_t count, std::string& out) const;
+
+    static constexpr size_t kPacketHeaderSize = 10;
+    static constexpr uint32_t kMaxRetransmit = 10000;   // packets per request
+
+private:
+    void publish(const std::string& message);
+    void startAccept();
+
+    MatchingEngine& engine_;
+    EventFeed<TradeReport>::Token tradeSub_;
+    EventFeed<L2Delta>::Token deltaSub_;
+    MulticastConfig config_;
+
+    asio::io_context io_;
+    asio::ip::udp::socket socketA_;
+    asio::ip::udp::socket socketB_;
+    asio::ip::udp::endpoint groupA_;
+    asio::ip::udp::endpoint groupB_;
+    asio::ip::tcp::acceptor acceptor_;
+    std::thread ioThread_;
+
+    // Guarded by mu_: sequence, ring of sent packets (slot = seq % size), scratch buffers
+    mutable std::mutex mu_;
+    uint64_t seq_ = 0;
+    std::vector<std::string> ring_;
+    std::string message_;
+    uint64_t sendErrors_ = 0;
+};
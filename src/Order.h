@@ -30,7 +30,11 @@ enum class OrderType {
     MARKET = 0, 
     LIMIT = 1, 
     IOC = 2,    // Immediate-Or-Cancel
-    FOK = 3     // Fill-Or-Kill
+    FOK = 3,    // Fill-Or-Kill
+    // Conditional: wait in the symbol's trigger book until a trade reaches stopPrice
+    STOP_LOSS = 4,     // buy at or above / sell at or below stopPrice, then market
+    STOP_LIMIT = 5,    // as STOP_LOSS, then a limit order at price
+    TAKE_PROFIT = 6    // buy at or below / sell at or above stopPrice, then market
 };
 
 struct Order {
@@ -39,10 +43,17 @@ struct Order {
     Side side;
     OrderType type;
     double price;        // Required for LIMIT orders
-    double stopPrice;    // For stop orders (bonus feature)
+    double stopPrice;    // Trigger price of conditional orders
     double quantity;     // Original quantity
     double filledQty = 0.0;  // Quantity filled so far
     long long timestamp;
+    std::string owner;   // session or account that entered it; empty = none (see MatchingEngine::massCancel)
+    double displayQty = 0.0;   // iceberg: size shown at a time; 0 = show all of it
+    double visibleQty = 0.0;   // iceberg: what is left of the shown slice (kept by OrderBook)
+    
+    // The engine's per-owner list of resting orders, linked through the orders themselves
+    Order* ownerPrev = nullptr;
+    Order* ownerNext = nullptr;
     
     // Calculate remaining quantity
     double remaining() const { 
@@ -54,6 +65,22 @@ struct Order {
         return remaining() <= 0.0; 
     }
     
+    // Iceberg limit orders rest with only a displayQty slice visible; the book
+    // refills the slice from the hidden rest each time it trades away
+    bool isIceberg() const { return displayQty > 0.0; }
+    // Size the book shows (and makers trade) right now
+    double displayed() const { return isIceberg() ? visibleQty : remaining(); }
+    
+    bool isConditional() const {
+        return type == OrderType::STOP_LOSS || type == OrderType::STOP_LIMIT || type == OrderType::TAKE_PROFIT;
+    }
+    
+    // Conditional orders: true when a rising last price fires it (buy stop, sell
+    // take-profit), false when a falling one does (sell stop, buy take-profit)
+    bool triggersOnRise() const {
+        return (type == OrderType::TAKE_PROFIT) == (side == Side::SELL);
+    }
+    
     // Check if order is marketable (can execute immediately)
     bool isMarketable(double bestBid, double bestAsk) const {
         if (type == OrderType::MARKET) return true;
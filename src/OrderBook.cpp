@@ -1,33 +1,87 @@
 #include "OrderBook.h"
 #include <algorithm>
 #include <chrono>
+#include <iterator>
 
 void OrderBook::addOrder(Order* o) {
     std::unique_lock lock(mu_);
-    if (o->side == Side::BUY) {
-        bids_[o->price].push_back(o);
-    } else {
-        asks_[o->price].push_back(o);
-    }
+    PriceLevel& level = (o->side == Side::BUY) ? bids_[o->price] : asks_[o->price];
+    showSlice(o);
+    level.orders.push_back(o);
+    level.totalQty += o->displayed();
+    locators_[o] = {&level, std::prev(level.orders.end())};
+    changed_.push_back({o->side, o->price});
+    recordL3(L3Event::Type::ADD, *o, o->displayed());
 }
 
-void OrderBook::removeOrder(Order* o) {
+bool OrderBook::removeOrder(Order* o) {
     std::unique_lock lock(mu_);
-    if (o->side == Side::BUY) {
-        auto it = bids_.find(o->price);
-        if (it != bids_.end()) {
-            auto& dq = it->second;
-            dq.erase(std::remove(dq.begin(), dq.end(), o), dq.end());
-            if (dq.empty()) bids_.erase(it);
-        }
-    } else {
-        auto it = asks_.find(o->price);
-        if (it != asks_.end()) {
-            auto& dq = it->second;
-            dq.erase(std::remove(dq.begin(), dq.end(), o), dq.end());
-            if (dq.empty()) asks_.erase(it);
-        }
+    auto it = locators_.find(o);
+    if (it == locators_.end()) return false;
+    unlink(o, it->second);
+    locators_.erase(it);
+    recordL3(L3Event::Type::DELETE, *o, 0.0);
+    return true;
+}
+
+bool OrderBook::isResting(const Order* o) const {
+    std::shared_lock lock(mu_);
+    return locators_.count(o) > 0;
+}
+
+bool OrderBook::reduceOrder(Order* o, double newQuantity) {
+    std::unique_lock lock(mu_);
+    auto it = locators_.find(o);
+    if (it == locators_.end() || newQuantity <= o->filledQty || newQuantity > o->quantity) return false;
+    double shown = o->displayed();
+    o->quantity = newQuantity;
+    if (o->isIceberg()) o->visibleQty = std::min(o->visibleQty, o->remaining());
+    it->second.level->totalQty -= shown - o->displayed();
+    changed_.push_back({o->side, o->price});
+    recordL3(L3Event::Type::REDUCE, *o, o->displayed());
+    return true;
+}
+
+bool OrderBook::requeueOrder(Order* o, double newPrice, double newQuantity) {
+    std::unique_lock lock(mu_);
+    auto it = locators_.find(o);
+    if (it == locators_.end() || newQuantity <= o->filledQty) return false;
+    unlink(o, it->second);
+    recordL3(L3Event::Type::DELETE, *o, 0.0);
+    
+    o->price = newPrice;
+    o->quantity = newQuantity;
+    PriceLevel& level = (o->side == Side::BUY) ? bids_[o->price] : asks_[o->price];
+    showSlice(o);
+    level.orders.push_back(o);
+    level.totalQty += o->displayed();
+    it->second = {&level, std::prev(level.orders.end())};
+    changed_.push_back({o->side, o->price});
+    recordL3(L3Event::Type::ADD, *o, o->displayed());
+    return true;
+}
+
+void OrderBook::unlink(Order* o, const Locator& locator) {
+    PriceLevel& level = *locator.level;
+    level.orders.erase(locator.pos);
+    level.totalQty -= o->displayed();
+    if (level.orders.empty()) {
+        if (o->side == Side::BUY) bids_.erase(o->price);
+        else asks_.erase(o->price);
     }
+    changed_.push_back({o->side, o->price});
+}
+
+std::list<Order*>::iterator OrderBook::replenish(PriceLevel& level, std::list<Order*>::iterator it) {
+    Order* o = *it;
+    auto next = std::next(it);
+    showSlice(o);
+    level.totalQty += o->visibleQty;
+    // Splicing moves the node, so the order's locator stays valid
+    level.orders.splice(level.orders.end(), level.orders, it);
+    recordL3(L3Event::Type::ADD, *o, o->visibleQty);
+    // Last in the level already: it is also the next to match
+    return next == level.orders.end() ? it : next;
 }
 
 std::pair<double,double> OrderBook::bestBidOffer() const {
@@ -41,12 +95,10 @@ std::vector<std::pair<double,double>> OrderBook::topBids(int N) const {
     std::shared_lock lock(mu_);
     std::vector<std::pair<double,double>> res;
     int count = 0;
-    for (auto& [p, dq] : bids_) {
+    for (auto& [p, level] : bids_) {
         if (count++ >= N) break;
-        double qty = 0;
-        for (auto* o : dq) qty += o->remaining();
-        if (qty > 0) {  // Only include levels with remaining quantity
-            res.emplace_back(p, qty);
+        if (level.totalQty > 0) {  // Only include levels with remaining quantity
+            res.emplace_back(p, level.totalQty);
         }
     }
     return res;
@@ -56,12 +108,10 @@ std::vector<std::pair<double,double>> OrderBook::topAsks(int N) const {
     std::shared_lock lock(mu_);
     std::vector<std::pair<double,double>> res;
     int count = 0;
-    for (auto& [p, dq] : asks_) {
+    for (auto& [p, level] : asks_) {
         if (count++ >= N) break;
-        double qty = 0;
-        for (auto* o : dq) qty += o->remaining();
-        if (qty > 0) {  // Only include levels with remaining quantity
-            res.emplace_back(p, qty);
+        if (level.totalQty > 0) {  // Only include levels with remaining quantity
+            res.emplace_back(p, level.totalQty);
         }
     }
     return res;
@@ -75,9 +125,70 @@ L2Update OrderBook::generateL2Update(const std::string& symbol, int depth) const
     ).count();
     update.bids = topBids(depth);
     update.asks = topAsks(depth);
+    {
+        std::shared_lock lock(mu_);
+        update.seq = seq_;
+    }
     return update;
 }
 
+bool OrderBook::collectDelta(const std::string& symbol, L2Delta& delta) {
+    std::unique_lock lock(mu_);
+    if (changed_.empty()) return false;
+    
+    delta.symbol = symbol;
+    delta.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now().time_since_epoch()
+    ).count();
+    delta.changes.clear();
+    
+    // A level can be touched several times per operation; report it once, in
+    // (side, price) order. Sorting keeps a wide sweep or mass cancel O(k log k).
+    std::sort(changed_.begin(), changed_.end());
+    changed_.erase(std::unique(changed_.begin(), changed_.end()), changed_.end());
+    
+    for (const auto& [side, price] : changed_) {
+        double qty = 0.0;
+        if (side == Side::BUY) {
+            auto it = bids_.find(price);
+            if (it != bids_.end()) qty = std::max(0.0, it->second.totalQty);
+        } else {
+            auto it = asks_.find(price);
+            if (it != asks_.end()) qty = std::max(0.0, it->second.totalQty);
+        }
+        delta.changes.push_back({side, price, qty});
+    }
+    changed_.clear();
+    delta.seq = ++seq_;
+    return true;
+}
+
+void OrderBook::recordL3(L3Event::Type type, const Order& order, double quantity) {
+    L3Event& e = l3Pending_.emplace_back();
+    e.type = type;
+    e.seq = ++l3Seq_;
+    e.timestamp = Order::now();
+    e.orderId = order.orderId;
+    e.side = order.side;
+    e.price = order.price;
+    e.quantity = quantity;
+}
+
+void OrderBook::recordExecution(const Order& maker, double execQty, const std::string& tradeId) {
+    recordL3(L3Event::Type::EXECUTE, maker, maker.displayed());
+    l3Pending_.back().execQty = execQty;
+    l3Pending_.back().tradeId = tradeId;
+}
+
+bool OrderBook::collectL3(const std::string& symbol, std::vector<L3Event>& events) {
+    events.clear();
+    std::unique_lock lock(mu_);
+    if (l3Pending_.empty()) return false;
+    events.swap(l3Pending_);   // the caller's cleared vector becomes the next pending buffer
+    for (auto& e : events) e.symbol = symbol;
+    return true;
+}
+
 std::unique_lock<std::shared_mutex> OrderBook::acquireLock() {
     return std::unique_lock<std::shared_mutex>(mu_);
 }
@@ -95,4 +206,4 @@ bool OrderBook::wouldTradeThrough(const Order& order) const {
         return bestBid > 0 && order.price < bestBid;
     }
     return false;
-}
\ No newline at end of file
+}
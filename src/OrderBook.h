@@ -1,9 +1,13 @@
 #pragma once
 #include "Order.h"
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <shared_mutex>
-#include <deque>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
 
 // L2 Market Data Structure
 struct L2Update {
@@ -11,6 +15,47 @@ struct L2Update {
     long long timestamp;
     std::vector<std::pair<double, double>> bids;  // [price, quantity]
     std::vector<std::pair<double, double>> asks;  // [price, quantity]
+    uint64_t seq = 0;                             // delta sequence this snapshot reflects
+};
+
+// One changed price level; quantity 0 means the level was removed
+struct L2Level {
+    Side side;
+    double price;
+    double quantity;
+};
+
+// Incremental L2 update: only the levels that changed since the previous delta
+struct L2Delta {
+    std::string symbol;
+    uint64_t seq;          // per-symbol, increments by one per delta
+    long long timestamp;
+    std::vector<L2Level> changes;
+};
+
+// Order-by-order (L3) book event, recorded where the book is mutated
+struct L3Event {
+    enum class Type : uint8_t { ADD, REDUCE, DELETE, EXECUTE };
+    
+    Type type;
+    std::string symbol;
+    uint64_t seq;          // per-symbol, increments by one per event
+    long long timestamp;
+    std::string orderId;
+    Side side;
+    double price;
+    double quantity;       // size still shown after the event (0 = order left the book, or its
+                           // iceberg slice ran out and an ADD re-queues the next one)
+    double execQty = 0.0;  // EXECUTE: size traded
+    std::string tradeId;   // EXECUTE: trade that consumed it
+};
+
+// All resting orders at one price, FIFO, plus their aggregate displayed size
+// (hidden iceberg size excluded). A list so a cancel or amend can unlink an
+// order through its locator in O(1).
+struct PriceLevel {
+    std::list<Order*> orders;
+    double totalQty = 0.0;
 };
 
 class OrderBook {
@@ -18,7 +63,15 @@ public:
     OrderBook() = default;
     
     void addOrder(Order* order);
-    void removeOrder(Order* order);
+    
+    // Cancel/amend support, O(1) via the per-order locator. Each returns false
+    // (and changes nothing) when the order is not resting in this book.
+    bool removeOrder(Order* order);
+    bool isResting(const Order* order) const;
+    // Shrink to newQuantity (total, > filledQty) in place, keeping time priority
+    bool reduceOrder(Order* order, double newQuantity);
+    // Move to the back of the newPrice queue with newQuantity, under one lock
+    bool requeueOrder(Order* order, double newPrice, double newQuantity);
     
     // BBO calculation - core REG NMS requirement
     std::pair<double, double> bestBidOffer() const;
@@ -30,6 +83,14 @@ public:
     // Generate L2 market data update
     L2Update generateL2Update(const std::string& symbol, int depth = 10) const;
     
+    // Collect the levels changed since the last call into a delta.
+    // Returns false (and leaves seq untouched) when nothing changed.
+    bool collectDelta(const std::string& symbol, L2Delta& delta);
+    
+    // Move the L3 events recorded since the last call into events (swapped, not copied).
+    // Returns false when nothing was recorded.
+    bool collectL3(const std::string& symbol, std::vector<L3Event>& events);
+    
     // Thread-safe access for matching engine
     std::unique_lock<std::shared_mutex> acquireLock();
     
@@ -39,15 +100,57 @@ public:
     const auto& getBids() const { return bids_; }
     const auto& getAsks() const { return asks_; }
     
+    // Record that a level was modified through getBids()/getAsks() (caller holds the lock)
+    void markLevelChanged(Side side, double price) { changed_.push_back({side, price}); }
+    
+    // Record a fill against a resting order (caller holds the lock)
+    void recordExecution(const Order& maker, double execQty, const std::string& tradeId);
+    
+    // Unlink a filled maker during matching (caller holds the lock); returns the next order
+    std::list<Order*>::iterator eraseFilled(PriceLevel& level, std::list<Order*>::iterator it) {
+        locators_.erase(*it);
+        return level.orders.erase(it);
+    }
+    
+    // A maker's iceberg slice traded away (caller holds the lock): show the next
+    // slice at the back of the level, in O(1); returns the next order to match
+    std::list<Order*>::iterator replenish(PriceLevel& level, std::list<Order*>::iterator it);
+    
     // Check if order would trade through (violate price-time priority)
     bool wouldTradeThrough(const Order& order) const;
     
 private:
     mutable std::shared_mutex mu_;
     
-    // Price-time priority: map<price, deque<Order*>>
+    // Price-time priority: map<price, level FIFO>
     // Bids: higher prices first (reverse order)
-    std::map<double, std::deque<Order*>, std::greater<double>> bids_;
+    std::map<double, PriceLevel, std::greater<double>> bids_;
     // Asks: lower prices first (normal order)
-    std::map<double, std::deque<Order*>, std::less<double>> asks_;
-};
\ No newline at end of file
+    std::map<double, PriceLevel, std::less<double>> asks_;
+    
+    // Where each resting order sits: its level and its node in the level's FIFO.
+    // std::map nodes and std::list nodes never move, so both stay valid until unlinked.
+    struct Locator {
+        PriceLevel* level;
+        std::list<Order*>::iterator pos;
+    };
+    std::unordered_map<const Order*, Locator> locators_;
+    
+    // Unlink a located order from its level, dropping the level when it empties (caller holds the lock)
+    void unlink(Order* order, const Locator& locator);
+    
+    // Levels touched since the last delta, and the last delta sequence
+    std::vector<std::pair<Side, double>> changed_;
+    uint64_t seq_ = 0;
+    
+    // L3 events not yet collected, and the last L3 sequence
+    std::vector<L3Event> l3Pending_;
+    uint64_t l3Seq_ = 0;
+    
+    void recordL3(L3Event::Type type, const Order& order, double quantity);
+    
+    // Show an iceberg's next slice; no-op for other orders
+    static void showSlice(Order* order) {
+        if (order->isIceberg()) order->visibleQty = std::min(order->displayQty, order->remaining());
+    }
+};
@@ -0,0 +1,222 @@
+#include "OrderEntryHandler.h"
+#include "OrderEntryProtocol.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace OrderEntry;
+
+namespace {
+
+// Numbers the owner tags of every transport's sessions
+std::atomic<uint64_t> sessionCounter{0};
+
+} // namespace
+
+OrderEntrySession::OrderEntrySession(const char* transport)
+    : owner(std::string(transport) + ":" + std::to_string(++sessionCounter)) {}
+
+void OrderEntrySession::ack(uint32_t refSeq, uint8_t requestType, OrderResult result, double filled,
+                            double leaves, const std::string& orderId, uint32_t count) {
+    Ack a{refSeq, requestType, static_cast<uint8_t>(result), filled, leaves, orderId, count};
+    deliver([&](std::string& out, uint32_t seq) { encodeAck(out, seq, isRejection(result), a); });
+}
+
+void OrderEntrySession::reject(uint32_t refSeq, uint8_t requestType, uint8_t code, const std::string& orderId) {
+    Ack a{refSeq, requestType, code, 0.0, 0.0, orderId};
+    deliver([&](std::string& out, uint32_t seq) { encodeAck(out, seq, true, a); });
+}
+
+OrderEntryHandler::OrderEntryHandler(MatchingEngine& engine) : engine_(engine) {
+    tradeSub_ = engine_.tradeFeed().subscribe([this](const TradeReport& trade) { onTrade(trade); });
+}
+
+size_t OrderEntryHandler::sessionEnded(OrderEntrySession& session) {
+    if (!session.cancelOnDisconnect) return 0;
+    MassCancelRequest request;
+    request.owner = session.owner;
+    std::vector<std::string> canceled = engine_.massCancel(request);
+    std::lock_guard<std::mutex> lock(ownersMu_);
+    for (const auto& orderId : canceled) owners_.erase(orderId);
+    return canceled.size();
+}
+
+void OrderEntryHandler::forgetOwners(const OrderEntrySession* ended) {
+    std::lock_guard<std::mutex> lock(ownersMu_);
+    for (auto it = owners_.begin(); it != owners_.end();) {
+        auto owner = it->second.session.lock();
+        if (!owner || owner.get() == ended) it = owners_.erase(it);
+        else ++it;
+    }
+}
+
+bool OrderEntryHandler::ownedBy(const std::string& orderId, const OrderEntrySession* session) {
+    std::lock_guard<std::mutex> lock(ownersMu_);
+    auto it = owners_.find(orderId);
+    return it != owners_.end() && it->second.session.lock().get() == session;
+}
+
+void OrderEntryHandler::handleNewOrder(const std::shared_ptr<OrderEntrySession>& session, uint32_t seq,
+                                       const char* data) {
+    Order order{};
+    decodeNewOrder(data, order);
+    order.timestamp = Order::now();
+    order.owner = session->owner;
+    if (static_cast<uint8_t>(order.type) > static_cast<uint8_t>(OrderType::FOK)) {
+        session->reject(seq, NEW_ORDER, BAD_MESSAGE, order.orderId);
+        return;
+    }
+
+    // Own the order before it can rest, so no maker fill is missed; a duplicate
+    // id keeps its current owner (the engine rejects the duplicate)
+    bool registered;
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        registered = owners_.try_emplace(order.orderId, OwnedOrder{session, order.side, order.quantity, 0.0}).second;
+    }
+
+    // Its own fills are counted by onTrade as they happen, before another thread can
+    // reach the resting remainder
+    OrderResponse response = engine_.submitOrder(order);
+    bool resting = (response.result == OrderResult::ACCEPTED);
+    if (registered && !resting) {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        owners_.erase(order.orderId);
+    }
+
+    double leaves = resting ? order.quantity - response.filledQuantity : 0.0;
+    session->ack(seq, NEW_ORDER, response.result, response.filledQuantity, leaves, order.orderId);
+    sendTakerFills(*session, order.orderId, order.side, order.quantity, 0.0, response.trades);
+}
+
+void OrderEntryHandler::handleCancel(const std::shared_ptr<OrderEntrySession>& session, uint32_t seq,
+                                     const char* data) {
+    std::string orderId;
+    decodeCancel(data, orderId);
+    if (!ownedBy(orderId, session.get()) || !engine_.cancelOrder(orderId)) {
+        session->reject(seq, CANCEL, static_cast<uint8_t>(OrderResult::REJECTED_UNKNOWN_ORDER), orderId);
+        return;
+    }
+
+    double filled = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        auto it = owners_.find(orderId);
+        if (it != owners_.end()) {
+            filled = it->second.filled;
+            owners_.erase(it);
+        }
+    }
+    session->ack(seq, CANCEL, OrderResult::ACCEPTED, filled, 0.0, orderId);
+}
+
+void OrderEntryHandler::handleAmend(const std::shared_ptr<OrderEntrySession>& session, uint32_t seq,
+                                    const char* data) {
+    Amend amend;
+    decodeAmend(data, amend);
+    if (!ownedBy(amend.orderId, session.get())) {
+        session->reject(seq, AMEND, static_cast<uint8_t>(OrderResult::REJECTED_UNKNOWN_ORDER), amend.orderId);
+        return;
+    }
+
+    OrderResponse response = engine_.amendOrder(amend.orderId, amend.price, amend.quantity);
+    if (isRejection(response.result)) {
+        session->reject(seq, AMEND, static_cast<uint8_t>(response.result), amend.orderId);
+        return;
+    }
+
+    double quantity = amend.quantity;
+    // Fills this amend caused were counted by onTrade; the taker fills start from before them
+    double filledBefore = response.filledQuantity;
+    for (const auto& trade : response.trades) filledBefore -= trade.quantity;
+    Side side = Side::BUY;
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        auto it = owners_.find(amend.orderId);
+        if (it != owners_.end()) {
+            OwnedOrder& owned = it->second;
+            if (amend.quantity > 0) owned.quantity = amend.quantity;
+            quantity = owned.quantity;
+            side = owned.side;
+            if (response.result == OrderResult::COMPLETELY_FILLED) owners_.erase(it);
+        }
+    }
+    double leaves = response.result == OrderResult::COMPLETELY_FILLED ? 0.0 : quantity - response.filledQuantity;
+    session->ack(seq, AMEND, response.result, response.filledQuantity, leaves, amend.orderId);
+    sendTakerFills(*session, amend.orderId, side, quantity, filledBefore, response.trades);
+}
+
+void OrderEntryHandler::handleMassCancel(const std::shared_ptr<OrderEntrySession>& session, uint32_t seq,
+                                         const char* data) {
+    MassCancel request;
+    decodeMassCancel(data, request);
+    if (request.side > kBothSides) {
+        session->reject(seq, MASS_CANCEL, BAD_MESSAGE, {});
+        return;
+    }
+
+    // The engine only looks at this session's own orders
+    MassCancelRequest filter;
+    filter.owner = session->owner;
+    filter.symbol = request.symbol;
+    filter.allSides = (request.side == kBothSides);
+    filter.side = request.side == 0 ? Side::BUY : Side::SELL;
+    std::vector<std::string> canceled = engine_.massCancel(filter);
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        for (const auto& orderId : canceled) owners_.erase(orderId);
+    }
+    session->ack(seq, MASS_CANCEL, OrderResult::ACCEPTED, 0.0, 0.0, {}, static_cast<uint32_t>(canceled.size()));
+}
+
+void OrderEntryHandler::sendTakerFills(OrderEntrySession& session, const std::string& orderId, Side side,
+                                       double quantity, double filledBefore,
+                                       const std::vector<TradeReport>& trades) {
+    double filled = filledBefore;
+    for (const auto& trade : trades) {
+        filled += trade.quantity;
+        Fill fill;
+        fill.orderId = orderId;
+        fill.tradeId = trade.tradeId;
+        fill.price = trade.price;
+        fill.quantity = trade.quantity;
+        fill.fee = trade.takerFee;
+        fill.leavesQty = std::max(0.0, quantity - filled);
+        fill.timestamp = trade.timestamp;
+        fill.taker = true;
+        fill.side = side;
+        session.deliver([&](std::string& out, uint32_t seq) { encodeFill(out, seq, fill); });
+    }
+}
+
+// Runs on the matching thread, under the engine lock
+void OrderEntryHandler::onTrade(const TradeReport& trade) {
+    std::shared_ptr<OrderEntrySession> session;
+    Fill fill;
+    {
+        std::lock_guard<std::mutex> lock(ownersMu_);
+        // A taker's fills go out with its ack; only count them here, so the maker
+        // fills of its resting remainder start from the right leaves
+        auto taker = owners_.find(trade.takerOrderId);
+        if (taker != owners_.end()) taker->second.filled += trade.quantity;
+
+        auto it = owners_.find(trade.makerOrderId);
+        if (it == owners_.end()) return;
+        OwnedOrder& owned = it->second;
+        owned.filled += trade.quantity;
+        fill.leavesQty = std::max(0.0, owned.quantity - owned.filled);
+        fill.side = owned.side;
+        session = owned.session.lock();
+        if (fill.leavesQty <= 0.0) owners_.erase(it);
+    }
+    if (!session) return;
+
+    fill.orderId = trade.makerOrderId;
+    fill.tradeId = trade.tradeId;
+    fill.price = trade.price;
+    fill.quantity = trade.quantity;
+    fill.fee = trade.makerFee;
+    fill.timestamp = trade.timestamp;
+    fill.taker = false;
+    session->deliver([&](std::string& out, uint32_t seq) { encodeFill(out, seq, fill); });
+    session->flushLater();
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "MatchingEngine.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One order-entry session as OrderEntryHandler sees it (OrderEntryProtocol.h
+// messages). The transport supplies deliver(): where encoded replies go, and
+// how they get out when they are queued from another thread.
+class OrderEntrySession {
+public:
+    // encode(out, seq) appends one message with outbound sequence number seq
+    using Encode = std::function<void(std::string& out, uint32_t seq)>;
+
+    // transport names the owner tag: "tcp" -> "tcp:1", unique within the process
+    explicit OrderEntrySession(const char* transport);
+    virtual ~OrderEntrySession() = default;
+
+    OrderEntrySession(const OrderEntrySession&) = delete;
+    OrderEntrySession& operator=(const OrderEntrySession&) = delete;
+
+    // Queue one outbound message (any thread)
+    virtual void deliver(const Encode& encode) = 0;
+    // Messages were delivered from a thread other than the session's own (maker
+    // fills); make sure they go out
+    virtual void flushLater() {}
+
+    void ack(uint32_t refSeq, uint8_t requestType, OrderResult result, double filled, double leaves,
+             const std::string& orderId, uint32_t count = 0);
+    void reject(uint32_t refSeq, uint8_t requestType, uint8_t code, const std::string& orderId);
+
+    const std::string owner;           // Order::owner of everything entered here
+    bool cancelOnDisconnect = false;   // SESSION_OPTIONS; session's own thread only
+};
+
+// Request handling and order ownership shared by the binary order-entry
+// transports (OrderGateway over TCP, ShmGateway over shared memory).
+//
+// Handlers run on the session's own thread with one complete, sequenced
+// request and call the engine directly. Orders entered through a session are
+// owned by it: only that session may cancel or amend them, and it receives
+// their maker fills as they happen, from whichever thread matched them.
+class OrderEntryHandler {
+public:
+    explicit OrderEntryHandler(MatchingEngine& engine);
+    ~OrderEntryHandler() { stop(); }
+
+    OrderEntryHandler(const OrderEntryHandler&) = delete;
+    OrderEntryHandler& operator=(const OrderEntryHandler&) = delete;
+
+    void handleNewOrder(const std::shared_ptr<OrderEntrySession>& session, uint32_t seq, const char* data);
+    void handleCancel(const std::shared_ptr<OrderEntrySession>& session, uint32_t seq, const char* data);
+    void handleAmend(const std::shared_ptr<OrderEntrySession>& session, uint32_t seq, const char* data);
+    void handleMassCancel(const std::shared_ptr<OrderEntrySession>& session, uint32_t seq, const char* data);
+
+    // The session is over: cancel its orders if it asked to; returns how many were canceled
+    size_t sessionEnded(OrderEntrySession& session);
+    // Orders stay on the book; forget the owners that can no longer be reached
+    // (ended is gone too, though another reference may still keep it alive)
+    void forgetOwners(const OrderEntrySession* ended = nullptr);
+
+    // No more maker fills: leave the trade feed. The transport calls it before
+    // tearing down what its sessions deliver through; harmless to repeat.
+    void stop() { engine_.tradeFeed().unsubscribe(tradeSub_); }
+
+private:
+    // Resting order entered through a session
+    struct OwnedOrder {
+        std::weak_ptr<OrderEntrySession> session;
+        Side side = Side::BUY;
+        double quantity = 0.0;
+        double filled = 0.0;
+    };
+
+    void sendTakerFills(OrderEntrySession& session, const std::string& orderId, Side side,
+                        double quantity, double filledBefore, const std::vector<TradeReport>& trades);
+    bool ownedBy(const std::string& orderId, const OrderEntrySession* session);
+    void onTrade(const TradeReport& trade);
+
+    MatchingEngine& engine_;
+    EventFeed<TradeReport>::Token tradeSub_;
+
+    // Never held while calling into the engine (the trade callback takes it under the engine lock)
+    std::mutex ownersMu_;
+    std::unordered_map<std::string, OwnedOrder> owners_;
+};
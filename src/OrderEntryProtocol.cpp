@@ -0,0 +1,214 @@
+#include "OrderEntryProtocol.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// ---- little-endian field access at fixed offsets ----
+
+void putU16(char* p, uint16_t v) {
+    p[0] = static_cast<char>(v);
+    p[1] = static_cast<char>(v >> 8);
+}
+
+void putU32(char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<char>(v >> (8 * i));
+}
+
+void putU64(char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<char>(v >> (8 * i));
+}
+
+void putF64(char* p, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    putU64(p, bits);
+}
+
+// Fixed-width, NUL padded (the message is zero-filled before fields are written)
+void putId(char* p, const std::string& s) {
+    std::memcpy(p, s.data(), std::min(s.size(), OrderEntry::kIdLength));
+}
+
+uint16_t getU16(const char* p) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8));
+}
+
+uint32_t getU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    return v;
+}
+
+uint64_t getU64(const char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    return v;
+}
+
+double getF64(const char* p) {
+    uint64_t bits = getU64(p);
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+void getId(const char* p, std::string& s) {
+    s.assign(p, strnlen(p, OrderEntry::kIdLength));
+}
+
+// Append a zero-filled message with its header; returns a pointer to its first byte
+char* startMessage(std::string& out, size_t size, uint8_t type, uint32_t seq) {
+    size_t at = out.size();
+    out.append(size, '\0');
+    char* p = &out[at];
+    putU16(p, static_cast<uint16_t>(size));
+    p[2] = static_cast<char>(type);
+    putU32(p + 4, seq);
+    return p;
+}
+
+} // namespace
+
+namespace OrderEntry {
+
+void encodeNewOrder(std::string& out, uint32_t seq, const Order& order) {
+    char* p = startMessage(out, kNewOrderSize, NEW_ORDER, seq);
+    putF64(p + 8, order.price);
+    putF64(p + 16, order.quantity);
+    p[24] = static_cast<char>(order.side == Side::BUY ? 0 : 1);
+    p[25] = static_cast<char>(order.type);
+    putId(p + 32, order.orderId);
+    putId(p + 52, order.symbol);
+}
+
+void encodeCancel(std::string& out, uint32_t seq, const std::string& orderId) {
+    char* p = startMessage(out, kCancelSize, CANCEL, seq);
+    putId(p + 8, orderId);
+}
+
+void encodeAmend(std::string& out, uint32_t seq, const Amend& amend) {
+    char* p = startMessage(out, kAmendSize, AMEND, seq);
+    putF64(p + 8, amend.price);
+    putF64(p + 16, amend.quantity);
+    putId(p + 24, amend.orderId);
+}
+
+void encodeMassCancel(std::string& out, uint32_t seq, const MassCancel& massCancel) {
+    char* p = startMessage(out, kMassCancelSize, MASS_CANCEL, seq);
+    putId(p + 8, massCancel.symbol);
+    p[28] = static_cast<char>(massCancel.side);
+}
+
+void encodeSessionOptions(std::string& out, uint32_t seq, const SessionOptions& options) {
+    char* p = startMessage(out, kSessionOptionsSize, SESSION_OPTIONS, seq);
+    p[8] = static_cast<char>(options.cancelOnDisconnect ? 1 : 0);
+    putU32(p + 12, options.heartbeatMs);
+}
+
+void encodeHeartbeat(std::string& out, uint32_t seq) {
+    startMessage(out, kHeartbeatSize, HEARTBEAT, seq);
+}
+
+void encodeAck(std::string& out, uint32_t seq, bool reject, const Ack& ack) {
+    char* p = startMessage(out, kAckSize, reject ? REJECT : ACK, seq);
+    putU32(p + 8, ack.refSeq);
+    p[12] = static_cast<char>(ack.requestType);
+    p[13] = static_cast<char>(ack.result);
+    putF64(p + 16, ack.filledQty);
+    putF64(p + 24, ack.leavesQty);
+    putId(p + 32, ack.orderId);
+    putU32(p + 52, ack.count);
+}
+
+void encodeFill(std::string& out, uint32_t seq, const Fill& fill) {
+    char* p = startMessage(out, kFillSize, FILL, seq);
+    putF64(p + 8, fill.price);
+    putF64(p + 16, fill.quantity);
+    putF64(p + 24, fill.fee);
+    putF64(p + 32, fill.leavesQty);
+    putU64(p + 40, static_cast<uint64_t>(fill.timestamp));
+    p[48] = static_cast<char>(fill.taker ? 1 : 0);
+    p[49] = static_cast<char>(fill.side == Side::BUY ? 0 : 1);
+    putId(p + 56, fill.orderId);
+    putId(p + 76, fill.tradeId);
+}
+
+Header decodeHeader(const char* data) {
+    Header h;
+    h.length = getU16(data);
+    h.type = static_cast<uint8_t>(data[2]);
+    h.seq = getU32(data + 4);
+    return h;
+}
+
+void decodeNewOrder(const char* p, Order& order) {
+    order.price = getF64(p + 8);
+    order.quantity = getF64(p + 16);
+    order.side = p[24] == 0 ? Side::BUY : Side::SELL;
+    order.type = static_cast<OrderType>(static_cast<uint8_t>(p[25]));
+    getId(p + 32, order.orderId);
+    getId(p + 52, order.symbol);
+    order.stopPrice = 0.0;
+    order.displayQty = 0.0;
+    order.filledQty = 0.0;
+}
+
+void decodeCancel(const char* p, std::string& orderId) {
+    getId(p + 8, orderId);
+}
+
+void decodeAmend(const char* p, Amend& amend) {
+    amend.price = getF64(p + 8);
+    amend.quantity = getF64(p + 16);
+    getId(p + 24, amend.orderId);
+}
+
+void decodeMassCancel(const char* p, MassCancel& massCancel) {
+    getId(p + 8, massCancel.symbol);
+    massCancel.side = static_cast<uint8_t>(p[28]);
+}
+
+void decodeSessionOptions(const char* p, SessionOptions& options) {
+    options.cancelOnDisconnect = p[8] != 0;
+    options.heartbeatMs = getU32(p + 12);
+}
+
+void decodeAck(const char* p, Ack& ack) {
+    ack.refSeq = getU32(p + 8);
+    ack.requestType = static_cast<uint8_t>(p[12]);
+    ack.result = static_cast<uint8_t>(p[13]);
+    ack.filledQty = getF64(p + 16);
+    ack.leavesQty = getF64(p + 24);
+    getId(p + 32, ack.orderId);
+    ack.count = getU32(p + 52);
+}
+
+void decodeFill(const char* p, Fill& fill) {
+    fill.price = getF64(p + 8);
+    fill.quantity = getF64(p + 16);
+    fill.fee = getF64(p + 24);
+    fill.leavesQty = getF64(p + 32);
+    fill.timestamp = static_cast<long long>(getU64(p + 40));
+    fill.taker = p[48] != 0;
+    fill.side = p[49] == 0 ? Side::BUY : Side::SELL;
+    getId(p + 56, fill.orderId);
+    getId(p + 76, fill.tradeId);
+}
+
+size_t messageSize(uint8_t type) {
+    switch (type) {
+        case NEW_ORDER: return kNewOrderSize;
+        case CANCEL:    return kCancelSize;
+        case AMEND:     return kAmendSize;
+        case MASS_CANCEL: return kMassCancelSize;
+        case SESSION_OPTIONS: return kSessionOptionsSize;
+        case HEARTBEAT: return kHeartbeatSize;
+        case ACK:
+        case REJECT:    return kAckSize;
+        case FILL:      return kFillSize;
+        default:        return 0;
+    }
+}
+
+} // namespace OrderEntry
@@ -0,0 +1,151 @@
+#pragma once
+#include "Order.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Fixed-length binary order-entry protocol spoken by OrderGateway.
+//
+// Every message is a fixed size per type; integers and doubles are
+// little-endian, strings are fixed-width and NUL padded. Clients may pipeline:
+// send any number of requests without waiting, the gateway answers in order.
+//
+//   header (8)    u16 length (whole message)  u8 type  u8 reserved  u32 seq
+//
+// seq is per direction and per connection, starting at 1. A client message
+// whose seq is not the previous one + 1 is rejected (BAD_SEQUENCE) and not
+// processed; the next message is then expected at its seq + 1.
+//
+// Client -> gateway
+//   NEW_ORDER (72)  8 f64 price  16 f64 quantity  24 u8 side (0=BUY, 1=SELL)
+//                   25 u8 orderType (OrderType)  28 (pad)  32 char[20] orderId  52 char[20] symbol
+//   CANCEL    (32)  8 char[20] orderId  (4 pad)
+//   AMEND     (48)  8 f64 price  16 f64 quantity (new total; 0 keeps the current value)
+//                   24 char[20] orderId  (4 pad)
+//   MASS_CANCEL (32) 8 char[20] symbol (empty = all)  28 u8 side (0=BUY, 1=SELL, 2=both)  (3 pad)
+//   SESSION_OPTIONS (16)  8 u8 cancelOnDisconnect  (3 pad)  12 u32 heartbeatMs (0 = no timeout)
+//   HEARTBEAT (8)   header only
+//
+// Gateway -> client
+//   ACK       (56)  8 u32 refSeq  12 u8 requestType  13 u8 result (OrderResult)  16 f64 filledQty
+//                   24 f64 leavesQty  32 char[20] orderId  52 u32 count (MASS_CANCEL: orders canceled)
+//   REJECT    (56)  same layout; result is an OrderResult rejection or a RejectCode
+//   FILL      (96)  8 f64 price  16 f64 quantity  24 f64 fee  32 f64 leavesQty  40 i64 timestamp
+//                   48 u8 liquidity (0=maker, 1=taker)  49 u8 side  56 char[20] orderId
+//                   76 char[20] tradeId
+//
+// Each request gets exactly one ACK or REJECT. Fills of the request's own
+// order follow its ACK; fills of resting orders arrive whenever they trade.
+// MASS_CANCEL pulls every resting order the session entered that matches its
+// symbol and side, as one engine operation.
+//
+// SESSION_OPTIONS applies to the rest of the session. With cancelOnDisconnect
+// set, the session's resting orders are mass-canceled when it ends for any
+// reason. With heartbeatMs set, a session that sends nothing (HEARTBEAT will
+// do) for that long is closed as if it had disconnected.
+namespace OrderEntry {
+
+enum MsgType : uint8_t {
+    NEW_ORDER = 1,
+    CANCEL = 2,
+    AMEND = 3,
+    MASS_CANCEL = 4,
+    SESSION_OPTIONS = 5,
+    HEARTBEAT = 6,
+    ACK = 11,
+    REJECT = 12,
+    FILL = 13
+};
+
+// REJECT result codes beyond OrderResult
+enum RejectCode : uint8_t {
+    BAD_SEQUENCE = 100,
+    BAD_MESSAGE = 101      // unknown type, wrong length for the type or bad enum value
+};
+
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kNewOrderSize = 72;
+constexpr size_t kCancelSize = 32;
+constexpr size_t kAmendSize = 48;
+constexpr size_t kMassCancelSize = 32;
+constexpr uint8_t kBothSides = 2;   // MASS_CANCEL side
+constexpr size_t kSessionOptionsSize = 16;
+constexpr size_t kHeartbeatSize = 8;
+constexpr size_t kAckSize = 56;
+constexpr size_t kFillSize = 96;
+constexpr size_t kIdLength = 20;   // orderId, tradeId and symbol field width
+
+struct Header {
+    uint16_t length = 0;
+    uint8_t type = 0;
+    uint32_t seq = 0;
+};
+
+struct Amend {
+    std::string orderId;
+    double price = 0.0;
+    double quantity = 0.0;
+};
+
+// ACK and REJECT
+struct Ack {
+    uint32_t refSeq = 0;
+    uint8_t requestType = 0;
+    uint8_t result = 0;
+    double filledQty = 0.0;
+    double leavesQty = 0.0;
+    std::string orderId;
+    uint32_t count = 0;
+};
+
+struct MassCancel {
+    std::string symbol;
+    uint8_t side = kBothSides;
+};
+
+struct SessionOptions {
+    bool cancelOnDisconnect = false;
+    uint32_t heartbeatMs = 0;
+};
+
+struct Fill {
+    std::string orderId;
+    std::string tradeId;
+    double price = 0.0;
+    double quantity = 0.0;
+    double fee = 0.0;
+    double leavesQty = 0.0;
+    long long timestamp = 0;
+    bool taker = false;
+    Side side = Side::BUY;
+};
+
+// Encoders append one complete message to out
+void encodeNewOrder(std::string& out, uint32_t seq, const Order& order);
+void encodeCancel(std::string& out, uint32_t seq, const std::string& orderId);
+void encodeAmend(std::string& out, uint32_t seq, const Amend& amend);
+void encodeMassCancel(std::string& out, uint32_t seq, const MassCancel& massCancel);
+void encodeSessionOptions(std::string& out, uint32_t seq, const SessionOptions& options);
+void encodeHeartbeat(std::string& out, uint32_t seq);
+void encodeAck(std::string& out, uint32_t seq, bool reject, const Ack& ack);
+void encodeFill(std::string& out, uint32_t seq, const Fill& fill);
+
+// Read the header at data (at least kHeaderSize bytes)
+Header decodeHeader(const char* data);
+
+// Decoders take one complete message of the type's size
+void decodeNewOrder(const char* data, Order& order);
+void decodeCancel(const char* data, std::string& orderId);
+void decodeAmend(const char* data, Amend& amend);
+void decodeMassCancel(const char* data, MassCancel& massCancel);
+void decodeSessionOptions(const char* data, SessionOptions& options);
+void decodeAck(const char* data, Ack& ack);
+void decodeFill(const char* data, Fill& fill);
+
+// Expected size of a message type, 0 when unknown
+size_t messageSize(uint8_t type);
+
+// A client -> gateway message type
+inline bool isRequest(uint8_t type) { return type >= NEW_ORDER && type <= HEARTBEAT; }
+
+} // namespace OrderEntry
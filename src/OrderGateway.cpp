@@ -0,0 +1,224 @@
+#include "OrderGateway.h"
+#include "Logger.h"
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+using namespace OrderEntry;
+
+namespace {
+
+constexpr size_t kReadBuffer = 64 * 1024;
+
+} // namespace
+
+// One order-entry connection. Reads and request handling happen on the io
+// thread; replies may be queued from any thread (maker fills) and are written
+// by the io thread.
+class OrderGateway::Session : public OrderEntrySession, public std::enable_shared_from_this<Session> {
+public:
+    Session(asio::ip::tcp::socket socket, OrderGateway& gateway)
+        : OrderEntrySession("tcp"),
+          socket_(std::move(socket)), gateway_(gateway), heartbeatTimer_(socket_.get_executor()),
+          in_(kReadBuffer) {}
+
+    ~Session() { gateway_.sessionClosed(); }
+
+    void start() {
+        asio::error_code ec;
+        socket_.set_option(asio::ip::tcp::no_delay(true), ec);
+        read();
+    }
+
+    void deliver(const Encode& encode) override {
+        std::lock_guard<std::mutex> lock(outMu_);
+        encode(outbox_, ++outSeq_);
+    }
+
+    // Queued from another thread: the io thread writes it
+    void flushLater() override {
+        auto self = shared_from_this();
+        asio::post(socket_.get_executor(), [self]() { self->flush(); });
+    }
+
+    // Write whatever is queued (io thread only); one send per batch of replies
+    void flush() {
+        std::unique_lock<std::mutex> lock(outMu_);
+        if (writing_) return;
+        if (outbox_.empty()) {
+            if (closing_) {
+                lock.unlock();
+                end();
+                close();
+            }
+            return;
+        }
+        inflight_.swap(outbox_);
+        outbox_.clear();
+        writing_ = true;
+        lock.unlock();
+
+        auto self = shared_from_this();
+        asio::async_write(socket_, asio::buffer(inflight_),
+            [this, self](const asio::error_code& ec, size_t) {
+                {
+                    std::lock_guard<std::mutex> lock(outMu_);
+                    writing_ = false;
+                    inflight_.clear();
+                }
+                if (!ec) flush();
+            });
+    }
+
+private:
+    void read() {
+        // Keep the unread tail of a partial message at the front of the buffer
+        if (inBegin_ > 0) {
+            std::memmove(in_.data(), in_.data() + inBegin_, inEnd_ - inBegin_);
+            inEnd_ -= inBegin_;
+            inBegin_ = 0;
+        }
+        auto self = shared_from_this();
+        socket_.async_read_some(asio::buffer(in_.data() + inEnd_, in_.size() - inEnd_),
+            [this, self](const asio::error_code& ec, size_t size) {
+                if (ec) {
+                    // Disconnect: the session object goes when its last handler is done
+                    end();
+                    return;
+                }
+                lastActivity_ = std::chrono::steady_clock::now();
+                inEnd_ += size;
+                process();
+                flush();
+                if (!closing_) read();
+            });
+    }
+
+    // Handle every complete request in the buffer, in order
+    void process() {
+        auto self = shared_from_this();
+        while (inEnd_ - inBegin_ >= kHeaderSize) {
+            const char* p = in_.data() + inBegin_;
+            Header header = decodeHeader(p);
+            if (!isRequest(header.type) || header.length != messageSize(header.type)) {
+                // Framing is lost; answer and hang up
+                reject(header.seq, header.type, BAD_MESSAGE, {});
+                closing_ = true;
+                return;
+            }
+            if (inEnd_ - inBegin_ < header.length) return;
+            inBegin_ += header.length;
+
+            if (header.seq != expectedSeq_) {
+                reject(header.seq, header.type, BAD_SEQUENCE, {});
+                expectedSeq_ = header.seq + 1;
+                continue;
+            }
+            expectedSeq_ = header.seq + 1;
+
+            switch (header.type) {
+                case NEW_ORDER: gateway_.entry_.handleNewOrder(self, header.seq, p); break;
+                case CANCEL:    gateway_.entry_.handleCancel(self, header.seq, p); break;
+                case AMEND:     gateway_.entry_.handleAmend(self, header.seq, p); break;
+                case MASS_CANCEL: gateway_.entry_.handleMassCancel(self, header.seq, p); break;
+                case SESSION_OPTIONS: applyOptions(header.seq, p); break;
+                case HEARTBEAT: ack(header.seq, HEARTBEAT, OrderResult::ACCEPTED, 0.0, 0.0, {}); break;
+            }
+        }
+    }
+
+    void applyOptions(uint32_t seq, const char* data) {
+        SessionOptions options;
+        decodeSessionOptions(data, options);
+        cancelOnDisconnect = options.cancelOnDisconnect;
+        heartbeat_ = std::chrono::milliseconds(options.heartbeatMs);
+        if (heartbeat_.count() > 0) waitHeartbeat(lastActivity_ + heartbeat_);
+        else heartbeatTimer_.cancel();
+        ack(seq, SESSION_OPTIONS, OrderResult::ACCEPTED, 0.0, 0.0, {});
+    }
+
+    // Check at due whether the client has sent anything since; one timer wait per
+    // heartbeat interval, not per message
+    void waitHeartbeat(std::chrono::steady_clock::time_point due) {
+        heartbeatTimer_.expires_at(due);
+        auto self = shared_from_this();
+        heartbeatTimer_.async_wait([this, self](const asio::error_code& ec) {
+            if (ec || ended_ || heartbeat_.count() == 0) return;
+            auto next = lastActivity_ + heartbeat_;
+            if (std::chrono::steady_clock::now() < next) {
+                waitHeartbeat(next);
+                return;
+            }
+            LOG_WARN("[OE] Session {} missed its heartbeat, closing", owner);
+            closing_ = true;
+            end();
+            close();
+        });
+    }
+
+    // The session is over (io thread): run the gateway's disconnect handling once
+    void end() {
+        if (ended_) return;
+        ended_ = true;
+        heartbeatTimer_.cancel();
+        gateway_.entry_.sessionEnded(*this);
+    }
+
+    void close() {
+        asio::error_code ec;
+        socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+        socket_.close(ec);
+    }
+
+    asio::ip::tcp::socket socket_;
+    OrderGateway& gateway_;
+    asio::steady_timer heartbeatTimer_;
+
+    // io thread only
+    std::vector<char> in_;
+    size_t inBegin_ = 0;
+    size_t inEnd_ = 0;
+    uint32_t expectedSeq_ = 1;
+    bool closing_ = false;
+    bool ended_ = false;
+    std::chrono::milliseconds heartbeat_{0};   // 0 = no heartbeat timeout
+    std::chrono::steady_clock::time_point lastActivity_ = std::chrono::steady_clock::now();
+
+    // Guarded by outMu_ (inflight_ belongs to the write in progress)
+    std::mutex outMu_;
+    std::string outbox_;
+    std::string inflight_;
+    uint32_t outSeq_ = 0;
+    bool writing_ = false;
+};
+
+OrderGateway::OrderGateway(MatchingEngine& engine, uint16_t port)
+    : entry_(engine),
+      acceptor_(io_, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)) {
+    startAccept();
+    ioThread_ = std::thread([this]() { io_.run(); });
+}
+
+OrderGateway::~OrderGateway() {
+    entry_.stop();   // no maker fill may post to the io_context once it is gone
+    io_.stop();
+    if (ioThread_.joinable()) ioThread_.join();
+}
+
+void OrderGateway::startAccept() {
+    acceptor_.async_accept([this](const asio::error_code& ec, asio::ip::tcp::socket socket) {
+        if (ec == asio::error::operation_aborted) return;
+        if (!ec) {
+            ++sessions_;
+            std::make_shared<Session>(std::move(socket), *this)->start();
+        } else {
+            LOG_ERROR("[OE] Accept failed: {}", ec.message());
+        }
+        startAccept();
+    });
+}
+
+void OrderGateway::sessionClosed() {
+    --sessions_;
+    entry_.forgetOwners();
+}
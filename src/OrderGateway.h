@@ -0,0 +1,47 @@
+#pragma once
+#include "MatchingEngine.h"
+#include "OrderEntryHandler.h"
+#include "OrderEntryProtocol.h"
+#include <asio.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Binary TCP order entry (see OrderEntryProtocol.h for the wire format).
+//
+// One io thread reads each connection, decodes every complete request in the
+// read buffer and calls the engine directly, then writes all replies produced
+// by that batch in one send. No HTTP, no JSON, no per-request allocation
+// beyond the engine's own.
+//
+// Request handling and ownership are OrderEntryHandler's: only the entering
+// session may cancel or amend an order, and it receives the order's maker
+// fills as they happen. A session may ask for its orders to be canceled when
+// it ends and for a heartbeat timeout (SESSION_OPTIONS).
+class OrderGateway {
+public:
+    explicit OrderGateway(MatchingEngine& engine, uint16_t port = 18081);   // 0 = any free port
+    ~OrderGateway();
+
+    OrderGateway(const OrderGateway&) = delete;
+    OrderGateway& operator=(const OrderGateway&) = delete;
+
+    uint16_t port() const { return acceptor_.local_endpoint().port(); }
+    size_t sessionCount() const { return sessions_.load(); }
+
+private:
+    class Session;
+
+    void startAccept();
+    void sessionClosed();
+
+    std::atomic<size_t> sessions_{0};
+
+    // Declared before io_: sessions destroyed with the io_context still unregister here
+    OrderEntryHandler entry_;
+
+    asio::io_context io_;
+    asio::ip::tcp::acceptor acceptor_;
+    std::thread ioThread_;
+};
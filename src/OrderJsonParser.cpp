@@ -0,0 +1,422 @@
+#include "OrderJsonParser.h"
+#include <charconv>
+#include <cstdint>
+#include <mutex>
+
+const std::string* SymbolTable::intern(std::string_view symbol) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mu_);
+        auto it = index_.find(symbol);
+        if (it != index_.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(mu_);
+    auto it = index_.find(symbol);
+    if (it != index_.end()) return it->second;
+    if (names_.size() >= capacity_) return nullptr;
+    names_.emplace_back(symbol);
+    const std::string* name = &names_.back();
+    index_.emplace(*name, name);
+    return name;
+}
+
+namespace {
+
+// Required fields, as bits of the "seen" mask
+constexpr unsigned kOrderId = 1;
+constexpr unsigned kSymbol = 2;
+constexpr unsigned kSide = 4;
+constexpr unsigned kOrderType = 8;
+constexpr unsigned kQuantity = 16;
+constexpr unsigned kOp = 32;
+
+constexpr size_t kMaxRequestId = 64;   // bytes of the raw req_id token
+
+constexpr int kMaxDepth = 32;   // nesting allowed inside skipped values
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Cursor over the body; every failure records the offset it happened at
+class Reader {
+public:
+    Reader(std::string_view body, OrderParseError& error)
+        : begin_(body.data()), p_(body.data()), end_(body.data() + body.size()), error_(error) {}
+
+    bool fail(const char* message) { return failAt(p_, message); }
+    bool failAt(const char* at, const char* message) {
+        error_.offset = static_cast<size_t>(at - begin_);
+        error_.message = message;
+        return false;
+    }
+
+    // Next significant character, '\0' at the end
+    char peek() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) ++p_;
+        return p_ < end_ ? *p_ : '\0';
+    }
+    bool consume(char c) {
+        if (peek() != c) return false;
+        ++p_;
+        return true;
+    }
+    bool atEnd() { return peek() == '\0' && p_ == end_; }
+    const char* pos() const { return p_; }
+    const char* next() {   // start of the next token
+        peek();
+        return p_;
+    }
+
+    // String token at the cursor: raw is the text between the quotes
+    bool readString(std::string_view& raw, bool& escaped) {
+        if (peek() != '"') return fail("expected a string");
+        const char* start = ++p_;
+        escaped = false;
+        while (p_ < end_) {
+            char c = *p_;
+            if (c == '"') {
+                raw = std::string_view(start, static_cast<size_t>(p_ - start));
+                ++p_;
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) return fail("control character in string");
+            if (c != '\\') {
+                ++p_;
+                continue;
+            }
+            escaped = true;
+            if (++p_ == end_) break;
+            switch (*p_) {
+                case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                    ++p_;
+                    break;
+                case 'u': {
+                    int unit = readHex4(p_ + 1);
+                    if (unit < 0) return fail("invalid \\u escape");
+                    p_ += 5;
+                    if (unit >= 0xDC00 && unit <= 0xDFFF) return failAt(p_ - 6, "unpaired surrogate");
+                    if (unit >= 0xD800 && unit <= 0xDBFF) {
+                        int low = (end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') ? readHex4(p_ + 2) : -1;
+                        if (low < 0xDC00 || low > 0xDFFF) return failAt(p_ - 6, "unpaired surrogate");
+                        p_ += 6;
+                    }
+                    break;
+                }
+                default:
+                    return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    // JSON number grammar, then from_chars on exactly that span
+    bool readNumber(double& value) {
+        const char* start = next();
+        if (p_ < end_ && *p_ == '-') ++p_;
+        if (p_ < end_ && *p_ == '0') {
+            ++p_;
+        } else if (p_ < end_ && isDigit(*p_)) {
+            while (p_ < end_ && isDigit(*p_)) ++p_;
+        } else {
+            return failAt(start, "expected a number");
+        }
+        if (p_ < end_ && *p_ == '.') {
+            if (++p_ == end_ || !isDigit(*p_)) return fail("expected a digit after '.'");
+            while (p_ < end_ && isDigit(*p_)) ++p_;
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            ++p_;
+            if (p_ < end_ && (*p_ == '+' || *p_ == '-')) ++p_;
+            if (p_ == end_ || !isDigit(*p_)) return fail("expected a digit in the exponent");
+            while (p_ < end_ && isDigit(*p_)) ++p_;
+        }
+        auto res = std::from_chars(start, p_, value);
+        if (res.ec != std::errc() || res.ptr != p_) return failAt(start, "number out of range");
+        return true;
+    }
+
+    bool readLiteral(std::string_view literal) {
+        if (static_cast<size_t>(end_ - p_) < literal.size() || std::string_view(p_, literal.size()) != literal) {
+            return fail("invalid literal");
+        }
+        p_ += literal.size();
+        return true;
+    }
+
+    // Validate and step over any value (unknown keys)
+    bool skipValue(int depth) {
+        if (depth > kMaxDepth) return fail("nesting too deep");
+        std::string_view raw;
+        bool escaped;
+        double number;
+        switch (peek()) {
+            case '"': return readString(raw, escaped);
+            case 't': return readLiteral("true");
+            case 'f': return readLiteral("false");
+            case 'n': return readLiteral("null");
+            case '{':
+                ++p_;
+                if (consume('}')) return true;
+                do {
+                    if (!readString(raw, escaped)) return false;
+                    if (!consume(':')) return fail("expected ':'");
+                    if (!skipValue(depth + 1)) return false;
+                } while (consume(','));
+                return consume('}') || fail("expected ',' or '}'");
+            case '[':
+                ++p_;
+                if (consume(']')) return true;
+                do {
+                    if (!skipValue(depth + 1)) return false;
+                } while (consume(','));
+                return consume(']') || fail("expected ',' or ']'");
+            default:
+                if (peek() == '-' || isDigit(peek())) return readNumber(number);
+                return fail("expected a value");
+        }
+    }
+
+private:
+    int readHex4(const char* at) const {
+        if (end_ - at < 4) return -1;
+        int value = 0;
+        for (int i = 0; i < 4; ++i) {
+            int digit = hexValue(at[i]);
+            if (digit < 0) return -1;
+            value = value * 16 + digit;
+        }
+        return value;
+    }
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    OrderParseError& error_;
+};
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+uint32_t hex4(const char* p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value = value * 16 + static_cast<uint32_t>(hexValue(p[i]));
+    return value;
+}
+
+// Unescape a string already validated by readString
+void unescape(std::string_view raw, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '\\') {
+            out.push_back(c);
+            continue;
+        }
+        switch (raw[++i]) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t cp = hex4(&raw[i + 1]);
+                i += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (hex4(&raw[i + 3]) - 0xDC00);
+                    i += 6;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default: out.push_back(raw[i]); break;   // " \ /
+        }
+    }
+}
+
+// String value as text; only escaped strings are copied (into scratch)
+bool readText(Reader& in, std::string_view& text, std::string& scratch, const char* typeError) {
+    if (in.peek() != '"') return in.fail(typeError);
+    bool escaped;
+    if (!in.readString(text, escaped)) return false;
+    if (escaped) {
+        unescape(text, scratch);
+        text = scratch;
+    }
+    return true;
+}
+
+bool readNumberField(Reader& in, double& value, bool nullable, const char* typeError) {
+    char c = in.peek();
+    if (nullable && c == 'n') {
+        value = 0.0;
+        return in.readLiteral("null");
+    }
+    if (c != '-' && !isDigit(c)) return in.fail(typeError);
+    return in.readNumber(value);
+}
+
+// One key's value, written straight into order; request is null for POST /orders
+// bodies, where "op" and "req_id" are unknown keys
+bool parseField(Reader& in, std::string_view key, Order& order, OrderRequest* request, unsigned& seen,
+                std::string& scratch, SymbolTable& symbols) {
+    std::string_view text;
+    const char* valueAt = nullptr;
+    if (request && key == "op") {
+        valueAt = in.next();
+        if (!readText(in, text, scratch, "\"op\" must be a string")) return false;
+        if (text == "new") request->op = OrderRequest::Op::NEW;
+        else if (text == "cancel") request->op = OrderRequest::Op::CANCEL;
+        else if (text == "amend") request->op = OrderRequest::Op::AMEND;
+        else if (text == "heartbeat") request->op = OrderRequest::Op::HEARTBEAT;
+        else return in.failAt(valueAt, "\"op\" must be \"new\", \"cancel\", \"amend\" or \"heartbeat\"");
+        seen |= kOp;
+    } else if (request && key == "req_id") {
+        valueAt = in.next();
+        char c = in.peek();
+        if (c != '"' && c != '-' && !isDigit(c)) return in.fail("\"req_id\" must be a string or a number");
+        if (!in.skipValue(0)) return false;
+        size_t length = static_cast<size_t>(in.pos() - valueAt);
+        if (length > kMaxRequestId) return in.failAt(valueAt, "\"req_id\" is too long");
+        request->requestId.assign(valueAt, length);
+    } else if (key == "order_id") {
+        if (!readText(in, text, scratch, "\"order_id\" must be a string")) return false;
+        if (text.empty()) return in.failAt(in.pos() - 2, "\"order_id\" must not be empty");
+        order.orderId.assign(text.data(), text.size());
+        seen |= kOrderId;
+    } else if (key == "symbol") {
+        if (!readText(in, text, scratch, "\"symbol\" must be a string")) return false;
+        if (text.empty()) return in.failAt(in.pos() - 2, "\"symbol\" must not be empty");
+        const std::string* interned = symbols.intern(text);
+        if (interned) order.symbol = *interned;
+        else order.symbol.assign(text.data(), text.size());
+        seen |= kSymbol;
+    } else if (key == "side") {
+        valueAt = in.next();
+        if (!readText(in, text, scratch, "\"side\" must be a string")) return false;
+        if (text == "buy") order.side = Side::BUY;
+        else if (text == "sell") order.side = Side::SELL;
+        else return in.failAt(valueAt, "\"side\" must be \"buy\" or \"sell\"");
+        seen |= kSide;
+    } else if (key == "order_type") {
+        valueAt = in.next();
+        if (!readText(in, text, scratch, "\"order_type\" must be a string")) return false;
+        if (text == "limit") order.type = OrderType::LIMIT;
+        else if (text == "market") order.type = OrderType::MARKET;
+        else if (text == "ioc") order.type = OrderType::IOC;
+        else if (text == "fok") order.type = OrderType::FOK;
+        else if (text == "stop_loss") order.type = OrderType::STOP_LOSS;
+        else if (text == "stop_limit") order.type = OrderType::STOP_LIMIT;
+        else if (text == "take_profit") order.type = OrderType::TAKE_PROFIT;
+        else return in.failAt(valueAt, "\"order_type\" must be \"market\", \"limit\", \"ioc\", \"fok\", "
+                                       "\"stop_loss\", \"stop_limit\" or \"take_profit\"");
+        seen |= kOrderType;
+    } else if (key == "quantity") {
+        if (!readNumberField(in, order.quantity, false, "\"quantity\" must be a number")) return false;
+        seen |= kQuantity;
+    } else if (key == "price") {
+        return readNumberField(in, order.price, true, "\"price\" must be a number");
+    } else if (key == "stop_price") {
+        return readNumberField(in, order.stopPrice, true, "\"stop_price\" must be a number");
+    } else if (key == "display_quantity") {
+        return readNumberField(in, order.displayQty, true, "\"display_quantity\" must be a number");
+    } else {
+        return in.skipValue(0);
+    }
+    return true;
+}
+
+// The object loop shared by parse() and parseRequest(); returns the fields seen
+// and leaves closing at the final '}'
+bool parseObject(Reader& in, Order& order, OrderRequest* request, unsigned& seen, const char*& closing,
+                 SymbolTable& symbols) {
+    std::string scratch;   // only used for strings with escapes
+    order.price = 0.0;
+    order.stopPrice = 0.0;
+    order.displayQty = 0.0;
+    order.filledQty = 0.0;
+
+    if (!in.consume('{')) return in.fail("expected '{'");
+    seen = 0;
+    if (!in.consume('}')) {
+        do {
+            std::string_view key;
+            bool escaped;
+            if (in.peek() != '"') return in.fail("expected a key");
+            if (!in.readString(key, escaped)) return false;
+            if (escaped) {
+                unescape(key, scratch);
+                key = scratch;
+            }
+            if (!in.consume(':')) return in.fail("expected ':'");
+            if (!parseField(in, key, order, request, seen, scratch, symbols)) return false;
+        } while (in.consume(','));
+        if (!in.consume('}')) return in.fail("expected ',' or '}'");
+    }
+    closing = in.pos() - 1;
+    if (!in.atEnd()) return in.fail("unexpected data after the order object");
+    return true;
+}
+
+bool requireOrderFields(Reader& in, unsigned seen, const char* closing) {
+    if (!(seen & kOrderId)) return in.failAt(closing, "missing \"order_id\"");
+    if (!(seen & kSymbol)) return in.failAt(closing, "missing \"symbol\"");
+    if (!(seen & kSide)) return in.failAt(closing, "missing \"side\"");
+    if (!(seen & kOrderType)) return in.failAt(closing, "missing \"order_type\"");
+    if (!(seen & kQuantity)) return in.failAt(closing, "missing \"quantity\"");
+    return true;
+}
+
+} // namespace
+
+bool OrderJsonParser::parse(std::string_view body, Order& order, OrderParseError& error) {
+    Reader in(body, error);
+    unsigned seen;
+    const char* closing;
+    return parseObject(in, order, nullptr, seen, closing, symbols_) && requireOrderFields(in, seen, closing);
+}
+
+bool OrderJsonParser::parseRequest(std::string_view message, OrderRequest& request, OrderParseError& error) {
+    Reader in(message, error);
+    request.requestId.clear();
+    request.order.quantity = 0.0;
+    unsigned seen;
+    const char* closing;
+    if (!parseObject(in, request.order, &request, seen, closing, symbols_)) return false;
+
+    if (!(seen & kOp)) return in.failAt(closing, "missing \"op\"");
+    switch (request.op) {
+        case OrderRequest::Op::NEW:
+            return requireOrderFields(in, seen, closing);
+        case OrderRequest::Op::CANCEL:
+            return (seen & kOrderId) || in.failAt(closing, "missing \"order_id\"");
+        case OrderRequest::Op::AMEND:
+            if (!(seen & kOrderId)) return in.failAt(closing, "missing \"order_id\"");
+            if (request.order.price == 0.0 && request.order.quantity == 0.0) {
+                return in.failAt(closing, "\"price\" or \"quantity\" required");
+            }
+            return true;
+        case OrderRequest::Op::HEARTBEAT:
+            return true;
+    }
+    return true;
+}
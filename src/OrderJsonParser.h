@@ -0,0 +1,69 @@
+#pragma once
+#include "Order.h"
+#include <cstddef>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Canonical copies of the symbols seen so far. Lookups by view do not
+// allocate; a symbol is copied once, the first time it is seen.
+class SymbolTable {
+public:
+    explicit SymbolTable(size_t capacity = 4096) : capacity_(capacity) {}
+
+    // Canonical string for symbol; nullptr when it is new and the table is full
+    const std::string* intern(std::string_view symbol);
+
+private:
+    size_t capacity_;
+    std::shared_mutex mu_;
+    std::deque<std::string> names_;                                    // stable addresses
+    std::unordered_map<std::string_view, const std::string*> index_;   // keys view into names_
+};
+
+// Where and why a body was rejected; offset is the byte where parsing stopped
+struct OrderParseError {
+    size_t offset = 0;
+    const char* message = "";
+};
+
+// Single-pass parser for the POST /orders body, specialised for its schema:
+//
+//   {"order_id":str, "symbol":str, "side":"buy"|"sell",
+//    "order_type":"market"|"limit"|"ioc"|"fok"|"stop_loss"|"stop_limit"|"take_profit",
+//    "quantity":num, "price":num (optional), "stop_price":num (optional),
+//    "display_quantity":num (optional)}
+//
+// Known keys are written straight into Order as they are read; numbers are
+// decoded with from_chars, strings are copied only when they contain escapes,
+// and unknown keys are validated and skipped. Symbols go through a SymbolTable.
+// Nothing else is allocated. A new field is one more entry in parseField().
+// One request on an order-entry session (/ws/orders):
+//
+//   {"op":"new", "req_id":.., <the POST /orders fields>}
+//   {"op":"cancel", "req_id":.., "order_id":str}
+//   {"op":"amend", "req_id":.., "order_id":str, "price":num, "quantity":num}   (either may be omitted)
+//   {"op":"heartbeat", "req_id":..}
+//
+// req_id is optional: any string or number the client uses to correlate replies.
+struct OrderRequest {
+    enum class Op { NEW, CANCEL, AMEND, HEARTBEAT };
+    Op op = Op::NEW;
+    std::string requestId;   // req_id as its raw JSON token, echoed back verbatim; empty when absent
+    Order order;             // NEW: the order; CANCEL/AMEND: order_id, price and quantity only
+};
+
+class OrderJsonParser {
+public:
+    // Fills every field but timestamp; false with error set on malformed or incomplete input
+    bool parse(std::string_view body, Order& order, OrderParseError& error);
+
+    // Same grammar plus "op" and "req_id"; request.requestId is set as soon as it
+    // is read, so a failed request can still be answered with it
+    bool parseRequest(std::string_view message, OrderRequest& request, OrderParseError& error);
+
+private:
+    SymbolTable symbols_;
+};
@@ -1,39 +1,151 @@
 #pragma once
 #include "Order.h"
+#include "TradeExecutionFeed.h"
 #include <string>
 #include <fstream>
+#include <ostream>
+#include <iomanip>
+#include <limits>
 #include <mutex>
+#include <cstdint>
+#include <cstdio>
+
+// What the journal records
+enum class JournalMode {
+    EVENTS,     // every order state change (NEW, PARTIAL_FILL, FILLED, ...) and every trade
+    COMMANDS    // only accepted input commands; fills are re-derived on replay
+};
 
 class Persistence {
 public:
-    Persistence(const std::string& journalFile, const std::string& snapshotFile)
-        : journalFile_(journalFile), snapshotFile_(snapshotFile) {
+    // An empty journal path disables journaling entirely (used by replay/benchmarks).
+    // The fill log is optional and only used in COMMANDS mode (audit trail of trades).
+    // With segmentBytes > 0 the journal is sealed as "<journal>.000001", ... once it
+    // grows past that size; sealed segments can then be compacted (see JournalSegment).
+    Persistence(const std::string& journalFile, const std::string& snapshotFile,
+                JournalMode mode = JournalMode::EVENTS,
+                const std::string& fillLogFile = "",
+                size_t segmentBytes = 0)
+        : journalFile_(journalFile), snapshotFile_(snapshotFile), mode_(mode),
+          segmentBytes_(segmentBytes) {
         // Open journal file in append mode
-        journalStream_.open(journalFile_, std::ios::app);
+        if (!journalFile_.empty()) {
+            openJournal();
+            journaling_ = journalStream_.is_open();
+            while (segmentBytes_ > 0 && std::ifstream(sealedName(nextSegment_)).good()) {
+                ++nextSegment_;
+            }
+        }
+        if (mode_ == JournalMode::COMMANDS && !fillLogFile.empty()) {
+            fillStream_.open(fillLogFile, std::ios::app);
+            fillStream_ << std::setprecision(std::numeric_limits<double>::max_digits10);
+        }
     }
     
     ~Persistence() {
         if (journalStream_.is_open()) {
             journalStream_.close();
         }
+        if (fillStream_.is_open()) {
+            fillStream_.close();
+        }
     }
     
+    bool enabled() const { return journaling_; }
+    JournalMode mode() const { return mode_; }
+    
+    // True when per-order state changes should be journaled
+    bool journalsEvents() const { return mode_ == JournalMode::EVENTS && enabled(); }
+    
     void logOrderEvent(const Order& order, const std::string& event) {
+        if (!journalsEvents()) return;
         std::lock_guard<std::mutex> lock(mutex_);
         
-        if (journalStream_.is_open()) {
-            journalStream_ << Order::now() << "|"
-                          << event << "|"
-                          << order.orderId << "|"
-                          << order.symbol << "|"
-                          << (order.side == Side::BUY ? "BUY" : "SELL") << "|"
-                          << static_cast<int>(order.type) << "|"
-                          << order.price << "|"
-                          << order.quantity << "|"
-                          << order.filledQty << "|"
-                          << order.timestamp << std::endl;
-            journalStream_.flush();
-        }
+        journalStream_ << Order::now() << "|"
+                      << event << "|"
+                      << order.orderId << "|"
+                      << order.symbol << "|"
+                      << (order.side == Side::BUY ? "BUY" : "SELL") << "|"
+                      << static_cast<int>(order.type) << "|"
+                      << order.price << "|"
+                      << order.quantity << "|"
+                      << order.filledQty << "|"
+                      << order.timestamp;
+        writeOptionalFields(order);
+        journalStream_ << std::endl;
+        journalStream_.flush();
+        maybeSeal();
+    }
+    
+    // Journal an accepted NEW command:
+    //   <ts>|CMD|seq|NEW|orderId|symbol|side|type|price|quantity|timestamp[|stopPrice[|displayQty]]
+    // stopPrice for conditional and iceberg orders, displayQty for icebergs only
+    void logNewCommand(uint64_t seq, const Order& order) {
+        if (mode_ != JournalMode::COMMANDS || !enabled()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        journalStream_ << Order::now() << "|CMD|" << seq << "|NEW|"
+                      << order.orderId << "|"
+                      << order.symbol << "|"
+                      << (order.side == Side::BUY ? "BUY" : "SELL") << "|"
+                      << static_cast<int>(order.type) << "|"
+                      << order.price << "|"
+                      << order.quantity << "|"
+                      << order.timestamp;
+        writeOptionalFields(order);
+        journalStream_ << "\n";
+        journalStream_.flush();
+        maybeSeal();
+    }
+    
+    // Journal an accepted CANCEL command:  <ts>|CMD|seq|CANCEL|orderId
+    void logCancelCommand(uint64_t seq, const std::string& orderId) {
+        if (mode_ != JournalMode::COMMANDS || !enabled()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        journalStream_ << Order::now() << "|CMD|" << seq << "|CANCEL|" << orderId << "\n";
+        journalStream_.flush();
+        maybeSeal();
+    }
+    
+    // Journal an accepted AMEND command:   <ts>|CMD|seq|AMEND|orderId|price|quantity
+    void logAmendCommand(uint64_t seq, const std::string& orderId, double price, double quantity) {
+        if (mode_ != JournalMode::COMMANDS || !enabled()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        journalStream_ << Order::now() << "|CMD|" << seq << "|AMEND|"
+                      << orderId << "|" << price << "|" << quantity << "\n";
+        journalStream_.flush();
+        maybeSeal();
+    }
+    
+    // Journal an executed trade so a replay can verify its output against it.
+    // EVENTS mode writes it to the journal, COMMANDS mode to the fill log (if any).
+    void logTrade(const TradeReport& trade) {
+        bool toJournal = (mode_ == JournalMode::EVENTS);
+        if (toJournal ? !enabled() : !fillStream_.is_open()) return;
+        std::ofstream& out = toJournal ? journalStream_ : fillStream_;
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        out << Order::now() << "|TRADE|";
+        writeTradeFields(out, trade);
+        out << "\n";
+        out.flush();
+        if (toJournal) maybeSeal();
+    }
+    
+    // Canonical trade record (everything after "<ts>|TRADE|"). Wall-clock
+    // timestamps are left out so replayed trades compare byte for byte.
+    static void writeTradeFields(std::ostream& os, const TradeReport& trade) {
+        os << trade.tradeId << "|"
+           << trade.symbol << "|"
+           << trade.aggressor << "|"
+           << trade.price << "|"
+           << trade.quantity << "|"
+           << trade.makerOrderId << "|"
+           << trade.takerOrderId << "|"
+           << trade.makerFee << "|"
+           << trade.takerFee;
     }
     
     void createSnapshot() {
@@ -49,9 +161,44 @@ public:
         return false;
     }
     
+    // Name of the n-th sealed segment of this journal
+    std::string sealedName(size_t n) const {
+        std::string num = std::to_string(n);
+        return journalFile_ + "." + std::string(num.size() < 6 ? 6 - num.size() : 0, '0') + num;
+    }
+    
 private:
+    void openJournal() {
+        journalStream_.open(journalFile_, std::ios::app);
+        // Full round-trip precision so a journal can be replayed exactly
+        journalStream_ << std::setprecision(std::numeric_limits<double>::max_digits10);
+    }
+    
+    // Trailing order fields, written only when set (caller holds mutex_):
+    // |stopPrice for conditional and iceberg orders, then |displayQty for icebergs
+    void writeOptionalFields(const Order& order) {
+        if (!order.isConditional() && !order.isIceberg()) return;
+        journalStream_ << "|" << order.stopPrice;
+        if (order.isIceberg()) journalStream_ << "|" << order.displayQty;
+    }
+    
+    // Called with mutex_ held after each record
+    void maybeSeal() {
+        if (segmentBytes_ == 0) return;
+        auto pos = journalStream_.tellp();
+        if (pos < 0 || static_cast<size_t>(pos) < segmentBytes_) return;
+        journalStream_.close();
+        std::rename(journalFile_.c_str(), sealedName(nextSegment_++).c_str());
+        openJournal();
+    }
+    
     std::string journalFile_;
     std::string snapshotFile_;
+    JournalMode mode_;
+    size_t segmentBytes_;
+    size_t nextSegment_ = 1;
+    bool journaling_ = false;   // fixed at construction; the stream reopens when sealing
     std::ofstream journalStream_;
+    std::ofstream fillStream_;
     mutable std::mutex mutex_;
-};
\ No newline at end of file
+};
@@ -0,0 +1,288 @@
+#include "ShmGateway.h"
+#include "OrderEntryProtocol.h"
+#include "Logger.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace OrderEntry;
+using namespace ShmTransport;
+
+namespace {
+
+constexpr int kMaxBatch = 64;   // requests taken from one session before moving to the next
+
+void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+bool processAlive(uint32_t pid) {
+    return pid != 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+std::string segmentName(const RegistrySlot& slot) {
+    return std::string(slot.segment, strnlen(slot.segment, kSegmentNameSize));
+}
+
+} // namespace
+
+// One client's mapped segment. Requests are read in place by the poll thread;
+// replies may be written from any thread (maker fills) under outMu_, which
+// keeps the response ring single-producer.
+class ShmGateway::Session : public OrderEntrySession {
+public:
+    Session(std::unique_ptr<Mapping> segment, SegmentHeader* header)
+        : OrderEntrySession("shm"), segment_(std::move(segment)) {
+        char* slots = segment_->data() + sizeof(SegmentHeader);
+        requests = Ring(&header->requests, slots, header->capacity);
+        responses_ = Ring(&header->responses, slots + static_cast<size_t>(header->capacity) * kSlotSize,
+                          header->capacity);
+    }
+
+    // Written straight into the response ring, so there is nothing left to flush
+    void deliver(const Encode& encode) override {
+        std::lock_guard<std::mutex> lock(outMu_);
+        if (closed_) return;
+        scratch_.clear();
+        encode(scratch_, ++outSeq_);
+        if (!responses_.push(scratch_.data(), scratch_.size())) {
+            closed_ = true;   // the client stopped reading; housekeeping hangs up
+            broken_ = true;
+        }
+    }
+
+    // No more replies; late maker fills are dropped
+    void close() {
+        std::lock_guard<std::mutex> lock(outMu_);
+        closed_ = true;
+    }
+
+    bool broken() const { return broken_.load(); }
+
+    // Poll thread only
+    Ring requests;
+    uint32_t expectedSeq = 1;
+    std::chrono::milliseconds heartbeat{0};   // 0 = no heartbeat timeout
+    bool active = false;                      // sent something since the last housekeeping
+    std::chrono::steady_clock::time_point lastActivity = std::chrono::steady_clock::now();
+
+private:
+    std::unique_ptr<Mapping> segment_;
+
+    std::mutex outMu_;
+    Ring responses_;
+    std::string scratch_;
+    uint32_t outSeq_ = 0;
+    bool closed_ = false;
+    std::atomic<bool> broken_{false};
+};
+
+ShmGateway::ShmGateway(MatchingEngine& engine, const ShmGatewayConfig& config)
+    : config_(config), entry_(engine) {
+    // A registry left by an engine that did not shut down cleanly is replaced;
+    // its clients see the heartbeat stop
+    shm_unlink(("/" + config_.name).c_str());
+    std::string error;
+    if (!registry_.create(config_.name, sizeof(Registry), error)) throw std::runtime_error(error);
+    auto* registry = new (registry_.data()) Registry;
+    registry->enginePid = static_cast<uint32_t>(getpid());
+    registry->version = kVersion;
+    registry->heartbeat.store(nowNanos(), std::memory_order_relaxed);
+    registry->magic = kMagic;
+
+    pollThread_ = std::thread([this]() { pollLoop(); });
+}
+
+ShmGateway::~ShmGateway() {
+    entry_.stop();
+    running_ = false;
+    if (pollThread_.joinable()) pollThread_.join();
+    for (size_t i = 0; i < kMaxClients; ++i) {
+        if (sessions_[i]) dropSession(i);
+    }
+    shm_unlink(("/" + config_.name).c_str());
+}
+
+// ---- poll loop ----
+
+void ShmGateway::pollLoop() {
+    using Clock = std::chrono::steady_clock;
+    const auto housekeepingInterval = std::chrono::milliseconds(1);
+    const auto livenessInterval = std::chrono::milliseconds(config_.livenessIntervalMs);
+    auto nextHousekeeping = Clock::now();
+    auto nextLiveness = nextHousekeeping + livenessInterval;
+    uint32_t idle = 0;
+
+    while (running_) {
+        bool worked = false;
+        for (const auto& session : sessions_) {
+            if (session && pollSession(session)) worked = true;
+        }
+
+        auto now = Clock::now();
+        if (now >= nextHousekeeping) {
+            bool checkLiveness = now >= nextLiveness;
+            if (checkLiveness) nextLiveness = now + livenessInterval;
+            housekeeping(checkLiveness);
+            nextHousekeeping = now + housekeepingInterval;
+        }
+
+        if (worked) {
+            idle = 0;
+        } else if (idle < config_.idleSpins) {
+            // Give the core away now and then, so a client on the same core can run
+            if (++idle % 64 == 0) std::this_thread::yield();
+            else cpuRelax();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(config_.idleSleepUs));
+        }
+    }
+}
+
+bool ShmGateway::pollSession(const std::shared_ptr<Session>& session) {
+    int handled = 0;
+    const char* p;
+    while (handled < kMaxBatch && (p = session->requests.front()) != nullptr) {
+        Header header = decodeHeader(p);
+        bool request = isRequest(header.type);
+        if (!request || header.length != messageSize(header.type)) {
+            // One message per slot, so framing survives: reject it and go on
+            session->reject(header.seq, header.type, BAD_MESSAGE, {});
+        } else if (header.seq != session->expectedSeq) {
+            session->reject(header.seq, header.type, BAD_SEQUENCE, {});
+        } else {
+            switch (header.type) {
+                case NEW_ORDER: entry_.handleNewOrder(session, header.seq, p); break;
+                case CANCEL:    entry_.handleCancel(session, header.seq, p); break;
+                case AMEND:     entry_.handleAmend(session, header.seq, p); break;
+                case MASS_CANCEL: entry_.handleMassCancel(session, header.seq, p); break;
+                case SESSION_OPTIONS: {
+                    SessionOptions options;
+                    decodeSessionOptions(p, options);
+                    session->cancelOnDisconnect = options.cancelOnDisconnect;
+                    session->heartbeat = std::chrono::milliseconds(options.heartbeatMs);
+                    session->ack(header.seq, SESSION_OPTIONS, OrderResult::ACCEPTED, 0.0, 0.0, {});
+                    break;
+                }
+                case HEARTBEAT: session->ack(header.seq, HEARTBEAT, OrderResult::ACCEPTED, 0.0, 0.0, {}); break;
+            }
+        }
+        if (request) session->expectedSeq = header.seq + 1;
+        session->requests.pop();   // the request was read in place; free the slot only now
+        ++handled;
+    }
+    if (handled == 0) return false;
+    session->active = true;   // stamped by housekeeping, to keep clock reads off this path
+    return true;
+}
+
+// ---- registry ----
+
+void ShmGateway::housekeeping(bool checkLiveness) {
+    auto* registry = reinterpret_cast<Registry*>(registry_.data());
+    registry->heartbeat.store(nowNanos(), std::memory_order_release);
+    auto now = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < kMaxClients; ++i) {
+        RegistrySlot& slot = registry->slots[i];
+        uint32_t state = slot.state.load(std::memory_order_acquire);
+        if (sessions_[i]) {
+            Session& session = *sessions_[i];
+            if (session.active) {
+                session.active = false;
+                session.lastActivity = now;
+            }
+            if (state == CLOSED) {
+                // The client hung up: the slot is ours to free
+                session.close();
+                sessionEnded(session);
+                sessions_[i].reset();
+                --sessionCount_;
+                shm_unlink(("/" + segmentName(slot)).c_str());
+                slot.state.store(FREE, std::memory_order_release);
+                LOG_INFO("[SHM] Client {} closed its session", slot.pid);
+            } else if (session.broken()) {
+                LOG_WARN("[SHM] Client {} stopped reading replies, closing its session", slot.pid);
+                dropSession(i);
+            } else if (checkLiveness && !processAlive(slot.pid)) {
+                LOG_WARN("[SHM] Client {} is gone, closing its session", slot.pid);
+                dropSession(i);
+                slot.state.store(FREE, std::memory_order_release);
+            } else if (session.heartbeat.count() > 0 && now - session.lastActivity > session.heartbeat) {
+                LOG_WARN("[SHM] Client {} missed its heartbeat, closing its session", slot.pid);
+                dropSession(i);
+            }
+            continue;
+        }
+        if (state == REQUESTED) {
+            openSession(i);
+        } else if (checkLiveness && state != FREE && state != ACTIVE && !processAlive(slot.pid)) {
+            // Died mid-handshake, or after we closed its session
+            shm_unlink(("/" + segmentName(slot)).c_str());
+            slot.state.store(FREE, std::memory_order_release);
+        }
+    }
+}
+
+void ShmGateway::openSession(size_t index) {
+    auto* registry = reinterpret_cast<Registry*>(registry_.data());
+    RegistrySlot& slot = registry->slots[index];
+    std::string name = segmentName(slot);
+
+    auto segment = std::make_unique<Mapping>();
+    std::string error;
+    bool ok = segment->open(name, sizeof(SegmentHeader), error);
+    auto* header = ok ? reinterpret_cast<SegmentHeader*>(segment->data()) : nullptr;
+    if (ok) {
+        uint32_t capacity = header->capacity;
+        ok = header->magic == kMagic && header->version == kVersion && capacity >= 2
+             && (capacity & (capacity - 1)) == 0 && segment->size() >= segmentSize(capacity);
+        if (!ok) error = "bad segment header";
+    }
+
+    uint32_t expected = REQUESTED;
+    if (!ok) {
+        LOG_WARN("[SHM] Refusing client {}: {}", slot.pid, error);
+        slot.state.compare_exchange_strong(expected, REFUSED, std::memory_order_acq_rel);
+        return;
+    }
+    auto session = std::make_shared<Session>(std::move(segment), header);
+    if (!slot.state.compare_exchange_strong(expected, ACTIVE, std::memory_order_acq_rel)) return;   // gave up waiting
+    sessions_[index] = std::move(session);
+    ++sessionCount_;
+    LOG_INFO("[SHM] Client {} connected ({}, {} slots per ring)", slot.pid, name, header->capacity);
+}
+
+void ShmGateway::dropSession(size_t index) {
+    auto* registry = reinterpret_cast<Registry*>(registry_.data());
+    RegistrySlot& slot = registry->slots[index];
+    std::shared_ptr<Session> session = std::move(sessions_[index]);
+    session->close();
+    sessionEnded(*session);
+    --sessionCount_;
+    shm_unlink(("/" + segmentName(slot)).c_str());
+
+    // The client frees the slot when it sees CLOSED (or housekeeping does once it is gone)
+    uint32_t expected = ACTIVE;
+    if (!slot.state.compare_exchange_strong(expected, CLOSED, std::memory_order_acq_rel) && expected == CLOSED) {
+        slot.state.store(FREE, std::memory_order_release);   // it hung up at the same time
+    }
+    entry_.forgetOwners(session.get());
+}
+
+// Cancel-on-disconnect: one mass cancel over the session's own orders
+void ShmGateway::sessionEnded(Session& session) {
+    size_t canceled = entry_.sessionEnded(session);
+    if (canceled > 0) LOG_INFO("[SHM] Canceled {} orders of {} on disconnect", canceled, session.owner);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "MatchingEngine.h"
+#include "OrderEntryHandler.h"
+#include "ShmTransport.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+struct ShmGatewayConfig {
+    std::string name = "matching_engine";   // registry at /dev/shm/<name>
+    uint32_t idleSpins = 20000;             // empty polls before the loop starts sleeping;
+                                            // UINT32_MAX busy-polls (give it a dedicated core)
+    int idleSleepUs = 50;                   // sleep between polls once idle
+    int livenessIntervalMs = 100;           // how often client pids are checked
+};
+
+// Order entry over shared memory for clients on the same host (see
+// ShmTransport.h for the segments, handshake and liveness rules).
+//
+// One thread polls every client's request ring and calls the engine directly,
+// as OrderGateway's io thread does for sockets, but with no system call on the
+// request path: acks and fills are written straight into the client's response
+// ring. Messages and sequencing are those of the TCP gateway
+// (OrderEntryProtocol.h), and requests go through the same OrderEntryHandler:
+// only the entering session may cancel or amend an order, and it receives the
+// order's maker fills. A client that lets its
+// response ring fill up is disconnected rather than stalling the engine.
+// SESSION_OPTIONS (cancel-on-disconnect, heartbeat timeout) work as on TCP;
+// a dead client process counts as a disconnect.
+class ShmGateway {
+public:
+    // Creates /dev/shm/<name>, replacing one left by a previous run; throws
+    // std::runtime_error when it cannot
+    explicit ShmGateway(MatchingEngine& engine, const ShmGatewayConfig& config = ShmGatewayConfig{});
+    ~ShmGateway();   // closes every session and removes the registry
+
+    ShmGateway(const ShmGateway&) = delete;
+    ShmGateway& operator=(const ShmGateway&) = delete;
+
+    const std::string& name() const { return config_.name; }
+    size_t sessionCount() const { return sessionCount_.load(); }
+
+private:
+    class Session;
+
+    void pollLoop();
+    bool pollSession(const std::shared_ptr<Session>& session);
+
+    // Registry upkeep (poll thread): heartbeat, new registrations, hang-ups and dead clients
+    void housekeeping(bool checkLiveness);
+    void openSession(size_t slot);
+    void dropSession(size_t slot);
+    void sessionEnded(Session& session);
+
+    ShmGatewayConfig config_;
+    ShmTransport::Mapping registry_;
+    OrderEntryHandler entry_;
+
+    std::shared_ptr<Session> sessions_[ShmTransport::kMaxClients];   // by registry slot; poll thread only
+    std::atomic<size_t> sessionCount_{0};
+    std::atomic<bool> running_{true};
+    std::thread pollThread_;
+};
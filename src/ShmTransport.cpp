@@ -0,0 +1,163 @@
+#include "ShmTransport.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace ShmTransport {
+
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// ---- Mapping ----
+
+namespace {
+
+std::string shmPath(const std::string& name) { return "/" + name; }
+
+std::string errnoText(const char* what, const std::string& name) {
+    return std::string(what) + " /dev/shm/" + name + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+Mapping::~Mapping() {
+    if (data_) munmap(data_, size_);
+}
+
+bool Mapping::create(const std::string& name, size_t size, std::string& error) {
+    int fd = shm_open(shmPath(name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        error = errnoText("cannot create", name);
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        error = errnoText("cannot size", name);
+        close(fd);
+        shm_unlink(shmPath(name).c_str());
+        return false;
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        error = errnoText("cannot map", name);
+        shm_unlink(shmPath(name).c_str());
+        return false;
+    }
+    data_ = static_cast<char*>(p);
+    size_ = size;
+    return true;
+}
+
+bool Mapping::open(const std::string& name, size_t minSize, std::string& error) {
+    int fd = shm_open(shmPath(name).c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        error = errnoText("cannot open", name);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < minSize) {
+        error = "/dev/shm/" + name + " is too small";
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        error = errnoText("cannot map", name);
+        return false;
+    }
+    data_ = static_cast<char*>(p);
+    size_ = size;
+    return true;
+}
+
+// ---- Client ----
+
+Client::Client(const std::string& name, uint32_t ringSlots, std::chrono::milliseconds timeout) {
+    if (ringSlots < 2 || (ringSlots & (ringSlots - 1)) != 0) {
+        throw std::invalid_argument("ringSlots must be a power of two");
+    }
+    std::string error;
+    if (!registry_.open(name, sizeof(Registry), error)) throw std::runtime_error(error);
+    auto* registry = reinterpret_cast<Registry*>(registry_.data());
+    if (registry->magic != kMagic || registry->version != kVersion) {
+        throw std::runtime_error("/dev/shm/" + name + " is not an order-entry registry");
+    }
+
+    // Claim a slot first: its index makes the segment name unique for this process
+    uint32_t pid = static_cast<uint32_t>(getpid());
+    for (size_t i = 0; i < kMaxClients && !slot_; ++i) {
+        uint32_t expected = FREE;
+        if (registry->slots[i].state.compare_exchange_strong(expected, CLAIMED)) {
+            slot_ = &registry->slots[i];
+            slot_->pid = pid;   // lets the engine reclaim the slot if we die mid-handshake
+            segmentName_ = name + "." + std::to_string(pid) + "." + std::to_string(i);
+        }
+    }
+    if (!slot_) throw std::runtime_error("no free order-entry slot in /dev/shm/" + name);
+
+    shm_unlink(shmPath(segmentName_).c_str());   // left over from a crashed process with our pid
+    if (!segment_.create(segmentName_, segmentSize(ringSlots), error)) {
+        slot_->state.store(FREE, std::memory_order_release);
+        throw std::runtime_error(error);
+    }
+    auto* header = new (segment_.data()) SegmentHeader;
+    header->capacity = ringSlots;
+    header->version = kVersion;
+    header->magic = kMagic;
+    char* slots = segment_.data() + sizeof(SegmentHeader);
+    requests_ = Ring(&header->requests, slots, ringSlots);
+    responses_ = Ring(&header->responses, slots + static_cast<size_t>(ringSlots) * kSlotSize, ringSlots);
+
+    std::memset(slot_->segment, 0, kSegmentNameSize);
+    segmentName_.copy(slot_->segment, kSegmentNameSize - 1);
+    slot_->state.store(REQUESTED, std::memory_order_release);
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    uint32_t state;
+    while ((state = slot_->state.load(std::memory_order_acquire)) == REQUESTED) {
+        if (std::chrono::steady_clock::now() > deadline) break;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    if (state == REQUESTED) {
+        // Take the request back unless the engine answers in the meantime
+        uint32_t expected = REQUESTED;
+        if (!slot_->state.compare_exchange_strong(expected, FREE)) state = expected;
+    }
+    if (state != ACTIVE) {
+        if (state == REFUSED) slot_->state.store(FREE, std::memory_order_release);
+        shm_unlink(shmPath(segmentName_).c_str());
+        throw std::runtime_error(state == REQUESTED ? "order-entry registration timed out"
+                                                    : "order-entry registration refused");
+    }
+}
+
+Client::~Client() {
+    // The engine frees the slot once it sees CLOSED. If the engine closed the
+    // session first it has already let go, so the slot is ours to free.
+    uint32_t expected = ACTIVE;
+    if (!slot_->state.compare_exchange_strong(expected, CLOSED) && expected == CLOSED) {
+        slot_->state.store(FREE, std::memory_order_release);
+    }
+    shm_unlink(shmPath(segmentName_).c_str());
+}
+
+bool Client::connected() const {
+    return slot_->state.load(std::memory_order_acquire) == ACTIVE;
+}
+
+bool Client::engineAlive(std::chrono::milliseconds maxSilence) const {
+    auto* registry = reinterpret_cast<const Registry*>(registry_.data());
+    int64_t silence = nowNanos() - registry->heartbeat.load(std::memory_order_acquire);
+    return silence <= std::chrono::duration_cast<std::chrono::nanoseconds>(maxSilence).count();
+}
+
+} // namespace ShmTransport
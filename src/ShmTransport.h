@@ -0,0 +1,191 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Shared-memory order entry for clients on the same host as the engine.
+//
+//   /dev/shm/<name>             registry, created by the engine: header + kMaxClients slots
+//   /dev/shm/<name>.<pid>.<n>   one segment per client: a request ring and a response ring
+//
+// Both rings are single-producer single-consumer queues of fixed kSlotSize
+// slots, each holding one OrderEntry message (OrderEntryProtocol.h) with the
+// same sequencing rules as the TCP gateway. Indexes are free-running u64
+// counters on their own cache lines; the producer publishes with a release
+// store of tail, the consumer frees slots with a release store of head.
+//
+// Handshake: the client claims a FREE registry slot (FREE -> CLAIMED by CAS),
+// creates and initialises its segment, writes its pid and segment name and
+// sets REQUESTED. The engine maps the segment, checks it and answers ACTIVE or
+// REFUSED. Either side ends the session by moving ACTIVE to CLOSED; the other
+// side then frees the slot (the engine also unlinks the segment).
+//
+// Liveness: the engine stamps Registry::heartbeat while it polls, so a client
+// can tell a stalled or dead engine; the engine checks that each client pid
+// still exists and closes the sessions of clients that died without saying so.
+namespace ShmTransport {
+
+constexpr uint64_t kMagic = 0x3130304D48534D45ULL;   // "EMSHM001"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kSlotSize = 128;                    // largest OrderEntry message is 96 bytes
+constexpr size_t kMaxClients = 64;
+constexpr size_t kSegmentNameSize = 64;
+
+enum SlotState : uint32_t {
+    FREE = 0,
+    CLAIMED = 1,     // a client is filling in the slot
+    REQUESTED = 2,   // waiting for the engine
+    ACTIVE = 3,
+    REFUSED = 4,     // bad segment; the client frees the slot
+    CLOSED = 5       // one side hung up; the other frees the slot
+};
+
+struct alignas(64) RegistrySlot {
+    std::atomic<uint32_t> state{FREE};
+    uint32_t pid = 0;
+    char segment[kSegmentNameSize] = {};   // shm_open name, NUL terminated
+};
+
+struct Registry {
+    uint64_t magic = 0;
+    uint32_t version = 0;
+    uint32_t enginePid = 0;
+    std::atomic<int64_t> heartbeat{0};   // ns since epoch, stamped by the engine's poll loop
+    RegistrySlot slots[kMaxClients];
+};
+
+// Indexes of one ring; head and tail on separate cache lines
+struct RingIndex {
+    alignas(64) std::atomic<uint64_t> head{0};   // next slot to consume
+    alignas(64) std::atomic<uint64_t> tail{0};   // next slot to produce
+};
+
+// Client segment: header, then capacity request slots, then capacity response slots
+struct SegmentHeader {
+    uint64_t magic = 0;
+    uint32_t version = 0;
+    uint32_t capacity = 0;   // slots per ring, a power of two
+    RingIndex requests;      // client -> engine
+    RingIndex responses;     // engine -> client
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring indexes must be lock-free across processes");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "slot states must be lock-free across processes");
+
+inline size_t segmentSize(uint32_t capacity) {
+    return sizeof(SegmentHeader) + 2 * static_cast<size_t>(capacity) * kSlotSize;
+}
+
+int64_t nowNanos();
+
+// One side of one ring. The producer and consumer each keep a private copy of
+// the other side's index and only reload it when the ring looks full or empty.
+class Ring {
+public:
+    Ring() = default;
+    Ring(RingIndex* index, char* slots, uint32_t capacity)
+        : index_(index), slots_(slots), mask_(capacity - 1) {}
+
+    // Producer: slot to write, nullptr when full; commit() publishes it
+    char* reserve() {
+        uint64_t tail = index_->tail.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ > mask_) {
+            cachedHead_ = index_->head.load(std::memory_order_acquire);
+            if (tail - cachedHead_ > mask_) return nullptr;
+        }
+        return slots_ + (tail & mask_) * kSlotSize;
+    }
+    void commit() {
+        index_->tail.store(index_->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: oldest unread slot, nullptr when empty; pop() frees it
+    const char* front() {
+        uint64_t head = index_->head.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = index_->tail.load(std::memory_order_acquire);
+            if (head == cachedTail_) return nullptr;
+        }
+        return slots_ + (head & mask_) * kSlotSize;
+    }
+    void pop() {
+        index_->head.store(index_->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Copy one message (at most kSlotSize bytes) in; false when full
+    bool push(const char* data, size_t size) {
+        char* slot = reserve();
+        if (!slot) return false;
+        std::memcpy(slot, data, size);
+        commit();
+        return true;
+    }
+
+private:
+    RingIndex* index_ = nullptr;
+    char* slots_ = nullptr;
+    uint64_t mask_ = 0;
+    uint64_t cachedHead_ = 0;   // producer's view
+    uint64_t cachedTail_ = 0;   // consumer's view
+};
+
+// Mapped POSIX shared-memory object; unmapped on destruction
+class Mapping {
+public:
+    Mapping() = default;
+    ~Mapping();
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    // create: O_CREAT|O_EXCL and size it; otherwise open and map the existing size
+    // (at least minSize). Returns false with error set.
+    bool create(const std::string& name, size_t size, std::string& error);
+    bool open(const std::string& name, size_t minSize, std::string& error);
+
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Client side of the transport, for strategies linked against the engine library.
+// Not thread-safe: one thread sends and polls.
+class Client {
+public:
+    // Register with the engine's registry; throws std::runtime_error when the
+    // engine is not running, has no free slot or does not answer within timeout
+    explicit Client(const std::string& name = "matching_engine", uint32_t ringSlots = 4096,
+                    std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+    ~Client();   // closes the session
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    // Queue one encoded OrderEntry request; false when the request ring is full
+    bool send(const char* data, size_t size) { return requests_.push(data, size); }
+    bool send(const std::string& message) { return send(message.data(), message.size()); }
+
+    // Next reply (one OrderEntry message), nullptr when none; valid until pop()
+    const char* poll() { return responses_.front(); }
+    void pop() { responses_.pop(); }
+
+    // False once the engine has closed the session (e.g. the client fell too far behind)
+    bool connected() const;
+    // The engine has stamped its heartbeat within maxSilence
+    bool engineAlive(std::chrono::milliseconds maxSilence = std::chrono::milliseconds(1000)) const;
+
+private:
+    std::string segmentName_;
+    Mapping registry_;
+    Mapping segment_;
+    RegistrySlot* slot_ = nullptr;
+    Ring requests_;    // producer
+    Ring responses_;   // consumer
+};
+
+} // namespace ShmTransport
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 struct TradeReport {
@@ -39,4 +40,15 @@ struct TradeReport {
             {"taker_fee", std::to_string(takerFee)}
         };
     }
-};
\ No newline at end of file
+};
+
+// All fills produced by one aggressive order, in match order. Published once
+// per match so market data pays its per-message cost once per taker rather
+// than once per maker hit.
+struct ExecutionBatch {
+    std::string symbol;
+    std::string takerOrderId;
+    std::string aggressor;      // "BUY" or "SELL"
+    long long timestamp = 0;    // when matching finished
+    std::vector<TradeReport> fills;
+};
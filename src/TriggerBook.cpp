@@ -0,0 +1,37 @@
+#include "TriggerBook.h"
+
+void TriggerBook::add(Order* o) {
+    Locator locator{o->triggersOnRise(), {}, {}};
+    // multimap inserts after equal keys, so equal triggers fire in arrival order
+    if (locator.rising) locator.up = rising_.emplace(o->stopPrice, o);
+    else locator.down = falling_.emplace(o->stopPrice, o);
+    locators_[o] = locator;
+}
+
+bool TriggerBook::remove(Order* o) {
+    auto it = locators_.find(o);
+    if (it == locators_.end()) return false;
+    if (it->second.rising) rising_.erase(it->second.up);
+    else falling_.erase(it->second.down);
+    locators_.erase(it);
+    return true;
+}
+
+bool TriggerBook::isTriggered(const Order& o) const {
+    if (lastPrice_ <= 0.0) return false;
+    return o.triggersOnRise() ? lastPrice_ >= o.stopPrice : lastPrice_ <= o.stopPrice;
+}
+
+void TriggerBook::onTrade(double price, std::vector<Order*>& fired) {
+    lastPrice_ = price;
+    while (!rising_.empty() && rising_.begin()->first <= price) {
+        fired.push_back(rising_.begin()->second);
+        locators_.erase(rising_.begin()->second);
+        rising_.erase(rising_.begin());
+    }
+    while (!falling_.empty() && falling_.begin()->first >= price) {
+        fired.push_back(falling_.begin()->second);
+        locators_.erase(falling_.begin()->second);
+        falling_.erase(falling_.begin());
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Order.h"
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Pending conditional orders (STOP_LOSS, STOP_LIMIT, TAKE_PROFIT) of one
+// symbol, waiting for a trade to reach their stopPrice.
+//
+// Two sides keyed by trigger price: orders fired by a rising last price sorted
+// ascending, orders fired by a falling one sorted descending, so the orders a
+// trade fires are always a prefix of each side. Equal triggers keep arrival
+// order. Not locked: the engine guards it with its own order lock.
+class TriggerBook {
+public:
+    // Park an order (isConditional()) until a trade reaches its stopPrice
+    void add(Order* order);
+    // Take a parked order out, O(1) via its locator; false when it is not parked here
+    bool remove(Order* order);
+    bool contains(const Order* order) const { return locators_.count(order) > 0; }
+    size_t size() const { return locators_.size(); }
+
+    // Would the order fire at once against the last traded price? Always false
+    // before the symbol's first trade.
+    bool isTriggered(const Order& order) const;
+
+    // Record a trade at price and pop every order it fires, appending them to
+    // fired: rising side first, each side in trigger-then-arrival order.
+    // O(log n + k) for k fired orders.
+    void onTrade(double price, std::vector<Order*>& fired);
+
+    double lastPrice() const { return lastPrice_; }
+
+private:
+    using RisingSide = std::multimap<double, Order*, std::less<double>>;
+    using FallingSide = std::multimap<double, Order*, std::greater<double>>;
+
+    RisingSide rising_;     // buy stops, sell take-profits: fire when last >= trigger
+    FallingSide falling_;   // sell stops, buy take-profits: fire when last <= trigger
+    double lastPrice_ = 0.0;   // 0 = no trade yet
+
+    // Where each parked order sits; multimap nodes never move, so iterators stay valid
+    struct Locator {
+        bool rising;
+        RisingSide::iterator up;
+        FallingSide::iterator down;
+    };
+    std::unordered_map<const Order*, Locator> locators_;
+};
@@ -0,0 +1,22 @@
+/* log_decode.cpp - turn binary log files (LogConfig::binaryFile) back into text */
+#include "Logger.h"
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: log_decode <binary-log>...\n"
+                  << "Writes the formatted lines to stdout.\n";
+        return 2;
+    }
+
+    int failures = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string error;
+        if (!Log::decodeFile(argv[i], std::cout, error)) {
+            std::cerr << argv[i] << ": " << error << "\n";
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -1,50 +1,137 @@
 /* main.cpp */
 #include "MatchingEngine.h"
 #include "MarketDataServer.h"
+#include "MulticastPublisher.h"
+#include "OrderGateway.h"
+#include "FixGateway.h"
+#include "ShmGateway.h"
+#include "Logger.h"
 #include <iostream>
 #include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 
 static MarketDataServer* g_server = nullptr;
 
+static LogLevel parseLogLevel(const char* name) {
+    if (std::strcmp(name, "trace") == 0) return LogLevel::Trace;
+    if (std::strcmp(name, "debug") == 0) return LogLevel::Debug;
+    if (std::strcmp(name, "warn") == 0) return LogLevel::Warn;
+    if (std::strcmp(name, "error") == 0) return LogLevel::Error;
+    if (std::strcmp(name, "off") == 0) return LogLevel::Off;
+    return LogLevel::Info;
+}
+
 // Handle SIGINT/SIGTERM for graceful shutdown
 void signalHandler(int signum) {
     std::cout << "Interrupt signal (" << signum << ") received. Stopping server...\n";
     if (g_server) g_server->stop();
 }
 
-int main() {
+int main(int argc, char** argv) {
     std::cout << "=== MAIN FUNCTION STARTED ===\n";
 
     // Register signal handlers
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
 
+    bool enableMulticast = false;
+    int gatewayPort = 18081;
+    int fixPort = 18082;
+    std::string shmName = "matching_engine";
+    EngineConfig engineConfig;
+    LogConfig logConfig;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--multicast") == 0) enableMulticast = true;
+        else if (std::strcmp(argv[i], "--gateway-port") == 0 && i + 1 < argc) gatewayPort = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--fix-port") == 0 && i + 1 < argc) fixPort = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) shmName = argv[++i];
+        else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) logConfig.level = parseLogLevel(argv[++i]);
+        else if (std::strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) logConfig.textFile = argv[++i];
+        else if (std::strcmp(argv[i], "--log-binary") == 0 && i + 1 < argc) logConfig.binaryFile = argv[++i];
+        else if (std::strcmp(argv[i], "--quiet") == 0) logConfig.console = false;
+        else if (std::strcmp(argv[i], "--journal") == 0 && i + 1 < argc) engineConfig.journalFile = argv[++i];
+        else if (std::strcmp(argv[i], "--journal-mode") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "commands") == 0) engineConfig.journalMode = JournalMode::COMMANDS;
+            else if (std::strcmp(mode, "events") == 0) engineConfig.journalMode = JournalMode::EVENTS;
+            else {
+                std::cerr << "--journal-mode must be events or commands\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--fill-log") == 0 && i + 1 < argc) engineConfig.fillLogFile = argv[++i];
+        else if (std::strcmp(argv[i], "--journal-segment-bytes") == 0 && i + 1 < argc) {
+            engineConfig.journalSegmentBytes = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+    if (!engineConfig.fillLogFile.empty() && engineConfig.journalMode != JournalMode::COMMANDS) {
+        std::cerr << "--fill-log needs --journal-mode commands (EVENTS journals keep their trades)\n";
+        return 1;
+    }
+    Log::configure(logConfig);
+
     // Construct the engine
-    MatchingEngine engine;
+    MatchingEngine engine(engineConfig);
     std::cout << "=== MatchingEngine initialized ===\n";
 
-    // Subscribe console logger to the TRADE feed
+    // Trades and L2 updates go through the async logger: the callbacks run under
+    // the engine lock, so they only copy the fields into a log record
     engine.tradeFeed().subscribe([](const TradeReport& rpt) {
-        std::cout << "[TRADE] " << rpt.tradeId
-                  << " " << rpt.quantity << "@" << rpt.price
-                  << " (makerFee=" << rpt.makerFee
-                  << ", takerFee=" << rpt.takerFee << ")\n";
+        LOG_INFO("[TRADE] {} {}@{} (makerFee={}, takerFee={})",
+                 rpt.tradeId, rpt.quantity, rpt.price, rpt.makerFee, rpt.takerFee);
     });
-
-    // (Optional) Subscribe console logger to the L2 book feed
-    engine.l2Feed().subscribe([](const L2Update& upd) {
-        std::cout << "[L2] " << upd.symbol
-                  << " bids=" << upd.bids.size()
-                  << " asks=" << upd.asks.size()
-                  << " ts=" << upd.timestamp << "\n";
+    engine.l2DeltaFeed().subscribe([](const L2Delta& delta) {
+        LOG_DEBUG("[L2] {} seq={} changes={} ts={}", delta.symbol, delta.seq, delta.changes.size(), delta.timestamp);
     });
 
+    // Optional UDP multicast feed (A/B channels + TCP retransmission)
+    std::unique_ptr<MulticastPublisher> multicast;
+    if (enableMulticast) {
+        MulticastConfig mcast;
+        multicast = std::make_unique<MulticastPublisher>(engine, mcast);
+        std::cout << "Multicast feed on " << mcast.groupA << ":" << mcast.portA
+                  << " / " << mcast.groupB << ":" << mcast.portB
+                  << ", retransmit on tcp " << multicast->retransmitPort() << "\n";
+    }
+
+    // Binary TCP order entry next to the HTTP API (--gateway-port 0 disables it)
+    std::unique_ptr<OrderGateway> gateway;
+    if (gatewayPort > 0) {
+        gateway = std::make_unique<OrderGateway>(engine, static_cast<uint16_t>(gatewayPort));
+        std::cout << "Binary order entry on tcp " << gateway->port() << "\n";
+    }
+
+    // FIX 4.4 order entry (--fix-port 0 disables it)
+    std::unique_ptr<FixGateway> fix;
+    if (fixPort > 0) {
+        fix = std::make_unique<FixGateway>(engine, static_cast<uint16_t>(fixPort));
+        std::cout << "FIX 4.4 order entry on tcp " << fix->port() << " (TargetCompID ENGINE)\n";
+    }
+
+    // Shared-memory order entry for same-host clients (--shm-name "" disables it)
+    std::unique_ptr<ShmGateway> shm;
+    if (!shmName.empty()) {
+        ShmGatewayConfig shmConfig;
+        shmConfig.name = shmName;
+        shm = std::make_unique<ShmGateway>(engine, shmConfig);
+        std::cout << "Shared-memory order entry on /dev/shm/" << shm->name() << "\n";
+    }
+
     std::cout << "Creating MarketDataServer...\n";
     MarketDataServer server(engine, 18080);
     g_server = &server;
 
     std::cout << "Server listening on http://0.0.0.0:18080\n";
     server.run();
+
+    // Stop order entry before what consumes its events: each subscriber leaves the
+    // engine feeds as it goes, and none is torn down while another input still matches
+    shm.reset();
+    fix.reset();
+    gateway.reset();
+    Log::flush();
     std::cout << "Server has shut down.\n";
     return 0;
 }
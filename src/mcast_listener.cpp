@@ -0,0 +1,250 @@
+/* mcast_listener.cpp - A/B multicast market data listener with TCP gap fill */
+#include "MulticastPublisher.h"
+#include "BinaryCodec.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace {
+
+struct Stats {
+    uint64_t packets[2] = {0, 0};   // per channel
+    uint64_t duplicates = 0;
+    uint64_t gaps = 0;
+    uint64_t retransmitted = 0;
+    uint64_t unrecoverable = 0;
+    uint64_t trades = 0;
+    uint64_t deltas = 0;
+};
+
+uint64_t readU64(const char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    return v;
+}
+
+uint32_t readU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    return v;
+}
+
+uint16_t readU16(const char* p) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8));
+}
+
+class Listener {
+public:
+    Listener(asio::io_context& io, const MulticastConfig& config, const std::string& only,
+             const std::string& retransmitHost, int dropEvery, bool verbose)
+        : config_(config), retransmitHost_(retransmitHost), dropEvery_(dropEvery), verbose_(verbose),
+          socketA_(io), socketB_(io), retransmit_(io) {
+        if (only != "B") join(socketA_, config.groupA, config.portA, config.interfaceA);
+        if (only != "A") join(socketB_, config.groupB, config.portB, config.interfaceB);
+        if (socketA_.is_open()) receive(socketA_, bufferA_, 0);
+        if (socketB_.is_open()) receive(socketB_, bufferB_, 1);
+    }
+
+    // A gap that the other channel hasn't filled within gapTimeout is fetched over TCP
+    void checkGap(std::chrono::milliseconds gapTimeout) {
+        if (pending_.empty()) return;
+        auto now = std::chrono::steady_clock::now();
+        if (now - gapSince_ < gapTimeout) return;
+        uint64_t missingTo = pending_.begin()->first - 1;
+        requestRetransmit(expected_, missingTo);
+        if (pending_.begin()->first != expected_) {
+            // Older than the publisher's ring: skip ahead (a real client resyncs from a snapshot)
+            stats_.unrecoverable += pending_.begin()->first - expected_;
+            expected_ = pending_.begin()->first;
+        }
+        drain();
+    }
+
+    const Stats& stats() const { return stats_; }
+    uint64_t lastSeq() const { return expected_ - 1; }
+
+private:
+    static constexpr size_t kMaxPacket = 65536;
+
+    void join(asio::ip::udp::socket& socket, const std::string& group, uint16_t port,
+              const std::string& interfaceAddress) {
+        asio::ip::udp::endpoint listen(asio::ip::address_v4::any(), port);
+        socket.open(listen.protocol());
+        socket.set_option(asio::ip::udp::socket::reuse_address(true));
+        socket.bind(listen);
+        socket.set_option(asio::ip::multicast::join_group(
+            asio::ip::make_address_v4(group), asio::ip::make_address_v4(interfaceAddress)));
+    }
+
+    void receive(asio::ip::udp::socket& socket, std::string& buffer, int channel) {
+        buffer.resize(kMaxPacket);
+        socket.async_receive(asio::buffer(&buffer[0], buffer.size()),
+            [this, &socket, &buffer, channel](const asio::error_code& ec, size_t size) {
+                if (ec) return;
+                ++stats_.packets[channel];
+                bool dropped = (channel == 0 && dropEvery_ > 0 && stats_.packets[0] % dropEvery_ == 0);
+                if (!dropped) onPacket(std::string(buffer.data(), size));
+                receive(socket, buffer, channel);
+            });
+    }
+
+    void onPacket(std::string packet) {
+        if (packet.size() < MulticastPublisher::kPacketHeaderSize) return;
+        uint64_t seq = readU64(packet.data());
+        if (expected_ == 0) expected_ = seq;   // late join: start from the first packet seen
+        if (seq < expected_ || pending_.count(seq)) {
+            ++stats_.duplicates;               // the other channel's copy
+            return;
+        }
+        if (seq > expected_ && pending_.empty()) {
+            ++stats_.gaps;
+            gapSince_ = std::chrono::steady_clock::now();
+        }
+        pending_.emplace(seq, std::move(packet));
+        drain();
+    }
+
+    void drain() {
+        bool advanced = false;
+        for (auto it = pending_.begin(); it != pending_.end() && it->first == expected_;) {
+            handle(it->second);
+            ++expected_;
+            advanced = true;
+            it = pending_.erase(it);
+        }
+        if (advanced && !pending_.empty()) {   // a newer gap remains
+            ++stats_.gaps;
+            gapSince_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    void handle(const std::string& packet) {
+        const char* p = packet.data() + 8;
+        uint16_t count = readU16(p);
+        p += 2;
+        const char* end = packet.data() + packet.size();
+        for (uint16_t i = 0; i < count && p + 2 <= end; ++i) {
+            uint16_t length = readU16(p);
+            p += 2;
+            if (p + length > end) break;
+            switch (BinaryCodec::templateId(p, length)) {
+                case BinaryCodec::TRADE: {
+                    ++stats_.trades;
+                    if (verbose_ && BinaryCodec::decodeTrade(p, length, trade_)) {
+                        std::cout << "[TRADE] " << trade_.symbol << " " << trade_.tradeId << " "
+                                  << trade_.quantity << "@" << trade_.price << "\n";
+                    }
+                    break;
+                }
+                case BinaryCodec::L2_DELTA: {
+                    ++stats_.deltas;
+                    if (verbose_ && BinaryCodec::decodeL2Delta(p, length, delta_)) {
+                        std::cout << "[L2] " << delta_.symbol << " seq=" << delta_.seq
+                                  << " changes=" << delta_.changes.size() << "\n";
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            p += length;
+        }
+    }
+
+    void requestRetransmit(uint64_t from, uint64_t to) {
+        try {
+            if (!retransmit_.is_open()) {
+                retransmit_.connect({asio::ip::make_address(retransmitHost_), config_.retransmitPort});
+            }
+            char request[12];
+            for (int i = 0; i < 8; ++i) request[i] = static_cast<char>(from >> (8 * i));
+            uint32_t count = static_cast<uint32_t>(to - from + 1);
+            for (int i = 0; i < 4; ++i) request[8 + i] = static_cast<char>(count >> (8 * i));
+            asio::write(retransmit_, asio::buffer(request));
+
+            char header[4];
+            asio::read(retransmit_, asio::buffer(header));
+            uint32_t packets = readU32(header);
+            for (uint32_t i = 0; i < packets; ++i) {
+                char length[2];
+                asio::read(retransmit_, asio::buffer(length));
+                std::string packet(readU16(length), '\0');
+                asio::read(retransmit_, asio::buffer(&packet[0], packet.size()));
+                uint64_t seq = readU64(packet.data());
+                if (seq >= expected_ && !pending_.count(seq)) {
+                    pending_.emplace(seq, std::move(packet));
+                    ++stats_.retransmitted;
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Retransmit request failed: " << e.what() << "\n";
+            retransmit_.close();
+        }
+    }
+
+    MulticastConfig config_;
+    std::string retransmitHost_;
+    int dropEvery_;
+    bool verbose_;
+    asio::ip::udp::socket socketA_;
+    asio::ip::udp::socket socketB_;
+    asio::ip::tcp::socket retransmit_;
+    std::string bufferA_;
+    std::string bufferB_;
+
+    uint64_t expected_ = 0;                       // next sequence to hand on
+    std::map<uint64_t, std::string> pending_;     // arrived ahead of expected_
+    std::chrono::steady_clock::time_point gapSince_;
+    Stats stats_;
+    TradeReport trade_;
+    L2Delta delta_;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    MulticastConfig config;
+    std::string only;
+    std::string retransmitHost = "127.0.0.1";
+    int dropEvery = 0;
+    int seconds = 0;
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--only" && i + 1 < argc) only = argv[++i];
+        else if (arg == "--drop-every" && i + 1 < argc) dropEvery = std::atoi(argv[++i]);
+        else if (arg == "--seconds" && i + 1 < argc) seconds = std::atoi(argv[++i]);
+        else if (arg == "--retransmit-host" && i + 1 < argc) retransmitHost = argv[++i];
+        else if (arg == "--retransmit-port" && i + 1 < argc) config.retransmitPort = static_cast<uint16_t>(std::atoi(argv[++i]));
+        else if (arg == "--verbose") verbose = true;
+        else {
+            std::cerr << "Usage: mcast_listener [--only A|B] [--drop-every N] [--seconds N]"
+                         " [--retransmit-host H] [--retransmit-port P] [--verbose]\n"
+                         "  --drop-every N   discard every Nth channel A packet (exercises B and TCP gap fill)\n";
+            return 2;
+        }
+    }
+
+    asio::io_context io;
+    Listener listener(io, config, only, retransmitHost, dropEvery, verbose);
+    std::cout << "Listening on A " << config.groupA << ":" << config.portA
+              << ", B " << config.groupB << ":" << config.portB << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    auto nextReport = start + std::chrono::seconds(1);
+    while (seconds == 0 || std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        io.run_for(std::chrono::milliseconds(1));
+        listener.checkGap(std::chrono::milliseconds(5));
+        if (std::chrono::steady_clock::now() >= nextReport) {
+            const Stats& s = listener.stats();
+            std::cout << "seq=" << listener.lastSeq() << " A=" << s.packets[0] << " B=" << s.packets[1]
+                      << " dup=" << s.duplicates << " gaps=" << s.gaps
+                      << " retransmitted=" << s.retransmitted << " lost=" << s.unrecoverable
+                      << " trades=" << s.trades << " deltas=" << s.deltas << std::endl;
+            nextReport += std::chrono::seconds(1);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+/* replay.cpp - deterministic journal replay + throughput benchmark */
+#include "MatchingEngine.h"
+#include "JournalSegment.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct RecordedSession {
+    std::vector<CommandRecord> commands;    // NEW / CANCEL / AMEND, in journal order
+    std::vector<std::string> trades;        // canonical TRADE records
+    uint64_t lastSeq = 0;                   // last CMD sequence number seen
+    size_t sequenceGaps = 0;
+};
+
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    std::string field;
+    std::istringstream ss(line);
+    while (std::getline(ss, field, '|')) fields.push_back(field);
+    return fields;
+}
+
+Order parseOrder(const std::vector<std::string>& f, size_t at) {
+    Order order{};
+    order.orderId = f[at];
+    order.symbol = f[at + 1];
+    order.side = (f[at + 2] == "BUY" ? Side::BUY : Side::SELL);
+    order.type = static_cast<OrderType>(std::stoi(f[at + 3]));
+    order.price = std::stod(f[at + 4]);
+    order.quantity = std::stod(f[at + 5]);
+    order.filledQty = 0.0;
+    return order;
+}
+
+void addCommand(const CommandRecord& record, RecordedSession& session) {
+    if (session.lastSeq != 0 && record.seq != session.lastSeq + 1) ++session.sequenceGaps;
+    session.lastSeq = record.seq;
+    session.commands.push_back(record);
+}
+
+// Compacted segments are decoded block by block straight into commands
+bool loadSegment(const std::string& path, RecordedSession& session) {
+    JournalSegment::Reader reader(path);
+    if (!reader.ok()) return false;
+    std::vector<CommandRecord> block;
+    for (size_t i = 0; i < reader.index().size(); ++i) {
+        if (!reader.readBlock(i, block)) {
+            std::cerr << "Corrupt block " << i << " in " << path << "\n";
+            return false;
+        }
+        for (const auto& record : block) addCommand(record, session);
+    }
+    return true;
+}
+
+// Journal line layouts (see Persistence):
+//   <ts>|NEW|orderId|symbol|side|type|price|quantity|filledQty|timestamp   (EVENTS)
+//   <ts>|CANCELED|... / <ts>|AMENDED|...  same layout, replayed as cancel /
+//   amend (CANCELED of an order that no longer rests, e.g. an IOC remainder, is a no-op)
+//   <ts>|CMD|seq|NEW|orderId|symbol|side|type|price|quantity|timestamp     (COMMANDS)
+//   <ts>|TRADE|<canonical trade fields>                                    (journal or fill log)
+bool loadJournal(const std::string& path, RecordedSession& session) {
+    if (JournalSegment::isSegmentFile(path)) return loadSegment(path, session);
+
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    size_t lineNo = 0;
+    CommandRecord record;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        auto first = line.find('|');
+        if (first == std::string::npos) continue;
+        auto second = line.find('|', first + 1);
+        std::string event = line.substr(first + 1, second - first - 1);
+
+        if (event == "TRADE") {
+            session.trades.push_back(line.substr(second + 1));
+        } else if (event == "NEW" || event == "CANCELED" || event == "AMENDED") {
+            auto f = splitFields(line);
+            if (f.size() < 10) {
+                std::cerr << "Skipping malformed " << event << " record at line " << lineNo << "\n";
+                continue;
+            }
+            CommandRecord& command = session.commands.emplace_back();
+            command.kind = event == "NEW" ? CommandRecord::Kind::NEW
+                         : event == "CANCELED" ? CommandRecord::Kind::CANCEL : CommandRecord::Kind::AMEND;
+            command.order = parseOrder(f, 2);
+            command.order.timestamp = std::stoll(f[9]);
+            if (f.size() >= 11) command.order.stopPrice = std::stod(f[10]);
+            if (f.size() >= 12) command.order.displayQty = std::stod(f[11]);
+        } else if (event == "CMD") {
+            if (!parseCommandLine(line, record)) {
+                std::cerr << "Skipping malformed CMD record at line " << lineNo << "\n";
+                continue;
+            }
+            addCommand(record, session);
+        }
+    }
+    return true;
+}
+
+double percentile(const std::vector<long long>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)] / 1000.0;  // ns -> us
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: engine_replay <journal|segment>... [--fills <fills.log>] [--no-verify]\n";
+        return 2;
+    }
+    // Several journals/segments may be given; they are replayed in argument order
+    std::vector<std::string> journalPaths;
+    std::string fillsPath;
+    bool verify = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-verify") verify = false;
+        else if (arg == "--fills" && i + 1 < argc) fillsPath = argv[++i];
+        else journalPaths.push_back(arg);
+    }
+
+    RecordedSession session;
+    size_t bytesRead = 0;
+    for (const auto& path : journalPaths) {
+        if (!loadJournal(path, session)) {
+            std::cerr << "Cannot read journal: " << path << "\n";
+            return 2;
+        }
+        std::ifstream probe(path, std::ios::binary | std::ios::ate);
+        bytesRead += static_cast<size_t>(probe.tellg());
+    }
+    // A command-sourced journal keeps its trades in the separate fill log
+    if (!fillsPath.empty() && !loadJournal(fillsPath, session)) {
+        std::cerr << "Cannot open fill log: " << fillsPath << "\n";
+        return 2;
+    }
+    std::cout << "Loaded " << session.commands.size() << " commands and "
+              << session.trades.size() << " recorded trades from "
+              << journalPaths.size() << " journal file(s), " << bytesRead << " bytes";
+    if (!session.commands.empty()) std::cout << " (" << bytesRead / session.commands.size() << " B/command)";
+    std::cout << "\n";
+    if (session.sequenceGaps > 0) {
+        std::cerr << "Warning: " << session.sequenceGaps << " command sequence gaps in journal\n";
+    }
+
+    // Persistence and console tracing off; no MarketDataServer is created
+    EngineConfig config;
+    config.journalFile.clear();
+    config.consoleLogging = false;
+    MatchingEngine engine(config);
+
+    std::vector<TradeReport> produced;
+    produced.reserve(session.trades.size());
+    engine.tradeFeed().subscribe([&](const TradeReport& trade) {
+        produced.push_back(trade);
+    });
+
+    std::vector<long long> latencies;
+    latencies.reserve(session.commands.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& command : session.commands) {
+        auto t0 = std::chrono::steady_clock::now();
+        switch (command.kind) {
+            case CommandRecord::Kind::NEW:
+                engine.submitOrder(command.order);
+                break;
+            case CommandRecord::Kind::CANCEL:
+                engine.cancelOrder(command.order.orderId);
+                break;
+            case CommandRecord::Kind::AMEND:
+                engine.amendOrder(command.order.orderId, command.order.price, command.order.quantity);
+                break;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "Replayed " << session.commands.size() << " commands, "
+              << produced.size() << " trades in " << elapsed << " s\n";
+    if (elapsed > 0) {
+        std::cout << "Throughput: " << static_cast<long long>(session.commands.size() / elapsed)
+                  << " commands/sec\n";
+    }
+    std::cout << "Latency (us): p50=" << percentile(latencies, 0.50)
+              << " p90=" << percentile(latencies, 0.90)
+              << " p99=" << percentile(latencies, 0.99)
+              << " p99.9=" << percentile(latencies, 0.999)
+              << " max=" << (latencies.empty() ? 0.0 : latencies.back() / 1000.0) << "\n";
+
+    if (!verify) return 0;
+    if (session.trades.empty() && !produced.empty()) {
+        std::cout << "No recorded TRADE records (command journal without --fills?); skipping verification\n";
+        return 0;
+    }
+
+    // Byte-for-byte comparison of the canonical trade records
+    std::ostringstream os;
+    os.precision(std::numeric_limits<double>::max_digits10);
+    size_t mismatches = 0;
+    size_t count = std::max(session.trades.size(), produced.size());
+    for (size_t i = 0; i < count; ++i) {
+        std::string actual;
+        if (i < produced.size()) {
+            os.str("");
+            Persistence::writeTradeFields(os, produced[i]);
+            actual = os.str();
+        }
+        const std::string expected = i < session.trades.size() ? session.trades[i] : "";
+        if (actual != expected) {
+            if (mismatches++ == 0) {
+                std::cerr << "First trade mismatch at #" << i << "\n"
+                          << "  recorded: " << expected << "\n"
+                          << "  replayed: " << actual << "\n";
+            }
+        }
+    }
+
+    if (mismatches > 0) {
+        std::cerr << "VERIFY FAILED: " << mismatches << " of " << count << " trades differ\n";
+        return 1;
+    }
+    std::cout << "VERIFY OK: " << produced.size() << " trades match the journal\n";
+    return 0;
+}
@@ -1,5 +1,38 @@
 #include <gtest/gtest.h>
 #include "MatchingEngine.h"
+#include "JournalSegment.h"
+#include "MarketDataSerializer.h"
+#include "BinaryCodec.h"
+#include "L2BookCache.h"
+#include "MulticastPublisher.h"
+#include "OrderGateway.h"
+#include "FixGateway.h"
+#include "OrderJsonParser.h"
+#include "Logger.h"
+#include "EngineLoop.h"
+#include "MarketDataServer.h"
+#include "ShmGateway.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// Engine for a test: no journal file, no console log
+EngineConfig quietConfig() {
+    EngineConfig config;
+    config.journalFile.clear();
+    config.consoleLogging = false;
+    return config;
+}
+
+} // namespace
 
 TEST(MatchingEngine, SimpleLimitMatch) {
     MatchingEngine me;
@@ -19,6 +52,7 @@ TEST(MatchingEngine, SimpleLimitMatch) {
         10000.0,            // price (double)
         0.0,                // stopPrice
         1.0,                // quantity
+        0.0,                // filledQty
         Order::now()        // timestamp
     };
     Order buy{
@@ -29,6 +63,7 @@ TEST(MatchingEngine, SimpleLimitMatch) {
         10000.0,
         0.0,
         1.0,
+        0.0,
         Order::now()
     };
 
@@ -43,3 +78,1598 @@ TEST(MatchingEngine, SimpleLimitMatch) {
     EXPECT_EQ       (reports[0].makerOrderId, "s1");
     EXPECT_EQ       (reports[0].takerOrderId, "b1");
 }
+
+
+TEST(JournalSegment, RoundTripPreservesCommands) {
+    std::vector<CommandRecord> records;
+    for (int i = 0; i < 10; ++i) {
+        CommandRecord r;
+        r.seq = 100 + i;
+        r.journalTs = 1700000000000LL + i;
+        r.order = Order{"o" + std::to_string(i), i % 2 ? "BTC-USDT" : "ETH-USDT",
+                        i % 3 ? Side::BUY : Side::SELL, OrderType::LIMIT,
+                        100.25 + i, 0.0, 0.1 * (i + 1), 0.0, r.journalTs};
+        records.push_back(r);
+    }
+    records[4].order.orderId = "custom-id";   // non-numeric id takes the literal path
+    records[2].order.type = OrderType::STOP_LIMIT;   // carries a stop price
+    records[2].order.stopPrice = 99.5;
+    records[5].order.displayQty = 0.05;              // iceberg
+    records[7].kind = CommandRecord::Kind::CANCEL;
+
+    const std::string path = "roundtrip_test.seg";
+    ASSERT_GT(JournalSegment::encode(records, path, 4), 0u);
+
+    JournalSegment::Reader reader(path);
+    ASSERT_TRUE(reader.ok());
+    EXPECT_EQ(reader.index().size(), 3u);
+    EXPECT_EQ(reader.findBlock(105), 1u);
+
+    std::vector<CommandRecord> decoded;
+    ASSERT_TRUE(reader.readAll(decoded));
+    ASSERT_EQ(decoded.size(), records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(decoded[i].seq, records[i].seq);
+        EXPECT_EQ(decoded[i].kind, records[i].kind);
+        EXPECT_EQ(decoded[i].order.orderId, records[i].order.orderId);
+        if (records[i].kind == CommandRecord::Kind::NEW) {
+            EXPECT_EQ(decoded[i].order.symbol, records[i].order.symbol);
+            EXPECT_EQ(decoded[i].order.side, records[i].order.side);
+            EXPECT_EQ(decoded[i].order.type, records[i].order.type);
+            EXPECT_EQ(decoded[i].order.price, records[i].order.price);       // bit-exact
+            EXPECT_EQ(decoded[i].order.stopPrice, records[i].order.stopPrice);
+            EXPECT_EQ(decoded[i].order.displayQty, records[i].order.displayQty);
+            EXPECT_EQ(decoded[i].order.quantity, records[i].order.quantity);
+            EXPECT_EQ(decoded[i].order.timestamp, records[i].order.timestamp);
+        }
+    }
+
+    // Corrupt copies are refused instead of decoded from garbage
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto writeCopy = [&](const std::string& data) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << data;
+    };
+    // Index entries: u64 offset, u64 firstSeq, i64 firstTs, u32 recordCount;
+    // footer: u32 blockCount, u64 indexOffset, magic
+    uint64_t indexOffset;
+    std::memcpy(&indexOffset, bytes.data() + bytes.size() - 12, sizeof(indexOffset));
+    std::string badCount = bytes;
+    badCount[indexOffset + 24] = static_cast<char>(100);   // block 0 claims 100 records
+    writeCopy(badCount);
+    {
+        JournalSegment::Reader bad(path);
+        ASSERT_TRUE(bad.ok());
+        EXPECT_FALSE(bad.readBlock(0, decoded));
+        EXPECT_TRUE(bad.readBlock(1, decoded));
+    }
+    writeCopy(bytes.substr(0, bytes.size() - 5));          // footer cut short
+    EXPECT_FALSE(JournalSegment::Reader(path).ok());
+    std::string badOffset = bytes;
+    badOffset[indexOffset] = 1;                              // block 0 starts inside the header
+    writeCopy(badOffset);
+    EXPECT_FALSE(JournalSegment::Reader(path).ok());
+    std::remove(path.c_str());
+}
+
+TEST(JournalSegment, CommandJournalReplaysToIdenticalTrades) {
+    const std::string journal = "cmd_replay_test.log";
+    const std::string fills = "cmd_replay_test.fills";
+    std::remove(journal.c_str());
+    std::remove(fills.c_str());
+    {
+        EngineConfig config = quietConfig();
+        config.journalFile = journal;
+        config.journalMode = JournalMode::COMMANDS;
+        config.fillLogFile = fills;
+        MatchingEngine me(config);
+        auto order = [](const std::string& id, Side side, OrderType type, double price, double quantity) {
+            return Order{id, "BTC-USDT", side, type, price, 0.0, quantity, 0.0, Order::now()};
+        };
+        me.submitOrder(order("s1", Side::SELL, OrderType::LIMIT, 101.0, 1.0));
+        me.submitOrder(order("s2", Side::SELL, OrderType::LIMIT, 102.5, 2.0));
+        Order iceberg = order("s3", Side::SELL, OrderType::LIMIT, 103.0, 3.0);
+        iceberg.displayQty = 0.5;
+        me.submitOrder(iceberg);
+        Order stop = order("st1", Side::BUY, OrderType::STOP_LOSS, 0.0, 1.5);
+        stop.stopPrice = 102.0;
+        me.submitOrder(stop);
+        me.submitOrder(order("b1", Side::BUY, OrderType::LIMIT, 99.0, 1.0));
+        me.submitOrder(order("t1", Side::BUY, OrderType::IOC, 101.0, 0.4));
+        me.amendOrder("b1", 101.0, 0.0);          // crosses s1's remainder
+        me.cancelOrder("s2");
+        me.submitOrder(order("t2", Side::BUY, OrderType::MARKET, 0.0, 1.0));
+    }
+
+    // Replay the commands through a fresh engine, as engine_replay does
+    std::vector<CommandRecord> commands;
+    {
+        std::ifstream in(journal);
+        std::string line;
+        CommandRecord record;
+        while (std::getline(in, line)) {
+            ASSERT_TRUE(parseCommandLine(line, record)) << line;
+            commands.push_back(record);
+        }
+    }
+    ASSERT_EQ(commands.size(), 9u);
+
+    MatchingEngine replay(quietConfig());
+    std::vector<std::string> replayed;
+    replay.tradeFeed().subscribe([&](const TradeReport& trade) {
+        std::ostringstream os;
+        os.precision(std::numeric_limits<double>::max_digits10);
+        Persistence::writeTradeFields(os, trade);
+        replayed.push_back(os.str());
+    });
+    for (const auto& command : commands) {
+        switch (command.kind) {
+            case CommandRecord::Kind::NEW: replay.submitOrder(command.order); break;
+            case CommandRecord::Kind::CANCEL: replay.cancelOrder(command.order.orderId); break;
+            case CommandRecord::Kind::AMEND:
+                replay.amendOrder(command.order.orderId, command.order.price, command.order.quantity);
+                break;
+        }
+    }
+
+    // The fill log's canonical records, byte for byte
+    std::vector<std::string> recorded;
+    {
+        std::ifstream in(fills);
+        std::string line;
+        while (std::getline(in, line)) {
+            size_t second = line.find('|', line.find('|') + 1);
+            ASSERT_NE(second, std::string::npos);
+            recorded.push_back(line.substr(second + 1));
+        }
+    }
+    EXPECT_GE(recorded.size(), 5u);
+    EXPECT_EQ(replayed, recorded);
+    std::remove(journal.c_str());
+    std::remove(fills.c_str());
+}
+
+TEST(MatchingEngine, L2DeltaReportsOnlyChangedLevels) {
+    MatchingEngine me(quietConfig());
+    std::vector<L2Delta> deltas;
+    me.l2DeltaFeed().subscribe([&](const L2Delta& d) { deltas.push_back(d); });
+
+    me.submitOrder(Order{"s1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, Order::now()});
+    me.submitOrder(Order{"s2", "BTC-USDT", Side::SELL, OrderType::LIMIT, 102.0, 0.0, 2.0, 0.0, Order::now()});
+    me.submitOrder(Order{"b1", "BTC-USDT", Side::BUY, OrderType::MARKET, 0.0, 0.0, 1.5, 0.0, Order::now()});
+
+    ASSERT_EQ(deltas.size(), 3u);
+    for (size_t i = 0; i < deltas.size(); ++i) EXPECT_EQ(deltas[i].seq, i + 1);
+
+    // The sweep removes 101 and leaves 1.5 at 102
+    ASSERT_EQ(deltas[2].changes.size(), 2u);
+    EXPECT_DOUBLE_EQ(deltas[2].changes[0].price, 101.0);
+    EXPECT_DOUBLE_EQ(deltas[2].changes[0].quantity, 0.0);
+    EXPECT_DOUBLE_EQ(deltas[2].changes[1].price, 102.0);
+    EXPECT_DOUBLE_EQ(deltas[2].changes[1].quantity, 1.5);
+}
+
+TEST(MarketDataSerializer, TradeMatchesDomSchema) {
+    TradeReport trade("BTC-USDT", "T7", 46000.5, 0.25, 11.5, 23.0, "BUY",
+                      "maker\"1", "taker-1", 1700000000123LL);
+    std::string out;
+    MarketDataSerializer::appendTrade(out, trade);
+
+    auto parsed = nlohmann::json::parse(out);
+    auto dom = trade.toJson();
+    ASSERT_EQ(parsed.size(), dom.size());
+    for (auto it = dom.begin(); it != dom.end(); ++it) {
+        ASSERT_TRUE(parsed.contains(it.key())) << it.key();
+        ASSERT_TRUE(parsed[it.key()].is_string()) << it.key();
+    }
+    EXPECT_EQ(parsed["maker_order_id"], "maker\"1");
+    EXPECT_EQ(parsed["price"], "46000.5");
+    EXPECT_EQ(parsed["timestamp"], "1700000000123");
+
+    // Shortest round-trip keeps values std::to_string would round to zero
+    trade.quantity = 1.5e-9;
+    out.clear();
+    MarketDataSerializer::appendTrade(out, trade);
+    EXPECT_EQ(std::stod(nlohmann::json::parse(out)["quantity"].get<std::string>()), 1.5e-9);
+}
+
+TEST(BinaryCodec, RoundTripsTradeAndDelta) {
+    TradeReport trade("BTC-USDT", "T7", 46000.5, 1.5e-9, 11.5, 23.0, "SELL",
+                      "maker-1", "taker-1", 1700000000123LL);
+    std::string out;
+    BinaryCodec::encodeTrade(out, trade);
+    EXPECT_EQ(BinaryCodec::templateId(out.data(), out.size()), BinaryCodec::TRADE);
+
+    TradeReport decoded;
+    ASSERT_TRUE(BinaryCodec::decodeTrade(out.data(), out.size(), decoded));
+    EXPECT_EQ(decoded.symbol, "BTC-USDT");
+    EXPECT_EQ(decoded.tradeId, "T7");
+    EXPECT_EQ(decoded.quantity, 1.5e-9);
+    EXPECT_EQ(decoded.aggressor, "SELL");
+    EXPECT_EQ(decoded.takerOrderId, "taker-1");
+    EXPECT_EQ(decoded.timestamp, 1700000000123LL);
+    EXPECT_FALSE(BinaryCodec::decodeTrade(out.data(), out.size() - 1, decoded));
+
+    std::vector<L2Level> changes{{Side::BUY, 100.0, 2.0}, {Side::SELL, 101.5, 0.0}};
+    out.clear();
+    BinaryCodec::encodeL2Delta(out, "ETH-USDT", 5, 9, 1700000000456LL, changes);
+    L2Delta delta;
+    uint64_t firstSeq = 0;
+    ASSERT_TRUE(BinaryCodec::decodeL2Delta(out.data(), out.size(), delta, &firstSeq));
+    EXPECT_EQ(delta.symbol, "ETH-USDT");
+    EXPECT_EQ(firstSeq, 5u);
+    EXPECT_EQ(delta.seq, 9u);
+    ASSERT_EQ(delta.changes.size(), 2u);
+    EXPECT_EQ(delta.changes[1].side, Side::SELL);
+    EXPECT_DOUBLE_EQ(delta.changes[1].price, 101.5);
+    EXPECT_DOUBLE_EQ(delta.changes[0].quantity, 2.0);
+}
+
+TEST(MatchingEngine, L3FeedReportsEachOrderEvent) {
+    MatchingEngine me(quietConfig());
+
+    std::vector<L3Event> events;
+    me.l3Feed().subscribe([&](const L3Event& e) { events.push_back(e); });
+
+    me.submitOrder(Order{"s1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, Order::now()});
+    me.submitOrder(Order{"s2", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 2.0, 0.0, Order::now()});
+    me.submitOrder(Order{"b1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 101.0, 0.0, 1.5, 0.0, Order::now()});
+
+    ASSERT_EQ(events.size(), 4u);
+    for (size_t i = 0; i < events.size(); ++i) EXPECT_EQ(events[i].seq, i + 1);
+    EXPECT_EQ(events[0].type, L3Event::Type::ADD);
+    EXPECT_EQ(events[1].orderId, "s2");
+
+    // s1 is consumed completely, s2 keeps its queue position with 1.5 left
+    EXPECT_EQ(events[2].type, L3Event::Type::EXECUTE);
+    EXPECT_EQ(events[2].orderId, "s1");
+    EXPECT_DOUBLE_EQ(events[2].quantity, 0.0);
+    EXPECT_EQ(events[3].orderId, "s2");
+    EXPECT_DOUBLE_EQ(events[3].execQty, 0.5);
+    EXPECT_DOUBLE_EQ(events[3].quantity, 1.5);
+    EXPECT_EQ(events[3].tradeId, "T2");
+}
+
+TEST(MatchingEngine, ExecutionFeedBatchesFillsPerTaker) {
+    MatchingEngine me(quietConfig());
+
+    std::vector<ExecutionBatch> batches;
+    me.executionFeed().subscribe([&](const ExecutionBatch& b) { batches.push_back(b); });
+
+    for (int i = 0; i < 5; ++i) {
+        me.submitOrder(Order{"s" + std::to_string(i), "BTC-USDT", Side::SELL, OrderType::LIMIT,
+                             100.0 + i, 0.0, 1.0, 0.0, Order::now()});
+    }
+    EXPECT_TRUE(batches.empty());
+    me.submitOrder(Order{"b1", "BTC-USDT", Side::BUY, OrderType::MARKET, 0.0, 0.0, 4.5, 0.0, Order::now()});
+
+    ASSERT_EQ(batches.size(), 1u);
+    const ExecutionBatch& batch = batches[0];
+    EXPECT_EQ(batch.takerOrderId, "b1");
+    EXPECT_EQ(batch.aggressor, "BUY");
+    ASSERT_EQ(batch.fills.size(), 5u);
+    EXPECT_EQ(batch.fills[0].makerOrderId, "s0");
+    EXPECT_DOUBLE_EQ(batch.fills[4].price, 104.0);
+    EXPECT_DOUBLE_EQ(batch.fills[4].quantity, 0.5);
+
+    std::string out;
+    MarketDataSerializer::appendExecutionBatch(out, batch);
+    auto parsed = nlohmann::json::parse(out);
+    EXPECT_EQ(parsed["type"], "trades");
+    ASSERT_EQ(parsed["fills"].size(), 5u);
+    EXPECT_EQ(parsed["fills"][2], nlohmann::json::parse([&] {
+        std::string fill;
+        MarketDataSerializer::appendTrade(fill, batch.fills[2]);
+        return fill;
+    }()));
+
+    out.clear();
+    BinaryCodec::encodeExecutionBatch(out, batch);
+    ExecutionBatch decoded;
+    ASSERT_TRUE(BinaryCodec::decodeExecutionBatch(out.data(), out.size(), decoded));
+    ASSERT_EQ(decoded.fills.size(), 5u);
+    EXPECT_EQ(decoded.fills[3].tradeId, batch.fills[3].tradeId);
+    EXPECT_EQ(decoded.fills[3].takerOrderId, "b1");
+    EXPECT_EQ(decoded.fills[3].symbol, "BTC-USDT");
+    EXPECT_DOUBLE_EQ(decoded.fills[3].makerFee, batch.fills[3].makerFee);
+    EXPECT_FALSE(BinaryCodec::decodeExecutionBatch(out.data(), out.size() - 1, decoded));
+}
+
+TEST(MatchingEngine, CancelAndAmendRestingOrders) {
+    MatchingEngine me(quietConfig());
+
+    std::vector<L3Event> events;
+    me.l3Feed().subscribe([&](const L3Event& e) { events.push_back(e); });
+
+    me.submitOrder(Order{"s1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 2.0, 0.0, Order::now()});
+    me.submitOrder(Order{"s2", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, Order::now()});
+    me.submitOrder(Order{"s3", "BTC-USDT", Side::SELL, OrderType::LIMIT, 102.0, 0.0, 1.0, 0.0, Order::now()});
+
+    // Size down keeps s1 ahead of s2
+    auto amended = me.amendOrder("s1", 0.0, 1.5);
+    EXPECT_EQ(amended.result, OrderResult::ACCEPTED);
+    EXPECT_EQ(events.back().type, L3Event::Type::REDUCE);
+    EXPECT_DOUBLE_EQ(events.back().quantity, 1.5);
+
+    // Size up loses priority: s2 now trades first
+    me.amendOrder("s1", 0.0, 3.0);
+    auto fill = me.submitOrder(Order{"b1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, Order::now()});
+    ASSERT_EQ(fill.trades.size(), 1u);
+    EXPECT_EQ(fill.trades[0].makerOrderId, "s2");
+
+    // Re-price to another level, then cancel it
+    EXPECT_EQ(me.amendOrder("s3", 103.0, 0.0).result, OrderResult::ACCEPTED);
+    auto book = me.getL2Update("BTC-USDT");
+    ASSERT_EQ(book.asks.size(), 2u);
+    EXPECT_DOUBLE_EQ(book.asks[1].first, 103.0);
+    EXPECT_TRUE(me.cancelOrder("s3"));
+    EXPECT_EQ(events.back().type, L3Event::Type::DELETE);
+    EXPECT_FALSE(me.cancelOrder("s3"));
+    EXPECT_FALSE(me.cancelOrder("b1"));   // filled, never rested
+    EXPECT_EQ(me.amendOrder("nope", 1.0, 1.0).result, OrderResult::REJECTED_UNKNOWN_ORDER);
+    EXPECT_EQ(me.amendOrder("s1", 0.0, 0.5).result, OrderResult::ACCEPTED);
+    EXPECT_EQ(me.getL2Update("BTC-USDT").asks.size(), 1u);
+}
+
+TEST(MatchingEngine, MassCancelByOwnerSymbolAndSide) {
+    MatchingEngine me(quietConfig());
+
+    std::map<std::string, int> deltas;
+    me.l2DeltaFeed().subscribe([&](const L2Delta& d) { ++deltas[d.symbol]; });
+
+    auto rest = [&](const std::string& id, const std::string& symbol, Side side, double price,
+                    const std::string& owner) {
+        Order order{id, symbol, side, OrderType::LIMIT, price, 0.0, 1.0, 0.0, Order::now()};
+        order.owner = owner;
+        return me.submitOrder(order);
+    };
+    rest("a1", "BTC-USDT", Side::SELL, 101.0, "mm-a");
+    rest("a2", "BTC-USDT", Side::SELL, 102.0, "mm-a");
+    rest("a3", "BTC-USDT", Side::BUY, 99.0, "mm-a");
+    rest("a4", "ETH-USDT", Side::SELL, 11.0, "mm-a");
+    rest("a5", "ETH-USDT", Side::BUY, 9.0, "mm-a");
+    rest("b1", "BTC-USDT", Side::SELL, 101.0, "mm-b");
+
+    // a1 fills and leaves the owner's list; b1 is someone else's
+    rest("t1", "BTC-USDT", Side::BUY, 101.0, "taker");
+    deltas.clear();
+
+    auto canceled = me.massCancel(MassCancelRequest{"mm-a", "BTC-USDT", false, Side::SELL});
+    EXPECT_EQ(canceled, std::vector<std::string>({"a2"}));
+    EXPECT_EQ(deltas["BTC-USDT"], 1);
+
+    // Everything else of mm-a: two books, one delta each
+    deltas.clear();
+    canceled = me.massCancel(MassCancelRequest{"mm-a"});
+    EXPECT_EQ(canceled, std::vector<std::string>({"a3", "a4", "a5"}));
+    EXPECT_EQ(deltas["BTC-USDT"], 1);
+    EXPECT_EQ(deltas["ETH-USDT"], 1);
+    EXPECT_TRUE(me.getL2Update("ETH-USDT").bids.empty());
+    auto book = me.getL2Update("BTC-USDT");
+    EXPECT_TRUE(book.bids.empty());
+    ASSERT_EQ(book.asks.size(), 1u);   // b1 only
+    EXPECT_TRUE(me.massCancel(MassCancelRequest{"mm-a"}).empty());
+    EXPECT_FALSE(me.cancelOrder("a4"));
+}
+
+TEST(MatchingEngine, StopOrdersTriggerAndCascade) {
+    MatchingEngine me(quietConfig());
+
+    std::vector<TradeReport> trades;
+    me.tradeFeed().subscribe([&](const TradeReport& t) { trades.push_back(t); });
+    std::vector<TriggeredOrder> triggered;
+    me.triggerFeed().subscribe([&](const TriggeredOrder& t) { triggered.push_back(t); });
+
+    auto submit = [&](const std::string& id, Side side, OrderType type, double price, double stopPrice,
+                      double quantity, const std::string& owner = "") {
+        Order order{id, "BTC-USDT", side, type, price, stopPrice, quantity, 0.0, Order::now()};
+        order.owner = owner;
+        return me.submitOrder(order);
+    };
+    submit("s1", Side::SELL, OrderType::LIMIT, 100.0, 0.0, 1.0);
+    submit("s2", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 1.0);
+    submit("s3", Side::SELL, OrderType::LIMIT, 102.0, 0.0, 1.0);
+    submit("s4", Side::SELL, OrderType::LIMIT, 103.0, 0.0, 1.0);
+    submit("b1", Side::BUY, OrderType::LIMIT, 95.0, 0.0, 1.0);
+
+    EXPECT_EQ(submit("x1", Side::BUY, OrderType::STOP_LOSS, 0.0, 0.0, 1.0).result,
+              OrderResult::REJECTED_INVALID_PARAMS);
+
+    // No trade yet: everything waits, whichever way it triggers
+    EXPECT_EQ(submit("st2", Side::BUY, OrderType::STOP_LOSS, 0.0, 101.0, 1.0).result, OrderResult::ACCEPTED);
+    EXPECT_EQ(submit("st1", Side::BUY, OrderType::STOP_LOSS, 0.0, 100.0, 1.0).result, OrderResult::ACCEPTED);
+    EXPECT_EQ(submit("tp1", Side::SELL, OrderType::TAKE_PROFIT, 0.0, 102.0, 0.5).result, OrderResult::ACCEPTED);
+    EXPECT_EQ(submit("ss1", Side::SELL, OrderType::STOP_LOSS, 0.0, 90.0, 1.0, "mm").result, OrderResult::ACCEPTED);
+    EXPECT_EQ(submit("ss2", Side::SELL, OrderType::STOP_LOSS, 0.0, 94.0, 1.0).result, OrderResult::ACCEPTED);
+    EXPECT_TRUE(trades.empty());
+
+    // 100 fires st1, whose fill at 101 fires st2, whose fill at 102 fires tp1
+    // into the bid at 95; the sell stops at 94 and 90 stay put
+    auto response = submit("t1", Side::BUY, OrderType::LIMIT, 100.0, 0.0, 1.0);
+    EXPECT_EQ(response.trades.size(), 1u);
+    ASSERT_EQ(trades.size(), 4u);
+    std::vector<std::pair<std::string, double>> fired;
+    for (const auto& t : trades) fired.emplace_back(t.takerOrderId, t.price);
+    EXPECT_EQ(fired, (std::vector<std::pair<std::string, double>>{
+                         {"t1", 100.0}, {"st1", 101.0}, {"st2", 102.0}, {"tp1", 95.0}}));
+    EXPECT_DOUBLE_EQ(trades[3].quantity, 0.5);
+    ASSERT_EQ(triggered.size(), 3u);
+    for (const auto& t : triggered) {
+        EXPECT_EQ(t.result, OrderResult::COMPLETELY_FILLED);
+        EXPECT_FALSE(t.resting);
+    }
+    EXPECT_EQ(triggered[2].orderId, "tp1");
+    EXPECT_DOUBLE_EQ(triggered[2].filledQuantity, 0.5);
+
+    // Already triggered by the last trade (95): fires on entry, as a limit at 103
+    response = submit("sl1", Side::BUY, OrderType::STOP_LIMIT, 103.0, 95.0, 1.0);
+    EXPECT_EQ(response.result, OrderResult::COMPLETELY_FILLED);
+    ASSERT_EQ(response.trades.size(), 1u);
+    EXPECT_EQ(response.trades[0].makerOrderId, "s4");
+
+    // Pending orders cancel like resting ones, by id or by owner
+    EXPECT_TRUE(me.cancelOrder("ss2"));
+    EXPECT_FALSE(me.cancelOrder("ss2"));
+    EXPECT_FALSE(me.cancelOrder("st1"));
+    EXPECT_EQ(me.massCancel(MassCancelRequest{"mm"}), std::vector<std::string>({"ss1"}));
+
+    // Nothing left to fire: the rest of the bid trades alone
+    trades.clear();
+    submit("t2", Side::SELL, OrderType::MARKET, 0.0, 0.0, 0.5);
+    ASSERT_EQ(trades.size(), 1u);
+    EXPECT_TRUE(me.getL2Update("BTC-USDT").bids.empty());
+}
+
+TEST(MatchingEngine, IcebergShowsOneSliceAndRequeuesIt) {
+    MatchingEngine me(quietConfig());
+
+    std::vector<L2Delta> deltas;
+    me.l2DeltaFeed().subscribe([&](const L2Delta& d) { deltas.push_back(d); });
+    auto submit = [&](const std::string& id, Side side, OrderType type, double quantity, double display = 0.0) {
+        Order order{id, "BTC-USDT", side, type, 100.0, 0.0, quantity, 0.0, Order::now()};
+        order.displayQty = display;
+        return me.submitOrder(order);
+    };
+    auto shown = [&] {
+        auto asks = me.getL2Update("BTC-USDT").asks;
+        return asks.empty() ? 0.0 : asks[0].second;
+    };
+
+    EXPECT_EQ(submit("x1", Side::SELL, OrderType::MARKET, 10.0, 2.0).result, OrderResult::REJECTED_INVALID_PARAMS);
+    EXPECT_EQ(submit("ice", Side::SELL, OrderType::LIMIT, 10.0, 2.0).result, OrderResult::ACCEPTED);
+    submit("s2", Side::SELL, OrderType::LIMIT, 1.0);
+    EXPECT_DOUBLE_EQ(shown(), 3.0);   // slice of 2 plus s2; 8 hidden
+    EXPECT_DOUBLE_EQ(deltas.back().changes[0].quantity, 3.0);
+
+    // The slice trades away and re-queues behind s2
+    auto response = submit("b1", Side::BUY, OrderType::LIMIT, 3.0);
+    ASSERT_EQ(response.trades.size(), 2u);
+    EXPECT_EQ(response.trades[0].makerOrderId, "ice");
+    EXPECT_DOUBLE_EQ(response.trades[0].quantity, 2.0);
+    EXPECT_EQ(response.trades[1].makerOrderId, "s2");
+    EXPECT_DOUBLE_EQ(shown(), 2.0);
+    EXPECT_DOUBLE_EQ(deltas.back().changes[0].quantity, 2.0);
+
+    // Alone at the level, it keeps refilling within one taker: 2 + 2 + 1
+    response = submit("b2", Side::BUY, OrderType::LIMIT, 5.0);
+    ASSERT_EQ(response.trades.size(), 3u);
+    EXPECT_DOUBLE_EQ(response.trades[2].quantity, 1.0);
+    EXPECT_DOUBLE_EQ(shown(), 1.0);
+
+    // A refill loses time priority to orders already queued
+    submit("s3", Side::SELL, OrderType::LIMIT, 1.0);
+    response = submit("b3", Side::BUY, OrderType::LIMIT, 2.0);
+    ASSERT_EQ(response.trades.size(), 2u);
+    EXPECT_EQ(response.trades[0].makerOrderId, "ice");
+    EXPECT_EQ(response.trades[1].makerOrderId, "s3");
+    EXPECT_DOUBLE_EQ(shown(), 2.0);   // the last 2, shown as one slice
+
+    EXPECT_TRUE(me.cancelOrder("ice"));
+    EXPECT_TRUE(me.getL2Update("BTC-USDT").asks.empty());
+}
+
+TEST(EngineLoop, RunsCommandsInOrderAndBoundsTheQueue) {
+    MatchingEngine me(quietConfig());
+    EngineLoop loop(me, 2);
+
+    // The first continuation holds the loop thread, so later posts queue up
+    std::promise<void> entered;
+    std::promise<void> release;
+    std::vector<std::string> done;   // written on the loop thread only
+    ASSERT_TRUE(loop.submit(Order{"s1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 100.0, 0.0, 1.0, 0.0, Order::now()},
+                            [&](const OrderResponse& r) {
+                                entered.set_value();
+                                release.get_future().wait();
+                                done.push_back(r.result == OrderResult::ACCEPTED ? "s1 rested" : "s1 ?");
+                            }));
+    entered.get_future().wait();
+
+    ASSERT_TRUE(loop.submit(Order{"b1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 100.0, 0.0, 1.0, 0.0, Order::now()},
+                            [&](const OrderResponse& r) {
+                                done.push_back(r.result == OrderResult::COMPLETELY_FILLED ? "b1 filled" : "b1 ?");
+                            }));
+    std::promise<bool> canceled;
+    ASSERT_TRUE(loop.cancel("s1", [&](bool ok) { canceled.set_value(ok); }));
+    EXPECT_EQ(loop.pending(), 2u);
+    EXPECT_FALSE(loop.amend("s1", 0.0, 2.0, [](const OrderResponse&) { FAIL() << "rejected post ran"; }));
+    EXPECT_EQ(loop.rejected(), 1u);
+
+    release.set_value();
+    EXPECT_FALSE(canceled.get_future().get());   // s1 was filled by b1 before the cancel ran
+    EXPECT_EQ(done, (std::vector<std::string>{"s1 rested", "b1 filled"}));
+    EXPECT_EQ(loop.pending(), 0u);
+}
+
+TEST(OrderJsonParser, ParsesSchemaAndReportsErrorOffsets) {
+    OrderJsonParser parser;
+    Order order{};
+    OrderParseError error;
+    ASSERT_TRUE(parser.parse(R"( {"order_id":"o\u00e91","symbol":"BTC-USDT","side":"sell","order_type":"ioc",
+                                 "quantity":1.5e-3,"price":46000.25,"client":{"tags":[1,"x",null]}} )",
+                             order, error)) << error.message;
+    EXPECT_EQ(order.orderId, "o\xc3\xa9" "1");
+    EXPECT_EQ(order.symbol, "BTC-USDT");
+    EXPECT_EQ(order.side, Side::SELL);
+    EXPECT_EQ(order.type, OrderType::IOC);
+    EXPECT_DOUBLE_EQ(order.quantity, 0.0015);
+    EXPECT_DOUBLE_EQ(order.price, 46000.25);
+
+    // price is optional
+    ASSERT_TRUE(parser.parse(R"({"order_id":"m1","symbol":"BTC-USDT","side":"buy","order_type":"market","quantity":2})",
+                             order, error));
+    EXPECT_EQ(order.type, OrderType::MARKET);
+    EXPECT_DOUBLE_EQ(order.price, 0.0);
+
+    auto failsAt = [&](const std::string& body, size_t offset, const char* message) {
+        EXPECT_FALSE(parser.parse(body, order, error)) << body;
+        EXPECT_EQ(error.offset, offset) << body;
+        EXPECT_STREQ(error.message, message) << body;
+    };
+    failsAt(R"({"order_id":"a","symbol":"X","side":"hold","order_type":"limit","quantity":1})", 36,
+            "\"side\" must be \"buy\" or \"sell\"");
+    failsAt(R"({"order_id":"a","symbol":"X","side":"buy","order_type":"limit","quantity":"1"})", 74,
+            "\"quantity\" must be a number");
+    failsAt(R"({"order_id":"a","symbol":"X","side":"buy","order_type":"limit","quantity":01})", 75,
+            "expected ',' or '}'");
+    failsAt(R"({"order_id":"a","symbol":"X","side":"buy","order_type":"limit"})", 62, "missing \"quantity\"");
+    failsAt(R"({"order_id":"a" "symbol":"X"})", 16, "expected ',' or '}'");
+    failsAt(R"({"order_id":"a","symbol":"X","side":"buy","order_type":"limit","quantity":1} x)", 77,
+            "unexpected data after the order object");
+}
+
+TEST(Logger, FormatsRecordsAndDecodesBinaryFile) {
+    const std::string textPath = "logger_test.log";
+    const std::string binaryPath = "logger_test.bin";
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+    LogConfig config;
+    config.console = false;
+    config.textFile = textPath;
+    config.binaryFile = binaryPath;
+    Log::configure(config);
+
+    LOG_DEBUG("below the run-time level {}", 1);
+    const int infoLine = __LINE__ + 1;
+    LOG_INFO("order {} {} {}@{} ioc={}", std::string("o-1"), Side::SELL, 0.5, 101.25, true);
+    Log::flush();
+    std::thread other([] { LOG_WARN("from the {} thread: {} {}", "other", 'x', uint64_t{18446744073709551615ull}); });
+    other.join();
+    Log::flush();
+    const int errorLine = __LINE__ + 1;
+    LOG_ERROR("no placeholder", -7);
+    Log::flush();
+    EXPECT_EQ(Log::dropped(), 0u);
+    Log::configure(LogConfig{});   // closes the files
+
+    // The backend's text and the decoded binary file are the same lines
+    std::ifstream in(textPath);
+    std::stringstream text;
+    text << in.rdbuf();
+    std::ostringstream decoded;
+    std::string error;
+    ASSERT_TRUE(Log::decodeFile(binaryPath, decoded, error)) << error;
+    EXPECT_EQ(decoded.str(), text.str());
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(text, line)) lines.push_back(line.substr(27));   // after "YYYY-MM-DD HH:MM:SS.uuuuuu "
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "INFO  [MatchingTests.cpp:" + std::to_string(infoLine) + "] order o-1 1 0.5@101.25 ioc=true");
+    EXPECT_EQ(lines[1].substr(0, 7), "WARN  [");
+    EXPECT_EQ(lines[1].substr(lines[1].find(']')), "] from the other thread: x 18446744073709551615");
+    EXPECT_EQ(lines[2], "ERROR [MatchingTests.cpp:" + std::to_string(errorLine) + "] no placeholder -7");
+
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+}
+
+TEST(L2BookCache, TracksEngineBookFromDeltas) {
+    MatchingEngine me(quietConfig());
+
+    L2BookCache cache;
+    bool inSync = true;
+    me.l2DeltaFeed().subscribe([&](const L2Delta& d) { inSync = inSync && cache.apply(d); });
+
+    me.submitOrder(Order{"s1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, Order::now()});
+    me.submitOrder(Order{"s2", "BTC-USDT", Side::SELL, OrderType::LIMIT, 102.0, 0.0, 2.0, 0.0, Order::now()});
+    me.submitOrder(Order{"b1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 99.0, 0.0, 3.0, 0.0, Order::now()});
+    me.submitOrder(Order{"b2", "BTC-USDT", Side::BUY, OrderType::MARKET, 0.0, 0.0, 1.5, 0.0, Order::now()});
+    ASSERT_TRUE(inSync);
+
+    L2Update cached;
+    cache.snapshot("BTC-USDT", cached);
+    L2Update live = me.getL2Update("BTC-USDT");
+    EXPECT_EQ(cached.seq, live.seq);
+    EXPECT_EQ(cached.bids, live.bids);
+    EXPECT_EQ(cached.asks, live.asks);
+
+    // A delta that skips a sequence is refused
+    L2Delta skipped{"BTC-USDT", cache.seq() + 2, Order::now(), {}};
+    EXPECT_FALSE(cache.apply(skipped));
+}
+
+TEST(MulticastPublisher, SendsSequencedPacketsAndRetransmits) {
+    MatchingEngine me(quietConfig());
+
+    MulticastConfig mcast;
+    mcast.portA = 31001;
+    mcast.portB = 31002;
+    mcast.retransmitPort = 0;
+    mcast.ringPackets = 4;
+    MulticastPublisher publisher(me, mcast);
+
+    asio::io_context io;
+    asio::ip::udp::socket listener(io);
+    asio::ip::udp::endpoint listen(asio::ip::address_v4::any(), mcast.portA);
+    listener.open(listen.protocol());
+    listener.set_option(asio::ip::udp::socket::reuse_address(true));
+    listener.bind(listen);
+    asio::error_code ec;
+    listener.set_option(asio::ip::multicast::join_group(
+        asio::ip::make_address_v4(mcast.groupA), asio::ip::make_address_v4(mcast.interfaceA)), ec);
+    if (ec) GTEST_SKIP() << "multicast unavailable: " << ec.message();
+
+    me.submitOrder(Order{"s1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, Order::now()});
+    me.submitOrder(Order{"b1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, Order::now()});
+    ASSERT_EQ(publisher.lastSeq(), 3u);   // delta (rest), trade, delta (fill)
+
+    // Channel A delivers every packet in sequence
+    char packet[2048];
+    for (uint64_t expected = 1; expected <= 3; ++expected) {
+        size_t size = listener.receive(asio::buffer(packet));
+        ASSERT_GE(size, MulticastPublisher::kPacketHeaderSize);
+        uint64_t seq = 0;
+        std::memcpy(&seq, packet, sizeof(seq));
+        EXPECT_EQ(seq, expected);
+        EXPECT_EQ(BinaryCodec::templateId(packet + 12, size - 12),
+                  expected == 2 ? BinaryCodec::TRADE : BinaryCodec::L2_DELTA);
+    }
+
+    // Retransmission replays the requested range from the ring
+    asio::ip::tcp::socket client(io);
+    client.connect({asio::ip::make_address("127.0.0.1"), publisher.retransmitPort()});
+    char request[12] = {};
+    request[0] = 2;   // fromSeq 2
+    request[8] = 5;   // count 5 (only 2..3 exist)
+    asio::write(client, asio::buffer(request));
+    uint32_t packets = 0;
+    asio::read(client, asio::buffer(&packets, sizeof(packets)));
+    EXPECT_EQ(packets, 2u);
+}
+
+namespace {
+
+// Blocking read of one order-entry message
+std::string readEntryMessage(asio::ip::tcp::socket& socket) {
+    std::string message(OrderEntry::kHeaderSize, '\0');
+    asio::read(socket, asio::buffer(&message[0], message.size()));
+    OrderEntry::Header header = OrderEntry::decodeHeader(message.data());
+    message.resize(header.length);
+    asio::read(socket, asio::buffer(&message[OrderEntry::kHeaderSize], header.length - OrderEntry::kHeaderSize));
+    return message;
+}
+
+} // namespace
+
+TEST(OrderGateway, PipelinedOrderEntryWithFills) {
+    MatchingEngine me(quietConfig());
+    OrderGateway gateway(me, 0);
+
+    asio::io_context io;
+    asio::ip::tcp::socket maker(io), taker(io);
+    maker.connect({asio::ip::make_address("127.0.0.1"), gateway.port()});
+    taker.connect({asio::ip::make_address("127.0.0.1"), gateway.port()});
+
+    // Two orders and an in-place amend, pipelined in one write
+    std::string out;
+    OrderEntry::encodeNewOrder(out, 1, Order{"s1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 2.0, 0.0, 0});
+    OrderEntry::encodeNewOrder(out, 2, Order{"s2", "BTC-USDT", Side::SELL, OrderType::LIMIT, 102.0, 0.0, 1.0, 0.0, 0});
+    OrderEntry::encodeAmend(out, 3, OrderEntry::Amend{"s1", 0.0, 1.5});
+    asio::write(maker, asio::buffer(out));
+
+    OrderEntry::Ack ack;
+    for (uint32_t seq = 1; seq <= 3; ++seq) {
+        std::string message = readEntryMessage(maker);
+        OrderEntry::Header header = OrderEntry::decodeHeader(message.data());
+        ASSERT_EQ(header.type, OrderEntry::ACK);
+        EXPECT_EQ(header.seq, seq);
+        OrderEntry::decodeAck(message.data(), ack);
+        EXPECT_EQ(ack.refSeq, seq);
+        EXPECT_EQ(ack.result, static_cast<uint8_t>(OrderResult::ACCEPTED));
+    }
+    EXPECT_EQ(ack.orderId, "s1");
+    EXPECT_DOUBLE_EQ(ack.leavesQty, 1.5);
+
+    // The taker gets its ack then its fill; the maker gets its fill unsolicited
+    out.clear();
+    OrderEntry::encodeNewOrder(out, 1, Order{"b1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, 0});
+    OrderEntry::encodeCancel(out, 2, "s2");   // not the taker's order
+    OrderEntry::encodeCancel(out, 2, "b1");   // stale seq
+    asio::write(taker, asio::buffer(out));
+
+    std::string message = readEntryMessage(taker);
+    OrderEntry::decodeAck(message.data(), ack);
+    EXPECT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::ACK);
+    EXPECT_EQ(ack.result, static_cast<uint8_t>(OrderResult::COMPLETELY_FILLED));
+    OrderEntry::Fill fill;
+    message = readEntryMessage(taker);
+    ASSERT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::FILL);
+    OrderEntry::decodeFill(message.data(), fill);
+    EXPECT_TRUE(fill.taker);
+    EXPECT_EQ(fill.orderId, "b1");
+    EXPECT_DOUBLE_EQ(fill.leavesQty, 0.0);
+    message = readEntryMessage(taker);
+    OrderEntry::decodeAck(message.data(), ack);
+    EXPECT_EQ(ack.result, static_cast<uint8_t>(OrderResult::REJECTED_UNKNOWN_ORDER));
+    message = readEntryMessage(taker);
+    OrderEntry::decodeAck(message.data(), ack);
+    EXPECT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::REJECT);
+    EXPECT_EQ(ack.result, OrderEntry::BAD_SEQUENCE);
+
+    message = readEntryMessage(maker);
+    ASSERT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::FILL);
+    EXPECT_EQ(OrderEntry::decodeHeader(message.data()).seq, 4u);
+    OrderEntry::decodeFill(message.data(), fill);
+    EXPECT_FALSE(fill.taker);
+    EXPECT_EQ(fill.orderId, "s1");
+    EXPECT_EQ(fill.side, Side::SELL);
+    EXPECT_DOUBLE_EQ(fill.quantity, 1.0);
+    EXPECT_DOUBLE_EQ(fill.leavesQty, 0.5);
+
+    // The owner can cancel
+    out.clear();
+    OrderEntry::encodeCancel(out, 4, "s2");
+    asio::write(maker, asio::buffer(out));
+    message = readEntryMessage(maker);
+    OrderEntry::decodeAck(message.data(), ack);
+    EXPECT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::ACK);
+    EXPECT_EQ(ack.orderId, "s2");
+    EXPECT_EQ(me.getL2Update("BTC-USDT").asks.size(), 1u);
+
+    // A mass cancel only reaches the sending session's own orders
+    out.clear();
+    OrderEntry::encodeMassCancel(out, 3, OrderEntry::MassCancel{"", OrderEntry::kBothSides});
+    asio::write(taker, asio::buffer(out));
+    message = readEntryMessage(taker);
+    OrderEntry::decodeAck(message.data(), ack);
+    EXPECT_EQ(ack.requestType, OrderEntry::MASS_CANCEL);
+    EXPECT_EQ(ack.count, 0u);
+    out.clear();
+    OrderEntry::encodeMassCancel(out, 5, OrderEntry::MassCancel{"BTC-USDT", 1});
+    asio::write(maker, asio::buffer(out));
+    message = readEntryMessage(maker);
+    OrderEntry::decodeAck(message.data(), ack);
+    EXPECT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::ACK);
+    EXPECT_EQ(ack.count, 1u);
+    EXPECT_TRUE(me.getL2Update("BTC-USDT").asks.empty());
+}
+
+TEST(OrderGateway, CancelOnDisconnectAndHeartbeatTimeout) {
+    MatchingEngine me(quietConfig());
+    OrderGateway gateway(me, 0);
+
+    auto bookSize = [&]() {
+        auto book = me.getL2Update("BTC-USDT");
+        return book.bids.size() + book.asks.size();
+    };
+    auto waitForBookSize = [&](size_t size) {
+        for (int i = 0; i < 1000 && bookSize() != size; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return bookSize();
+    };
+
+    asio::io_context io;
+    asio::ip::tcp::socket plain(io), guarded(io), quiet(io);
+    for (auto* socket : {&plain, &guarded, &quiet}) {
+        socket->connect({asio::ip::make_address("127.0.0.1"), gateway.port()});
+    }
+
+    // plain keeps the default; guarded opts in; quiet also has a 50 ms heartbeat
+    std::string out;
+    OrderEntry::encodeNewOrder(out, 1, Order{"p1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 105.0, 0.0, 1.0, 0.0, 0});
+    asio::write(plain, asio::buffer(out));
+    out.clear();
+    OrderEntry::encodeSessionOptions(out, 1, OrderEntry::SessionOptions{true, 0});
+    OrderEntry::encodeNewOrder(out, 2, Order{"g1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, 0});
+    OrderEntry::encodeNewOrder(out, 3, Order{"g2", "BTC-USDT", Side::BUY, OrderType::LIMIT, 99.0, 0.0, 1.0, 0.0, 0});
+    asio::write(guarded, asio::buffer(out));
+    out.clear();
+    OrderEntry::encodeSessionOptions(out, 1, OrderEntry::SessionOptions{true, 50});
+    OrderEntry::encodeHeartbeat(out, 2);
+    OrderEntry::encodeNewOrder(out, 3, Order{"q1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 98.0, 0.0, 1.0, 0.0, 0});
+    asio::write(quiet, asio::buffer(out));
+
+    OrderEntry::Ack ack;
+    readEntryMessage(plain);
+    for (int i = 0; i < 3; ++i) readEntryMessage(guarded);
+    OrderEntry::decodeAck(readEntryMessage(quiet).data(), ack);
+    EXPECT_EQ(ack.requestType, OrderEntry::SESSION_OPTIONS);
+    OrderEntry::decodeAck(readEntryMessage(quiet).data(), ack);
+    EXPECT_EQ(ack.requestType, OrderEntry::HEARTBEAT);
+    readEntryMessage(quiet);
+    EXPECT_EQ(bookSize(), 4u);
+
+    // Silence past the heartbeat: the gateway pulls q1 and hangs up
+    EXPECT_EQ(waitForBookSize(3), 3u);
+    char byte;
+    asio::error_code ec;
+    quiet.read_some(asio::buffer(&byte, 1), ec);
+    EXPECT_EQ(ec, asio::error::eof);
+
+    // Disconnecting pulls g1 and g2 in one go; p1's session did not opt in
+    guarded.close();
+    EXPECT_EQ(waitForBookSize(1), 1u);
+    plain.close();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(bookSize(), 1u);
+}
+
+namespace {
+
+// Next reply on a shared-memory session, copied out of the ring
+std::string readShmMessage(ShmTransport::Client& client) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    const char* p;
+    while ((p = client.poll()) == nullptr) {
+        if (std::chrono::steady_clock::now() > deadline) return {};
+        std::this_thread::yield();
+    }
+    std::string message(p, OrderEntry::decodeHeader(p).length);
+    client.pop();
+    return message;
+}
+
+} // namespace
+
+TEST(ShmGateway, RegistersAndTradesOverSharedMemory) {
+    MatchingEngine me(quietConfig());
+    ShmGatewayConfig shmConfig;
+    shmConfig.name = "me_test_" + std::to_string(getpid());
+    shmConfig.idleSpins = 100;
+    auto gateway = std::make_unique<ShmGateway>(me, shmConfig);
+
+    ShmTransport::Client maker(shmConfig.name, 64);
+    auto taker = std::make_unique<ShmTransport::Client>(shmConfig.name, 64);
+    EXPECT_EQ(gateway->sessionCount(), 2u);
+    EXPECT_TRUE(maker.engineAlive());
+
+    // Pipelined: both requests are in the ring before the engine sees either
+    std::string out;
+    OrderEntry::encodeNewOrder(out, 1, Order{"m1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 2.0, 0.0, 0});
+    ASSERT_TRUE(maker.send(out));
+    out.clear();
+    OrderEntry::encodeAmend(out, 2, OrderEntry::Amend{"m1", 0.0, 1.5});
+    ASSERT_TRUE(maker.send(out));
+    OrderEntry::Ack ack;
+    for (uint32_t seq = 1; seq <= 2; ++seq) {
+        std::string message = readShmMessage(maker);
+        ASSERT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::ACK);
+        OrderEntry::decodeAck(message.data(), ack);
+        EXPECT_EQ(ack.refSeq, seq);
+        EXPECT_EQ(ack.result, static_cast<uint8_t>(OrderResult::ACCEPTED));
+    }
+    EXPECT_DOUBLE_EQ(ack.leavesQty, 1.5);
+
+    // The taker gets its ack then its fill; the maker gets its fill unsolicited
+    out.clear();
+    OrderEntry::encodeNewOrder(out, 1, Order{"t1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, 0});
+    OrderEntry::encodeCancel(out, 2, "m1");   // not the taker's order
+    ASSERT_TRUE(taker->send(out.data(), OrderEntry::kNewOrderSize));
+    ASSERT_TRUE(taker->send(out.data() + OrderEntry::kNewOrderSize, OrderEntry::kCancelSize));
+    std::string message = readShmMessage(*taker);
+    OrderEntry::decodeAck(message.data(), ack);
+    EXPECT_EQ(ack.result, static_cast<uint8_t>(OrderResult::COMPLETELY_FILLED));
+    OrderEntry::Fill fill;
+    message = readShmMessage(*taker);
+    ASSERT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::FILL);
+    OrderEntry::decodeFill(message.data(), fill);
+    EXPECT_TRUE(fill.taker);
+    message = readShmMessage(*taker);
+    OrderEntry::decodeAck(message.data(), ack);
+    EXPECT_EQ(ack.result, static_cast<uint8_t>(OrderResult::REJECTED_UNKNOWN_ORDER));
+
+    message = readShmMessage(maker);
+    ASSERT_EQ(OrderEntry::decodeHeader(message.data()).type, OrderEntry::FILL);
+    OrderEntry::decodeFill(message.data(), fill);
+    EXPECT_FALSE(fill.taker);
+    EXPECT_EQ(fill.orderId, "m1");
+    EXPECT_DOUBLE_EQ(fill.leavesQty, 0.5);
+
+    // A client that closes frees its slot; the engine going away closes the rest
+    taker.reset();
+    for (int i = 0; i < 500 && gateway->sessionCount() != 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(gateway->sessionCount(), 1u);
+    EXPECT_TRUE(maker.connected());
+    gateway.reset();
+    EXPECT_FALSE(maker.connected());
+    EXPECT_THROW(ShmTransport::Client(shmConfig.name, 64), std::runtime_error);
+}
+
+namespace {
+
+// Just enough of a WebSocket client for the tests: text frames out (masked with a
+// zero key), unfragmented frames in
+class WsClient {
+public:
+    WsClient(asio::io_context& io, uint16_t port, const std::string& path) : socket_(io) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            asio::error_code ec;
+            socket_.connect({asio::ip::make_address("127.0.0.1"), port}, ec);
+            if (!ec) break;
+            socket_.close();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        asio::write(socket_, asio::buffer("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n"
+                                          "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                                          "Sec-WebSocket-Version: 13\r\n\r\n"));
+        size_t end;
+        while ((end = buffer_.find("\r\n\r\n")) == std::string::npos) fill();
+        buffer_.erase(0, end + 4);
+    }
+
+    void send(const std::string& text) {
+        std::string frame{'\x81'};
+        if (text.size() < 126) {
+            frame.push_back(static_cast<char>(0x80 | text.size()));
+        } else {
+            frame.push_back(static_cast<char>(0x80 | 126));
+            frame.push_back(static_cast<char>(text.size() >> 8));
+            frame.push_back(static_cast<char>(text.size() & 0xff));
+        }
+        frame.append(4, '\0');
+        asio::write(socket_, asio::buffer(frame + text));
+    }
+
+    // Payload of the next frame; opcode gets its type (1 text, 2 binary, 8 close)
+    std::string receiveFrame(int* opcode = nullptr) {
+        std::string head = take(2);
+        if (opcode) *opcode = static_cast<unsigned char>(head[0]) & 0x0f;
+        size_t length = static_cast<unsigned char>(head[1]) & 0x7f;
+        if (length == 126) {
+            std::string ext = take(2);
+            length = (static_cast<unsigned char>(ext[0]) << 8) | static_cast<unsigned char>(ext[1]);
+        }
+        return take(length);
+    }
+
+    nlohmann::json receive() { return nlohmann::json::parse(receiveFrame()); }
+
+private:
+    void fill() {
+        char chunk[4096];
+        buffer_.append(chunk, socket_.read_some(asio::buffer(chunk)));
+    }
+    std::string take(size_t n) {
+        while (buffer_.size() < n) fill();
+        std::string out = buffer_.substr(0, n);
+        buffer_.erase(0, n);
+        return out;
+    }
+
+    asio::ip::tcp::socket socket_;
+    std::string buffer_;
+};
+
+// GET path on a fresh connection and parse the JSON body
+nlohmann::json httpGet(asio::io_context& io, uint16_t port, const std::string& path) {
+    asio::ip::tcp::socket socket(io);
+    socket.connect({asio::ip::make_address("127.0.0.1"), port});
+    asio::write(socket, asio::buffer("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n"
+                                     "Connection: close\r\n\r\n"));
+    std::string response;
+    char chunk[4096];
+    asio::error_code ec;
+    while (size_t n = socket.read_some(asio::buffer(chunk), ec)) response.append(chunk, n);
+    return nlohmann::json::parse(response.substr(response.find("\r\n\r\n") + 4));
+}
+
+} // namespace
+
+TEST(MarketDataServer, OrderSessionPipelinesRequestsAndStreamsFills) {
+    MatchingEngine me(quietConfig());
+    MarketDataServer server(me, 0);
+    std::thread serverThread([&]() { server.run(); });
+
+    asio::io_context io;
+    WsClient maker(io, server.port(), "/ws/orders");
+    WsClient taker(io, server.port(), "/ws/orders");
+
+    // Two orders and an amend, sent without waiting; acks come back in order with their req_id
+    maker.send(R"({"op":"new","req_id":1,"order_id":"s1","symbol":"BTC-USDT","side":"sell","order_type":"limit","quantity":2,"price":101})");
+    maker.send(R"({"op":"new","req_id":"two","order_id":"s2","symbol":"BTC-USDT","side":"sell","order_type":"limit","quantity":1,"price":102})");
+    maker.send(R"({"op":"amend","req_id":3,"order_id":"s1","quantity":1.5})");
+    auto ack = maker.receive();
+    EXPECT_EQ(ack["type"], "ack");
+    EXPECT_EQ(ack["req_id"], 1);
+    EXPECT_EQ(ack["status"], "accepted");
+    EXPECT_EQ(maker.receive()["req_id"], "two");
+    ack = maker.receive();
+    EXPECT_EQ(ack["req_id"], 3);
+    EXPECT_EQ(ack["op"], "amend");
+    EXPECT_EQ(ack["status"], "accepted");
+    EXPECT_EQ(ack["leaves_quantity"], "1.5");
+
+    // The taker gets its ack then its fill; the maker gets its fill unsolicited
+    taker.send(R"({"op":"new","req_id":7,"order_id":"b1","symbol":"BTC-USDT","side":"buy","order_type":"limit","quantity":1,"price":101})");
+    ack = taker.receive();
+    EXPECT_EQ(ack["req_id"], 7);
+    EXPECT_EQ(ack["status"], "filled");
+    auto fill = taker.receive();
+    EXPECT_EQ(fill["type"], "fill");
+    EXPECT_EQ(fill["order_id"], "b1");
+    EXPECT_EQ(fill["liquidity"], "taker");
+    EXPECT_EQ(fill["leaves_quantity"], "0");
+    taker.send(R"({"op":"cancel","req_id":8,"order_id":"s2"})");   // not the taker's order
+    EXPECT_EQ(taker.receive()["status"], "rejected_unknown_order");
+
+    fill = maker.receive();
+    EXPECT_EQ(fill["type"], "fill");
+    EXPECT_EQ(fill["order_id"], "s1");
+    EXPECT_EQ(fill["side"], "sell");
+    EXPECT_EQ(fill["liquidity"], "maker");
+    EXPECT_EQ(fill["leaves_quantity"], "0.5");
+
+    // Bad requests are answered with the req_id and where parsing stopped
+    maker.send(R"({"op":"cancel","req_id":"c"})");
+    auto error = maker.receive();
+    EXPECT_EQ(error["type"], "error");
+    EXPECT_EQ(error["req_id"], "c");
+    EXPECT_EQ(error["error"], "missing \"order_id\"");
+    EXPECT_EQ(error["offset"], "27");
+
+    // The owner can cancel
+    maker.send(R"({"op":"cancel","req_id":9,"order_id":"s2"})");
+    ack = maker.receive();
+    EXPECT_EQ(ack["req_id"], 9);
+    EXPECT_EQ(ack["status"], "canceled");
+    EXPECT_EQ(me.getL2Update("BTC-USDT").asks.size(), 1u);
+
+    // A session that asked for cancel-on-disconnect and goes quiet past its heartbeat
+    // is closed, and its orders are pulled
+    WsClient quiet(io, server.port(), "/ws/orders?cancel_on_disconnect=true&heartbeat_ms=50");
+    quiet.send(R"({"op":"new","req_id":1,"order_id":"q1","symbol":"BTC-USDT","side":"buy","order_type":"limit","quantity":1,"price":99})");
+    EXPECT_EQ(quiet.receive()["status"], "accepted");
+    quiet.send(R"({"op":"heartbeat","req_id":2})");
+    EXPECT_EQ(quiet.receive()["type"], "heartbeat");
+    for (int i = 0; i < 1000 && !me.getL2Update("BTC-USDT").bids.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_TRUE(me.getL2Update("BTC-USDT").bids.empty());
+    EXPECT_EQ(me.getL2Update("BTC-USDT").asks.size(), 1u);   // s1 stays: its session did not opt in
+
+    server.stop();
+    serverThread.join();
+}
+
+TEST(MarketDataServer, FiredStopTradingWithAnotherSessionFillsBoth) {
+    MatchingEngine me(quietConfig());
+    MarketDataServer server(me, 0);
+    std::thread serverThread([&]() { server.run(); });
+
+    asio::io_context io;
+    WsClient maker(io, server.port(), "/ws/orders");
+    WsClient stopper(io, server.port(), "/ws/orders");
+    maker.send(R"({"op":"new","req_id":1,"order_id":"m1","symbol":"BTC-USDT","side":"sell","order_type":"limit","quantity":2,"price":101})");
+    EXPECT_EQ(maker.receive()["status"], "accepted");
+    stopper.send(R"({"op":"new","req_id":1,"order_id":"st1","symbol":"BTC-USDT","side":"buy","order_type":"stop_loss","quantity":1,"stop_price":100})");
+    EXPECT_EQ(stopper.receive()["status"], "accepted");
+
+    // A trade at 100 fires the stop, which buys from the maker session's order at 101
+    Order ask{"a1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 100.0, 0.0, 1.0, 0.0, Order::now()};
+    Order taker{"t1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 100.0, 0.0, 1.0, 0.0, Order::now()};
+    me.submitOrder(ask);
+    EXPECT_EQ(me.submitOrder(taker).result, OrderResult::COMPLETELY_FILLED);
+
+    auto fill = maker.receive();
+    EXPECT_EQ(fill["type"], "fill");
+    EXPECT_EQ(fill["order_id"], "m1");
+    EXPECT_EQ(fill["liquidity"], "maker");
+    EXPECT_EQ(fill["leaves_quantity"], "1");
+    fill = stopper.receive();
+    EXPECT_EQ(fill["type"], "fill");
+    EXPECT_EQ(fill["order_id"], "st1");
+    EXPECT_EQ(fill["liquidity"], "taker");
+    EXPECT_EQ(fill["price"], "101");
+    EXPECT_EQ(fill["leaves_quantity"], "0");
+
+    // Filled completely: the stop's session no longer owns it, the maker still owns the rest
+    stopper.send(R"({"op":"cancel","req_id":2,"order_id":"st1"})");
+    EXPECT_EQ(stopper.receive()["status"], "rejected_unknown_order");
+    maker.send(R"({"op":"cancel","req_id":2,"order_id":"m1"})");
+    auto ack = maker.receive();
+    EXPECT_EQ(ack["status"], "canceled");
+    EXPECT_EQ(ack["filled_quantity"], "1");
+
+    server.stop();
+    serverThread.join();
+}
+
+TEST(MarketDataServer, FiredStopThatCannotRestIsReportedToItsOwner) {
+    MatchingEngine me(quietConfig());
+    MarketDataServer server(me, 0);
+    std::thread serverThread([&]() { server.run(); });
+
+    Order ask1{"a1", "BTC-USDT", Side::SELL, OrderType::LIMIT, 100.0, 0.0, 1.0, 0.0, Order::now()};
+    Order ask2{"a2", "BTC-USDT", Side::SELL, OrderType::LIMIT, 101.0, 0.0, 1.0, 0.0, Order::now()};
+    me.submitOrder(ask1);
+    me.submitOrder(ask2);
+
+    asio::io_context io;
+    WsClient session(io, server.port(), "/ws/orders");
+    session.send(R"({"op":"new","req_id":1,"order_id":"st1","symbol":"BTC-USDT","side":"buy","order_type":"stop_limit","quantity":1,"price":102,"stop_price":100})");
+    EXPECT_EQ(session.receive()["status"], "accepted");
+
+    // A trade at 100 fires it as a buy at 102 while the best ask is 101: it would
+    // trade through, so it is rejected without ever resting or filling
+    Order taker{"t1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 100.0, 0.0, 1.0, 0.0, Order::now()};
+    EXPECT_EQ(me.submitOrder(taker).result, OrderResult::COMPLETELY_FILLED);
+    auto ack = session.receive();
+    EXPECT_EQ(ack["type"], "ack");
+    EXPECT_FALSE(ack.contains("req_id"));
+    EXPECT_EQ(ack["op"], "trigger");
+    EXPECT_EQ(ack["order_id"], "st1");
+    EXPECT_EQ(ack["status"], "rejected_trade_through");
+    EXPECT_EQ(ack["filled_quantity"], "0");
+
+    // The session no longer owns it
+    session.send(R"({"op":"cancel","req_id":2,"order_id":"st1"})");
+    EXPECT_EQ(session.receive()["status"], "rejected_unknown_order");
+
+    server.stop();
+    serverThread.join();
+}
+
+TEST(MarketDataServer, UnsubscribedSymbolsAreNotDelivered) {
+    MatchingEngine me(quietConfig());
+    MarketDataServer server(me, 0);
+    std::thread serverThread([&]() { server.run(); });
+    auto submit = [&](const std::string& id, const std::string& symbol, Side side, double price) {
+        me.submitOrder(Order{id, symbol, side, OrderType::LIMIT, price, 0.0, 1.0, 0.0, Order::now()});
+    };
+
+    asio::io_context io;
+    WsClient book(io, server.port(), "/ws/orderbook");
+    book.send(R"({"op":"subscribe","symbols":["BTC-USDT","ETH-USDT"]})");
+    EXPECT_EQ(book.receive()["type"], "subscribed");
+    EXPECT_EQ(book.receive()["symbol"], "BTC-USDT");   // one snapshot per symbol, in request order
+    EXPECT_EQ(book.receive()["symbol"], "ETH-USDT");
+    book.send(R"({"op":"unsubscribe","symbols":["ETH-USDT"]})");
+    EXPECT_EQ(book.receive()["type"], "unsubscribed");
+
+    WsClient trades(io, server.port(), "/ws/trades");
+    trades.send(R"({"op":"subscribe","symbols":["BTC-USDT"]})");
+    EXPECT_EQ(trades.receive()["type"], "subscribed");
+
+    // ETH trades first: had any of it been delivered it would arrive ahead of BTC
+    submit("e1", "ETH-USDT", Side::SELL, 3000.0);
+    submit("e2", "ETH-USDT", Side::BUY, 3000.0);
+    submit("b1", "BTC-USDT", Side::SELL, 46000.0);
+    submit("b2", "BTC-USDT", Side::BUY, 46000.0);
+    auto delta = book.receive();
+    EXPECT_EQ(delta["type"], "l2_delta");
+    EXPECT_EQ(delta["symbol"], "BTC-USDT");
+    auto batch = trades.receive();
+    EXPECT_EQ(batch["type"], "trades");
+    EXPECT_EQ(batch["symbol"], "BTC-USDT");
+    EXPECT_EQ(batch["taker_order_id"], "b2");
+
+    server.stop();
+    serverThread.join();
+}
+
+TEST(MarketDataServer, ConflatedSubscriberGetsOneMergedDeltaPerInterval) {
+    MatchingEngine me(quietConfig());
+    MarketDataServer server(me, 0);
+    std::thread serverThread([&]() { server.run(); });
+    auto bid = [&](const std::string& id, double price) {
+        me.submitOrder(Order{id, "BTC-USDT", Side::BUY, OrderType::LIMIT, price, 0.0, 1.0, 0.0, Order::now()});
+    };
+
+    asio::io_context io;
+    WsClient book(io, server.port(), "/ws/orderbook");
+    book.send(R"({"op":"subscribe","symbols":["BTC-USDT"],"interval_ms":300})");
+    EXPECT_EQ(book.receive()["interval_ms"], 300);
+    auto snapshot = book.receive();
+    ASSERT_EQ(snapshot["type"], "l2_snapshot");
+    uint64_t seq = std::stoull(snapshot["seq"].get<std::string>());
+
+    // Three deltas inside one interval, two on the same level: one frame with the
+    // latest size per level and the folded seq range
+    bid("b1", 100.0);
+    bid("b2", 99.0);
+    bid("b3", 100.0);
+    auto merged = book.receive();
+    auto mergedAt = std::chrono::steady_clock::now();
+    EXPECT_EQ(merged["type"], "l2_delta");
+    EXPECT_EQ(merged["first_seq"], std::to_string(seq + 1));
+    EXPECT_EQ(merged["seq"], std::to_string(seq + 3));
+    ASSERT_EQ(merged["changes"].size(), 2u);
+    EXPECT_EQ(merged["changes"][0]["price"], "99");
+    EXPECT_EQ(merged["changes"][0]["quantity"], "1");
+    EXPECT_EQ(merged["changes"][1]["price"], "100");
+    EXPECT_EQ(merged["changes"][1]["quantity"], "2");
+
+    // The next delta waits for the next interval
+    bid("b4", 98.0);
+    auto next = book.receive();
+    EXPECT_GE(std::chrono::steady_clock::now() - mergedAt, std::chrono::milliseconds(200));
+    EXPECT_EQ(next["first_seq"], std::to_string(seq + 4));
+    EXPECT_EQ(next["seq"], std::to_string(seq + 4));
+    ASSERT_EQ(next["changes"].size(), 1u);
+    EXPECT_EQ(next["changes"][0]["price"], "98");
+
+    server.stop();
+    serverThread.join();
+}
+
+TEST(MarketDataServer, ResyncRecoversTheBookAfterLostDeltas) {
+    MatchingEngine me(quietConfig());
+    auto submit = [&](const std::string& id, Side side, double price, double quantity) {
+        me.submitOrder(Order{id, "BTC-USDT", side, OrderType::LIMIT, price, 0.0, quantity, 0.0, Order::now()});
+    };
+    // History from before the server attached: its cache is seeded from the engine later
+    submit("a1", Side::SELL, 101.0, 1.0);
+    submit("b1", Side::BUY, 99.0, 1.0);
+    MarketDataServer server(me, 0);
+    std::thread serverThread([&]() { server.run(); });
+
+    // Client-side book: (side, price) -> quantity
+    std::map<std::pair<std::string, double>, double> levels;
+    uint64_t seq = 0;
+    auto applySnapshot = [&](const nlohmann::json& snapshot) {
+        levels.clear();
+        for (const char* side : {"bids", "asks"}) {
+            for (const auto& level : snapshot[side]) {
+                levels[{side, std::stod(level[0].get<std::string>())}] = std::stod(level[1].get<std::string>());
+            }
+        }
+        seq = std::stoull(snapshot["seq"].get<std::string>());
+    };
+    auto applyDelta = [&](const nlohmann::json& delta) {
+        for (const auto& change : delta["changes"]) {
+            std::pair<std::string, double> key{change["side"] == "bid" ? "bids" : "asks",
+                                               std::stod(change["price"].get<std::string>())};
+            double quantity = std::stod(change["quantity"].get<std::string>());
+            if (quantity > 0) levels[key] = quantity;
+            else levels.erase(key);
+        }
+        seq = std::stoull(delta["seq"].get<std::string>());
+    };
+
+    asio::io_context io;
+    WsClient book(io, server.port(), "/ws/orderbook");
+    book.send(R"({"op":"subscribe","symbols":["BTC-USDT"]})");
+    EXPECT_EQ(book.receive()["type"], "subscribed");
+    applySnapshot(book.receive());
+
+    // Three deltas are lost; the next one no longer follows the client's seq
+    submit("b2", Side::BUY, 98.0, 2.0);
+    submit("a2", Side::SELL, 102.0, 1.0);
+    submit("t1", Side::BUY, 101.0, 0.5);
+    for (int i = 0; i < 3; ++i) EXPECT_EQ(book.receive()["type"], "l2_delta");
+    submit("b3", Side::BUY, 97.0, 1.0);
+    auto delta = book.receive();
+    uint64_t latest = std::stoull(delta["seq"].get<std::string>());
+    EXPECT_NE(latest, seq + 1);
+
+    // A fresh snapshot at the latest seq, then deltas that follow it
+    book.send(R"({"op":"resync","symbols":["BTC-USDT"]})");
+    auto snapshot = book.receive();
+    ASSERT_EQ(snapshot["type"], "l2_snapshot");
+    applySnapshot(snapshot);
+    EXPECT_EQ(seq, latest);
+    submit("a3", Side::SELL, 103.0, 1.0);
+    submit("t2", Side::SELL, 99.0, 1.0);
+    for (int i = 0; i < 2; ++i) {
+        delta = book.receive();
+        ASSERT_EQ(delta["type"], "l2_delta");
+        EXPECT_EQ(std::stoull(delta["first_seq"].get<std::string>()), seq + 1);
+        applyDelta(delta);
+    }
+
+    std::map<std::pair<std::string, double>, double> engineLevels;
+    L2Update engineBook = me.getL2Update("BTC-USDT", std::numeric_limits<int>::max());
+    for (const auto& [price, quantity] : engineBook.bids) engineLevels[{"bids", price}] = quantity;
+    for (const auto& [price, quantity] : engineBook.asks) engineLevels[{"asks", price}] = quantity;
+    EXPECT_EQ(levels, engineLevels);
+    EXPECT_EQ(seq, engineBook.seq);
+
+    server.stop();
+    serverThread.join();
+}
+
+TEST(MarketDataServer, SlowConsumerPoliciesReportGapsAndCounters) {
+    struct Case {
+        const char* policy;
+        bool binary;
+    };
+    for (const Case& c : {Case{"conflate", false}, Case{"drop", false}, Case{"drop", true},
+                          Case{"disconnect", false}}) {
+        SCOPED_TRACE(std::string(c.policy) + (c.binary ? " binary" : " json"));
+        MatchingEngine me(quietConfig());
+        MarketDataConfig config;
+        config.maxQueueDepth = 2;
+        MarketDataServer server(me, 0, config);
+        std::thread serverThread([&]() { server.run(); });
+        Order bid{"b1", "BTC-USDT", Side::BUY, OrderType::LIMIT, 100.0, 0.0, 1.0, 0.0, Order::now()};
+        me.submitOrder(bid);
+
+        asio::io_context io;
+        WsClient client(io, server.port(), "/ws/orderbook");
+        client.send(std::string(R"({"op":"slow_consumer","policy":")") + c.policy + "\"}");
+        EXPECT_EQ(client.receive()["policy"], c.policy);
+        if (c.binary) {
+            client.send(R"({"op":"encoding","format":"binary"})");
+            EXPECT_EQ(client.receive()["type"], "encoding_ack");
+        }
+        client.send(R"({"op":"subscribe","symbols":["BTC-USDT"]})");
+        EXPECT_EQ(client.receive()["type"], "subscribed");
+        int opcode = 0;
+        client.receiveFrame(&opcode);   // the subscription's snapshot
+        EXPECT_EQ(opcode, c.binary ? 2 : 1);
+
+        // Five snapshots queued under one lock: two fit, the third finds the queue full.
+        // Snapshots cannot be folded, so CONFLATE drops them like DROP.
+        client.send(R"({"op":"resync","symbols":["BTC-USDT","BTC-USDT","BTC-USDT","BTC-USDT","BTC-USDT"]})");
+        bool disconnect = std::string(c.policy) == "disconnect";
+        if (disconnect) {
+            std::string close = client.receiveFrame(&opcode);   // queued snapshots are discarded
+            EXPECT_EQ(opcode, 8);
+            ASSERT_GE(close.size(), 2u);
+            EXPECT_EQ((static_cast<unsigned char>(close[0]) << 8) | static_cast<unsigned char>(close[1]), 1008);
+        } else {
+            for (int i = 0; i < 2; ++i) {
+                client.receiveFrame(&opcode);
+                EXPECT_EQ(opcode, c.binary ? 2 : 1);
+            }
+            std::string gap = client.receiveFrame(&opcode);
+            if (c.binary) {
+                EXPECT_EQ(opcode, 2);
+                uint64_t dropped = 0;
+                ASSERT_TRUE(BinaryCodec::decodeGap(gap.data(), gap.size(), dropped));
+                EXPECT_EQ(dropped, 3u);
+            } else {
+                auto marker = nlohmann::json::parse(gap);
+                EXPECT_EQ(marker["type"], "gap");
+                EXPECT_EQ(marker["dropped"], "3");
+            }
+        }
+
+        auto stats = httpGet(io, server.port(), "/marketdata/clients");
+        EXPECT_EQ(stats["queue_limit"], 2);
+        ASSERT_EQ(stats["clients"].size(), 1u);
+        const auto& queue = stats["clients"][0];
+        EXPECT_EQ(queue["feed"], "orderbook");
+        EXPECT_EQ(queue["policy"], c.policy);
+        // The acks went through the queue too: slow_consumer_ack, encoding_ack, subscribed
+        int acks = c.binary ? 3 : 2;
+        EXPECT_EQ(queue["enqueued"], acks + 3);
+        EXPECT_EQ(queue["max_queue_depth"], 2);
+        EXPECT_EQ(queue["conflated"], 0);
+        EXPECT_EQ(queue["sent"], acks + (disconnect ? 1 : 3));
+        EXPECT_EQ(queue["dropped"], disconnect ? 1 : 3);
+        EXPECT_EQ(queue["closing"], disconnect);
+
+        server.stop();
+        serverThread.join();
+    }
+}
+
+TEST(FixProtocol, ParsesInPlaceAndMapsToOrder) {
+    Fix::MessageWriter writer;
+    writer.begin("D", "CLIENT", "ENGINE", 7, 0);
+    writer.add(Fix::Tag::ClOrdID, std::string_view("c1"));
+    writer.add(Fix::Tag::Symbol, std::string_view("BTC-USDT"));
+    writer.add(Fix::Tag::Side, '2');
+    writer.add(Fix::Tag::OrderQty, 1.25);
+    writer.add(Fix::Tag::OrdType, '2');
+    writer.add(Fix::Tag::Price, 101.5);
+    writer.add(Fix::Tag::TimeInForce, '3');
+    std::string wire;
+    writer.finish(wire);
+    EXPECT_EQ(wire.compare(wire.size() - 7, 3, "10="), 0);
+
+    Fix::Message message;
+    size_t consumed = 0;
+    EXPECT_EQ(Fix::parse(wire.data(), wire.size() - 1, message, consumed), Fix::ParseStatus::INCOMPLETE);
+    ASSERT_EQ(Fix::parse(wire.data(), wire.size(), message, consumed), Fix::ParseStatus::COMPLETE);
+    EXPECT_EQ(consumed, wire.size());
+    EXPECT_EQ(message.msgType(), "D");
+    EXPECT_EQ(message.seqNum(), 7u);
+    EXPECT_EQ(message.get(Fix::Tag::SendingTime), "19700101-00:00:00.000");
+    // Values are views into the receive buffer
+    std::string_view symbol = message.get(Fix::Tag::Symbol);
+    EXPECT_GE(symbol.data(), wire.data());
+    EXPECT_LT(symbol.data(), wire.data() + wire.size());
+
+    Order order{};
+    ASSERT_EQ(Fix::toOrder(message, order), nullptr);
+    EXPECT_EQ(order.orderId, "c1");
+    EXPECT_EQ(order.symbol, "BTC-USDT");
+    EXPECT_EQ(order.side, Side::SELL);
+    EXPECT_EQ(order.type, OrderType::IOC);
+    EXPECT_DOUBLE_EQ(order.price, 101.5);
+    EXPECT_DOUBLE_EQ(order.quantity, 1.25);
+
+    // A bad checksum is skipped whole; a bad prefix cannot be
+    std::string garbled = wire;
+    garbled[garbled.size() - 2] = garbled[garbled.size() - 2] == '0' ? '1' : '0';
+    EXPECT_EQ(Fix::parse(garbled.data(), garbled.size(), message, consumed), Fix::ParseStatus::GARBLED);
+    EXPECT_EQ(consumed, wire.size());
+    EXPECT_EQ(Fix::parse("8=FIX.4.2\x01", 10, message, consumed), Fix::ParseStatus::BAD_FRAMING);
+}
+
+namespace {
+
+// Blocking FIX initiator for the loopback test
+class FixTestClient {
+public:
+    FixTestClient(asio::io_context& io, uint16_t port, std::string compId)
+        : socket_(io), compId_(std::move(compId)) {
+        socket_.connect({asio::ip::make_address("127.0.0.1"), port});
+    }
+
+    template<typename Body>
+    void send(std::string_view type, Body&& body, uint32_t seq = 0) {
+        writer_.begin(type, compId_, "ENGINE", seq ? seq : ++seq_, Order::now());
+        body(writer_);
+        std::string out;
+        writer_.finish(out);
+        asio::write(socket_, asio::buffer(out));
+    }
+
+    void sendRaw(const std::string& bytes) { asio::write(socket_, asio::buffer(bytes)); }
+
+    // Next inbound message; valid until the next call
+    const Fix::Message& next() {
+        in_.erase(0, used_);
+        used_ = 0;
+        char buffer[4096];
+        for (;;) {
+            Fix::ParseStatus status = Fix::parse(in_.data(), in_.size(), message_, used_);
+            if (status == Fix::ParseStatus::COMPLETE) return message_;
+            EXPECT_EQ(status, Fix::ParseStatus::INCOMPLETE);
+            in_.append(buffer, socket_.read_some(asio::buffer(buffer)));
+        }
+    }
+
+private:
+    asio::ip::tcp::socket socket_;
+    std::string compId_;
+    uint32_t seq_ = 0;
+    Fix::MessageWriter writer_;
+    Fix::Message message_;
+    std::string in_;
+    size_t used_ = 0;
+};
+
+void fixLogon(FixTestClient& client) {
+    client.send("A", [](Fix::MessageWriter& w) {
+        w.add(Fix::Tag::EncryptMethod, 0LL);
+        w.add(Fix::Tag::HeartBtInt, 30LL);
+    });
+    const Fix::Message& reply = client.next();
+    EXPECT_EQ(reply.msgType(), "A");
+    EXPECT_EQ(reply.seqNum(), 1u);
+}
+
+void fixLimitOrder(FixTestClient& client, std::string_view clOrdId, char side, double quantity, double price) {
+    client.send("D", [&](Fix::MessageWriter& w) {
+        w.add(Fix::Tag::ClOrdID, clOrdId);
+        w.add(Fix::Tag::Symbol, std::string_view("BTC-USDT"));
+        w.add(Fix::Tag::Side, side);
+        w.add(Fix::Tag::OrderQty, quantity);
+        w.add(Fix::Tag::OrdType, '2');
+        w.add(Fix::Tag::Price, price);
+    });
+}
+
+void fixCancel(FixTestClient& client, std::string_view clOrdId, std::string_view origClOrdId) {
+    client.send("F", [&](Fix::MessageWriter& w) {
+        w.add(Fix::Tag::OrigClOrdID, origClOrdId);
+        w.add(Fix::Tag::ClOrdID, clOrdId);
+        w.add(Fix::Tag::Symbol, std::string_view("BTC-USDT"));
+        w.add(Fix::Tag::Side, '2');
+    });
+}
+
+} // namespace
+
+TEST(FixGateway, LogonOrderEntryAndExecutionReports) {
+    MatchingEngine me(quietConfig());
+    FixGateway gateway(me, 0);
+
+    asio::io_context io;
+    FixTestClient maker(io, gateway.port(), "MAKER");
+    FixTestClient taker(io, gateway.port(), "TAKER");
+    fixLogon(maker);
+    fixLogon(taker);
+
+    fixLimitOrder(maker, "s1", '2', 2.0, 101.0);
+    const Fix::Message* report = &maker.next();
+    ASSERT_EQ(report->msgType(), "8");
+    EXPECT_EQ(report->get(Fix::Tag::OrderID), "MAKER:s1");
+    EXPECT_EQ(report->getChar(Fix::Tag::ExecType), '0');
+
+    // Size down under a new ClOrdID
+    maker.send("G", [](Fix::MessageWriter& w) {
+        w.add(Fix::Tag::OrigClOrdID, std::string_view("s1"));
+        w.add(Fix::Tag::ClOrdID, std::string_view("s1b"));
+        w.add(Fix::Tag::Symbol, std::string_view("BTC-USDT"));
+        w.add(Fix::Tag::Side, '2');
+        w.add(Fix::Tag::OrderQty, 1.5);
+        w.add(Fix::Tag::OrdType, '2');
+    });
+    report = &maker.next();
+    EXPECT_EQ(report->getChar(Fix::Tag::ExecType), '5');
+    EXPECT_EQ(report->get(Fix::Tag::OrigClOrdID), "s1");
+    EXPECT_EQ(report->get(Fix::Tag::LeavesQty), "1.5");
+
+    // The taker gets New then its fill; the maker gets its fill unsolicited
+    fixLimitOrder(taker, "b1", '1', 1.0, 101.0);
+    report = &taker.next();
+    EXPECT_EQ(report->getChar(Fix::Tag::ExecType), '0');
+    report = &taker.next();
+    EXPECT_EQ(report->getChar(Fix::Tag::ExecType), 'F');
+    EXPECT_EQ(report->getChar(Fix::Tag::OrdStatus), '2');
+    EXPECT_EQ(report->get(Fix::Tag::LastPx), "101");
+
+    report = &maker.next();
+    EXPECT_EQ(report->getChar(Fix::Tag::ExecType), 'F');
+    EXPECT_EQ(report->getChar(Fix::Tag::OrdStatus), '1');
+    EXPECT_EQ(report->get(Fix::Tag::ClOrdID), "s1b");
+    EXPECT_EQ(report->get(Fix::Tag::LeavesQty), "0.5");
+    EXPECT_EQ(report->get(Fix::Tag::AvgPx), "101");
+
+    // Not the taker's order
+    fixCancel(taker, "x1", "s1b");
+    report = &taker.next();
+    EXPECT_EQ(report->msgType(), "9");
+    EXPECT_EQ(report->getChar(Fix::Tag::CxlRejResponseTo), '1');
+
+    // A garbled message is ignored without using up a sequence number
+    maker.sendRaw("8=FIX.4.4\x01" "9=5\x01" "35=0\x01" "10=000\x01");
+    fixCancel(maker, "c1", "s1b");
+    report = &maker.next();
+    EXPECT_EQ(report->getChar(Fix::Tag::ExecType), '4');
+    EXPECT_EQ(report->get(Fix::Tag::CumQty), "1");
+    EXPECT_TRUE(me.getL2Update("BTC-USDT").asks.empty());
+
+    maker.send("1", [](Fix::MessageWriter& w) { w.add(Fix::Tag::TestReqID, std::string_view("ping")); });
+    report = &maker.next();
+    EXPECT_EQ(report->msgType(), "0");
+    EXPECT_EQ(report->get(Fix::Tag::TestReqID), "ping");
+
+    // A sequence gap ends the session
+    maker.send("0", [](Fix::MessageWriter&) {}, 99);
+    report = &maker.next();
+    EXPECT_EQ(report->msgType(), "5");
+    EXPECT_EQ(report->get(Fix::Tag::Text), "MsgSeqNum too high, expecting 6");
+}